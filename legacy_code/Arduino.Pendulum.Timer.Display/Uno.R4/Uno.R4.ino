@@ -54,6 +54,14 @@
 #include "src/SDLogger.h"
 #include "src/Sensors.h"
 #include "src/StatsEngine.h"
+#include "src/AllanDev.h"
+#include "src/Spectrum.h"
+#include "src/Goertzel.h"
+#include "src/DeviationHist.h"
+#include "src/EnvRegression.h"
+#include "src/Rollups.h"
+#include "src/Disturbance.h"
+#include "src/StatsLog.h"
 #include "src/Display.h"
 #include "src/NanoComm.h"
 #include "src/MemoryMonitor.h"
@@ -79,6 +87,10 @@ void setup() {
     applyUnoConfig(ucfg);
     configLoaded = true;
   }
+  AnalysisConfig acfg = getCurrentAnalysisConfig();
+  if (eepromReady && loadAnalysisConfig(acfg)) {
+    applyAnalysisConfig(acfg);
+  }
   Display::begin();
   Display::showSplash();
   if (!eepromReady) {
@@ -89,22 +101,39 @@ void setup() {
   WiFiConfig::begin();
   HttpServer::begin();
   SDLogger::begin();
+  StatsLog::begin();
   Sensors::begin();
   Sensors::scanI2C();
+#if ENABLE_PSD
+  Spectrum::begin();
+#endif
+#if ENABLE_GOERTZEL
+  Goertzel::begin();
+#endif
+#if ENABLE_ENV_REGRESSION
+  EnvRegression::begin();
+#endif
   NanoComm::readStartup();
 
-  SDLogger::setLogMode(UnoTunables::logDaily ? SDLogger::LogMode::Daily : SDLogger::LogMode::Continuous);
+  SDLogger::setLogMode(SDLogger::logModeFor(UnoTunables::logDaily, UnoTunables::logSizeRotate));
+  SDLogger::setRotateSizeMB(UnoTunables::logRotateMB);
   SDLogger::setFilename(UnoTunables::logBaseName);
   SDLogger::setAppendMode(UnoTunables::logAppend);
+  SDLogger::setLogFormat((SDLogger::LogFormat)UnoTunables::logFormat);
   if (UnoTunables::logEnabled) {
     SDLogger::startLogging(SDLogger::getLogMode(), false);
   }
 }
 
 void loop() {
+  SDLogger::beginLoop();
   WiFiConfig::service();
   HttpServer::service();
   SDLogger::service();
+  StatsLog::service();
+#if ENABLE_PSD
+  Spectrum::service();
+#endif
   MemoryMonitor::poll();
   MemoryMonitor::serviceBlink();
   Sensors::poll();
@@ -120,6 +149,28 @@ void loop() {
       NanoComm::currentSample.humidity_pct = h;
       NanoComm::currentSample.pressure_hPa = p;
       StatsEngine::update();
+#if ENABLE_ADEV
+      AllanDev::update(NanoComm::currentSample);
+#endif
+#if ENABLE_PSD
+      Spectrum::update(NanoComm::currentSample);
+#endif
+#if ENABLE_GOERTZEL
+      Goertzel::update(NanoComm::currentSample);
+#endif
+#if ENABLE_DEV_HIST
+      DeviationHist::update(NanoComm::currentSample);
+#endif
+#if ENABLE_ENV_REGRESSION
+      EnvRegression::update(NanoComm::currentSample);
+#endif
+#if ENABLE_ROLLUPS
+      Rollups::update(NanoComm::currentSample);
+#endif
+#if ENABLE_DISTURBANCE
+      Disturbance::update(NanoComm::currentSample);
+#endif
+      StatsLog::update(NanoComm::currentSample);
       SDLogger::logSample(NanoComm::currentSample);
     }
   }
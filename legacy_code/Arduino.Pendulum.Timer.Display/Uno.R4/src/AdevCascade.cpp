@@ -0,0 +1,114 @@
+#include "AdevCascade.h"
+
+#include <math.h>
+
+// Inputs between re-anchoring the phase to zero mean frequency offset.
+static constexpr uint32_t ADEV_REBASE_EVERY = 4096;
+
+void AdevCascade::reset() {
+  x_ = 0.0;
+  c_ = 0.0;
+  yOffset_ = 0.0;
+  count_ = 0;
+  for (uint8_t k = 0; k < ADEV_LEVELS; ++k) {
+    Level &lv = levels_[k];
+    lv.head = 0;
+    lv.filled = 0;
+    lv.sumA = 0.0;
+    lv.sumH = 0.0;
+    lv.sumM = 0.0;
+    lv.nA = 0;
+    lv.nH = 0;
+    lv.nM = 0;
+    push(lv, 0.0, 0.0);   // x[0], c[0]
+  }
+}
+
+void AdevCascade::push(Level &lv, double x, double c) {
+  lv.head = (uint8_t)((lv.head + 1) % ADEV_RING_LEN);
+  lv.x[lv.head] = x;
+  lv.c[lv.head] = c;
+  if (lv.filled < ADEV_RING_LEN) lv.filled++;
+}
+
+// A frequency offset makes x grow linearly and c quadratically, and drift
+// makes it worse, which eats double precision over a long run. Every
+// ADEV_REBASE_EVERY inputs the history is re-expressed relative to the current
+// point: x loses a + b*d and c loses c_n + a*d + b*d(d+1)/2 (d = i - n), with a
+// the current phase and b the mean residual frequency since the last rebase.
+// Those are polynomials of degree <= 1 in x and <= 2 in c, so every second
+// and third difference above is unchanged.
+void AdevCascade::rebase() {
+  double a = x_;
+  double b = x_ / (double)ADEV_REBASE_EVERY;
+  for (uint8_t k = 0; k < ADEV_LEVELS; ++k) {
+    Level &lv = levels_[k];
+    uint32_t stride = 1UL << strideShift(k);
+    uint32_t age = count_ & (stride - 1);   // inputs since the level's last push
+    for (uint8_t j = 0; j < lv.filled; ++j, age += stride) {
+      uint8_t sl = slot(lv, j);
+      double d = -(double)age;
+      lv.x[sl] -= a + b * d;
+      lv.c[sl] -= c_ + a * d + b * d * (d + 1.0) * 0.5;
+    }
+  }
+  x_ = 0.0;
+  c_ = 0.0;
+  yOffset_ += b;
+}
+
+void AdevCascade::add(double y) {
+  x_ += y - yOffset_;
+  c_ += x_;
+  count_++;
+  for (uint8_t k = 0; k < ADEV_LEVELS; ++k) {
+    uint8_t ss = strideShift(k);
+    if (count_ & ((1UL << ss) - 1)) continue;
+    Level &lv = levels_[k];
+    push(lv, x_, c_);
+    uint8_t lag = (uint8_t)(1u << (k - ss));   // m expressed in ring entries
+    if (lv.filled < 2 * lag + 1) continue;
+    const double *x = lv.x;
+    uint8_t s0 = lv.head, s1 = slot(lv, lag), s2 = slot(lv, 2 * lag);
+    double d2 = x[s0] - 2.0 * x[s1] + x[s2];
+    lv.sumA += d2 * d2;
+    lv.nA++;
+    // The first m-sample average starts at x[0], so on a level evaluated at
+    // every input MDEV's first window completes one input before HDEV's,
+    // with c before the first input being 0.
+    if (lv.filled < 3 * lag + (ss ? 1 : 0)) continue;
+    const double *c = lv.c;
+    double c3 = lv.filled > 3 * lag ? c[slot(lv, 3 * lag)] : 0.0;
+    double sm = c[s0] - 3.0 * c[s1] + 3.0 * c[s2] - c3;
+    lv.sumM += sm * sm;
+    lv.nM++;
+    if (lv.filled < 3 * lag + 1) continue;
+    uint8_t s3 = slot(lv, 3 * lag);
+    double d3 = x[s0] - 3.0 * x[s1] + 3.0 * x[s2] - x[s3];
+    lv.sumH += d3 * d3;
+    lv.nH++;
+  }
+  if (count_ % ADEV_REBASE_EVERY == 0) rebase();
+}
+
+bool AdevCascade::point(uint8_t k, float tau0_s, AdevPoint &out) const {
+  if (k >= ADEV_LEVELS) return false;
+  const Level &lv = levels_[k];
+  double m = (double)(1UL << k);
+  out.m = (uint16_t)(1u << k);
+  out.tau_s = (float)(m * (double)tau0_s);
+  out.n = lv.nA;
+  out.adev = 0.0f;
+  out.hdev = 0.0f;
+  out.mdev = 0.0f;
+  out.tdev_s = 0.0f;
+  if (!lv.nA) return false;
+  out.adev = (float)sqrt(lv.sumA / (2.0 * m * m * (double)lv.nA));
+  if (lv.nH) out.hdev = (float)sqrt(lv.sumH / (6.0 * m * m * (double)lv.nH));
+  if (lv.nM) {
+    double mdev = sqrt(lv.sumM / (2.0 * m * m * m * m * (double)lv.nM));
+    out.mdev = (float)mdev;
+    out.tdev_s = (float)((double)out.tau_s * mdev / sqrt(3.0));
+  }
+  return true;
+}
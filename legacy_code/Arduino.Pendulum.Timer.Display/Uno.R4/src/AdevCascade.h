@@ -0,0 +1,79 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// AdevCascade.h
+// Streaming Allan-family stability estimators at octave-spaced tau.
+//
+// Each input is the fractional frequency y of one tau0 interval; the phase
+// x (in units of tau0) is its running sum and c is the running sum of x.
+// Level k (m = 2^k) keeps a short ring of x and c sampled every `stride`
+// inputs and accumulates, per evaluation point:
+//   ADEV  second difference of x          x[n] - 2x[n-m] + x[n-2m]
+//   HDEV  third difference of x           (insensitive to linear drift)
+//   MDEV  third difference of c, i.e. the second difference of m-sample
+//         phase averages (separates white from flicker PM)
+// TDEV is derived from MDEV. Cost per input is O(ADEV_LEVELS) and memory is
+// fixed by ADEV_LEVELS * ADEV_RING_LEN.
+// tools/adev_test.cpp validates it on synthetic power-law noise. Kept free
+// of Arduino dependencies.
+// -----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+// Allan/Hadamard/modified deviation cascade: tau = 2^k swings for
+// k = 0 .. ADEV_LEVELS-1. Levels above ADEV_OVERLAP_SHIFT are evaluated every
+// 2^(k - shift) swings (partially overlapping), so each level only keeps
+// 3*2^shift+1 phase points (x and its running sum). Raise the shift on boards
+// with more RAM for closer to full overlap.
+constexpr uint8_t ADEV_LEVELS        = 13;       // tau up to 4096 swings
+constexpr uint8_t ADEV_OVERLAP_SHIFT = 1;        // ~1.9 KB per cascade on the UNO
+constexpr uint8_t ADEV_RING_LEN      = (3u << ADEV_OVERLAP_SHIFT) + 1;
+
+struct AdevPoint {
+  uint16_t m;       // averaging factor (tau = m * tau0)
+  float    tau_s;
+  float    adev;
+  float    hdev;    // 0 until 3m inputs are available
+  float    mdev;    // 0 until 3m inputs (3m-1 for m <= 2^shift) are available
+  float    tdev_s;  // time deviation in seconds (tau * mdev / sqrt(3))
+  uint32_t n;       // number of ADEV second differences accumulated
+};
+
+class AdevCascade {
+public:
+  AdevCascade() { reset(); }
+
+  void reset();
+  void add(double y);
+  uint32_t samples() const { return count_; }
+
+  // False until level `k` has at least one ADEV second difference.
+  bool point(uint8_t k, float tau0_s, AdevPoint &out) const;
+
+private:
+  struct Level {
+    double   x[ADEV_RING_LEN];
+    double   c[ADEV_RING_LEN];
+    uint8_t  head;
+    uint8_t  filled;
+    double   sumA;      // sum of squared second differences of x
+    double   sumH;      // sum of squared third differences of x
+    double   sumM;      // sum of squared third differences of c
+    uint32_t nA;
+    uint32_t nH;
+    uint32_t nM;        // one ahead of nH on levels evaluated every input
+  };
+
+  static uint8_t strideShift(uint8_t k) { return k > ADEV_OVERLAP_SHIFT ? k - ADEV_OVERLAP_SHIFT : 0; }
+  static void push(Level &lv, double x, double c);
+  static uint8_t slot(const Level &lv, uint8_t j) {
+    return (uint8_t)((lv.head + ADEV_RING_LEN - j) % ADEV_RING_LEN);
+  }
+  void rebase();
+
+  Level    levels_[ADEV_LEVELS];
+  double   x_;
+  double   c_;
+  double   yOffset_;
+  uint32_t count_;
+};
@@ -0,0 +1,50 @@
+#include "AllanDev.h"
+#include "NanoComm.h"
+
+#if ENABLE_ADEV
+
+namespace AllanDev {
+
+static AdevCascade periodCascade;
+static AdevCascade ppsCascade;
+static double   tau0 = 0.0;
+static uint16_t lastDropped = 0;
+static bool     haveSample = false;
+
+void reset() {
+  periodCascade.reset();
+  ppsCascade.reset();
+  tau0 = 0.0;
+  haveSample = false;
+}
+
+void update(const PendulumSample &sample) {
+  uint32_t ticks = sample.tick + sample.tock + sample.tick_block + sample.tock_block;
+  if (ticks == 0) return;
+
+  // A dropped edge means a missing swing; the phase series is no longer
+  // contiguous, so restart rather than fold a double period into x.
+  if (haveSample && sample.dropped_events != lastDropped) {
+    reset();
+  }
+  lastDropped = sample.dropped_events;
+  haveSample = true;
+
+  double period_s = NanoComm::ticksToSeconds(ticks, sample.corr_blend_ppm);
+  if (tau0 <= 0.0) tau0 = period_s;
+  periodCascade.add(period_s / tau0 - 1.0);
+
+  if (sample.gps_status == NO_PPS) {
+    if (ppsCascade.samples()) ppsCascade.reset();
+  } else {
+    ppsCascade.add((double)sample.corr_inst_ppm / (double)CORR_PPM_SCALE);
+  }
+}
+
+const AdevCascade &period() { return periodCascade; }
+const AdevCascade &pps() { return ppsCascade; }
+float tau0Seconds() { return (float)tau0; }
+
+} // namespace AllanDev
+
+#endif // ENABLE_ADEV
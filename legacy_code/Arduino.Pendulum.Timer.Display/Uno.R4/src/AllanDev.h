@@ -0,0 +1,22 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// AllanDev.h
+// Allan-family stability of the swing period and of the PPS correction, each
+// an AdevCascade fed once per swing.
+// -----------------------------------------------------------------------------
+
+#include "AdevCascade.h"
+#include "Config.h"
+#include "PendulumProtocol.h"
+
+namespace AllanDev {
+  void reset();
+  // Feed the sample NanoComm just parsed. Swing periods drive the period
+  // cascade; corr_inst_ppm (sampled once per swing) drives the PPS cascade
+  // while PPS is present. Both use the reference swing period as tau0.
+  void update(const PendulumSample &sample);
+  const AdevCascade &period();
+  const AdevCascade &pps();
+  float tau0Seconds();
+}
@@ -43,6 +43,8 @@ bool parseRequest(WiFiClient& client, Request& request) {
     key.toLowerCase();
     if (key == F("content-length")) {
       contentLength = (size_t)value.toInt();
+    } else if (key == F("range")) {
+      request.range_ = value;
     }
   }
 
@@ -13,6 +13,7 @@ public:
   const String& query() const { return query_; }
   const String& body() const { return body_; }
   const String& rawUrl() const { return rawUrl_; }
+  const String& range() const { return range_; }   // "Range" header, empty if none
 
 private:
   Method method_ = Method::UNKNOWN;
@@ -20,6 +21,7 @@ private:
   String query_;
   String body_;
   String rawUrl_;
+  String range_;
 
   friend bool parseRequest(WiFiClient& client, Request& request);
 };
@@ -87,7 +89,7 @@ public:
   void onNotFound(Handler handler) { notFoundHandler_ = handler; }
 
 private:
-  static constexpr uint8_t MAX_ROUTES = 12;
+  static constexpr uint8_t MAX_ROUTES = 24;
   static constexpr uint32_t HTTP_IDLE_TIMEOUT_MS = 2500;
 
   struct Route { Method method; const char* path; Handler handler; };
@@ -0,0 +1,276 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// BinLog.h
+// Binary raw-log format (schema 1) and the raw CSV row/header formatters.
+//
+// A binary log is a file header followed by fixed-size swing records, with a
+// sync marker after every `sync_interval` records:
+//
+//   [BinLogFileHeader][record x N][BinLogSync][record x N][BinLogSync]...
+//
+// The sync marker carries the record count and a CRC of the block it closes,
+// so a reader can verify each block and, after damage, scan for the next
+// marker and carry on. A header is written every time a file is opened
+// (append mode included), so a record torn by a reset is followed by a fresh
+// marker; on a resume it also carries the reset reason. All fields are little-endian; the records hold exactly what the CSV
+// row prints, so tools/binlog2csv reproduces the on-device CSV byte for byte.
+//
+// The logger keeps the file extended past its data with BINLOG_PAD_BYTE
+// (SDLogger.cpp); a record of nothing but pad marks the end of the data. No
+// record or marker ends in the pad byte, so the end is found exactly.
+//
+// Kept free of Arduino dependencies so host tools can share the same code.
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "FastFormat.h"
+#include "PendulumProtocol.h"
+
+constexpr uint32_t BINLOG_FILE_MAGIC     = 0x4C425450;  // "PTBL" on disk
+constexpr uint32_t BINLOG_SYNC_MAGIC     = 0x434E5953;  // "SYNC" on disk
+constexpr uint16_t BINLOG_SCHEMA_VERSION = 1;
+constexpr uint16_t BINLOG_SYNC_INTERVAL  = 64;
+constexpr size_t   BINLOG_FIRMWARE_LEN   = 32;
+constexpr uint8_t  BINLOG_PAD_BYTE       = 0xFF;
+constexpr uint16_t BINLOG_SEQ_MAX        = 0x7FFF;  // seq wraps to 1 after this
+
+struct __attribute__((packed)) BinLogFileHeader {
+  uint32_t magic;
+  uint16_t schema_version;
+  uint16_t header_bytes;        // sizeof(BinLogFileHeader); later schemas may grow it
+  uint16_t record_bytes;
+  uint16_t sync_interval;       // records per block
+  uint32_t tick_hz;             // nominal Nano timer frequency
+  uint32_t created_epoch;       // UTC seconds, 0 before NTP sync
+  uint32_t first_swing_id;
+  uint8_t  data_units;          // DataUnits of the Nano stream (names the CSV columns)
+  uint8_t  reset_reason;        // ResetReason when the header resumes a file, else 0
+  uint8_t  reserved[2];
+  char     firmware[BINLOG_FIRMWARE_LEN];   // NUL-padded
+  uint16_t crc16;               // over every other byte
+  uint16_t reserved2;           // 0
+};
+static_assert(sizeof(BinLogFileHeader) == 64, "BinLogFileHeader layout changed");
+
+// One swing: the PendulumSample fields plus the UNO-assigned swing id.
+struct __attribute__((packed)) BinSwingRecordV1 {
+  uint32_t swing_id;
+  uint32_t tick;
+  uint32_t tock;
+  uint32_t tick_block;
+  uint32_t tock_block;
+  int32_t  corr_inst_ppm;
+  int32_t  corr_blend_ppm;
+  uint16_t dropped_events;
+  uint8_t  gps_status;
+  uint8_t  flags;               // reserved, 0
+  float    temperature_C;       // NaN when the sensor is missing
+  float    humidity_pct;
+  float    pressure_hPa;
+};
+static_assert(sizeof(BinSwingRecordV1) == 44, "BinSwingRecordV1 layout changed");
+
+struct __attribute__((packed)) BinLogSync {
+  uint32_t magic;
+  uint32_t next_swing_id;
+  uint16_t records;             // records in the block this marker closes
+  uint16_t block_crc16;         // CRC of those records' bytes
+  uint16_t crc16;               // over every other byte
+  uint16_t seq;                 // marker count since the file header, 1..BINLOG_SEQ_MAX
+};
+static_assert(sizeof(BinLogSync) == 16, "BinLogSync layout changed");
+
+// Why a file was reopened and appended to: the UNO's last reset, a logging
+// restart without one, or the card coming back after it went away. Written
+// into the resume header (binary) or resume marker line (CSV).
+enum ResetReason : uint8_t {
+  RESET_UNKNOWN  = 0,
+  RESET_POWER_ON = 1,
+  RESET_BROWNOUT = 2,
+  RESET_WATCHDOG = 3,
+  RESET_SOFTWARE = 4,
+  RESET_PIN      = 5,
+  RESET_RESTART  = 6,   // logging restarted, no reset
+  RESET_REMOUNT  = 7,   // card lost and mounted again
+};
+
+inline const char *resetReasonName(uint8_t r) {
+  switch (r) {
+    case RESET_POWER_ON: return "power_on";
+    case RESET_BROWNOUT: return "brownout";
+    case RESET_WATCHDOG: return "watchdog";
+    case RESET_SOFTWARE: return "software";
+    case RESET_PIN:      return "reset_pin";
+    case RESET_RESTART:  return "restart";
+    case RESET_REMOUNT:  return "remount";
+    default: return "unknown";
+  }
+}
+
+// CRC-16/XMODEM (same polynomial as the EEPROM config slots); pass the
+// previous value to continue across buffers.
+inline uint16_t binLogCrc16(const void *data, size_t len, uint16_t crc = 0) {
+  const uint8_t *p = (const uint8_t *)data;
+  while (len--) {
+    crc ^= (uint16_t)(*p++ << 8);
+    for (uint8_t i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// CRC of a header or sync marker with its crc16 field skipped.
+template <typename Marker>
+inline uint16_t binLogMarkerCrc(const Marker &m) {
+  const size_t at = offsetof(Marker, crc16);
+  uint16_t crc = binLogCrc16(&m, at);
+  return binLogCrc16((const uint8_t *)&m + at + 2, sizeof(Marker) - at - 2, crc);
+}
+
+// True if all `len` bytes are pad.
+inline bool binLogIsPad(const uint8_t *p, size_t len) {
+  while (len--) {
+    if (*p++ != BINLOG_PAD_BYTE) return false;
+  }
+  return true;
+}
+
+inline void binLogInitHeader(BinLogFileHeader &h, uint8_t dataUnits, uint32_t tickHz,
+                             uint32_t epoch, uint32_t firstSwingId, const char *firmware,
+                             uint8_t resetReason = RESET_UNKNOWN) {
+  memset(&h, 0, sizeof(h));
+  h.magic = BINLOG_FILE_MAGIC;
+  h.schema_version = BINLOG_SCHEMA_VERSION;
+  h.header_bytes = sizeof(BinLogFileHeader);
+  h.record_bytes = sizeof(BinSwingRecordV1);
+  h.sync_interval = BINLOG_SYNC_INTERVAL;
+  h.tick_hz = tickHz;
+  h.created_epoch = epoch;
+  h.first_swing_id = firstSwingId;
+  h.data_units = dataUnits;
+  h.reset_reason = resetReason;
+  if (firmware) strncpy(h.firmware, firmware, BINLOG_FIRMWARE_LEN - 1);
+  h.crc16 = binLogMarkerCrc(h);
+}
+
+inline bool binLogHeaderValid(const BinLogFileHeader &h) {
+  return h.magic == BINLOG_FILE_MAGIC &&
+         h.crc16 == binLogMarkerCrc(h);
+}
+
+inline void binLogInitSync(BinLogSync &s, uint32_t nextSwingId, uint16_t records,
+                           uint16_t blockCrc, uint16_t seq) {
+  s.magic = BINLOG_SYNC_MAGIC;
+  s.next_swing_id = nextSwingId;
+  s.records = records;
+  s.block_crc16 = blockCrc;
+  s.seq = seq;
+  s.crc16 = binLogMarkerCrc(s);
+}
+
+inline bool binLogSyncValid(const BinLogSync &s) {
+  return s.magic == BINLOG_SYNC_MAGIC &&
+         s.crc16 == binLogMarkerCrc(s);
+}
+
+inline void binLogPack(BinSwingRecordV1 &r, uint32_t swingId, const PendulumSample &s) {
+  r.swing_id = swingId;
+  r.tick = s.tick;
+  r.tock = s.tock;
+  r.tick_block = s.tick_block;
+  r.tock_block = s.tock_block;
+  r.corr_inst_ppm = s.corr_inst_ppm;
+  r.corr_blend_ppm = s.corr_blend_ppm;
+  r.dropped_events = s.dropped_events;
+  r.gps_status = (uint8_t)s.gps_status;
+  r.flags = 0;
+  r.temperature_C = s.temperature_C;
+  r.humidity_pct = s.humidity_pct;
+  r.pressure_hPa = s.pressure_hPa;
+}
+
+inline void binLogUnpack(const BinSwingRecordV1 &r, PendulumSample &s) {
+  s.tick = r.tick;
+  s.tock = r.tock;
+  s.tick_block = r.tick_block;
+  s.tock_block = r.tock_block;
+  s.corr_inst_ppm = r.corr_inst_ppm;
+  s.corr_blend_ppm = r.corr_blend_ppm;
+  s.dropped_events = r.dropped_events;
+  s.gps_status = (GpsStatus)r.gps_status;
+  s.temperature_C = r.temperature_C;
+  s.humidity_pct = r.humidity_pct;
+  s.pressure_hPa = r.pressure_hPa;
+}
+
+inline const char *rawLogUnitsLabel(DataUnits du) {
+  switch (du) {
+    case DataUnits::RawCycles:  return "cycles";
+    case DataUnits::AdjustedMs: return "ms";
+    case DataUnits::AdjustedUs: return "us";
+    case DataUnits::AdjustedNs: return "ns";
+    default: return "units";
+  }
+}
+
+// Raw CSV schema: the header line (without line ending) and one row ("\n").
+// Lines other than rows (header, resume marker) end in "\r\n".
+inline int rawLogCsvHeader(char *out, size_t len, DataUnits du) {
+  const char *units = rawLogUnitsLabel(du);
+  return snprintf(out, len,
+                  "tick_%s,tock_%s,tick_block_%s,tock_block_%s,corr_inst_ppm,corr_blend_ppm,gps_status,dropped,temperature_C,humidity_pct,pressure_hPa",
+                  units, units, units, units);
+}
+
+// The line (without line ending) written where logging resumes in an
+// existing CSV file; binlog2csv prints it for each resume header.
+inline int rawLogResumeLine(char *out, size_t len, uint8_t reason, uint32_t epoch,
+                            uint32_t swingId) {
+  return snprintf(out, len, "# resume reason=%s epoch=%lu swing_id=%lu",
+                  resetReasonName(reason), (unsigned long)epoch, (unsigned long)swingId);
+}
+
+// Swings missing from the log (the logger's spill queue overflowed, or rows
+// were still buffered when the card went away). No commas, so a reader's
+// column count never matches it. A binary log marks a gap with a sync marker
+// whose next_swing_id is the first missing swing; binlog2csv prints the same
+// line when the following record's swing id is higher.
+inline int rawLogGapLine(char *out, size_t len, uint32_t firstSwingId, uint32_t lastSwingId) {
+  return snprintf(out, len, "# gap rows=%lu first_swing_id=%lu last_swing_id=%lu",
+                  (unsigned long)(lastSwingId - firstSwingId + 1),
+                  (unsigned long)firstSwingId, (unsigned long)lastSwingId);
+}
+
+// Same text as "%lu,%lu,%lu,%lu,%ld,%ld,%u,%u,%.2f,%.2f,%.2f\n" (and the
+// same return value), via FastFormat: this runs for every swing.
+inline int rawLogCsvRow(char *out, size_t len, const PendulumSample &s) {
+  FastFormat::Appender a(out, len);
+  a.appendU32(s.tick);
+  a.append(',');
+  a.appendU32(s.tock);
+  a.append(',');
+  a.appendU32(s.tick_block);
+  a.append(',');
+  a.appendU32(s.tock_block);
+  a.append(',');
+  a.appendI32(s.corr_inst_ppm);
+  a.append(',');
+  a.appendI32(s.corr_blend_ppm);
+  a.append(',');
+  a.appendU32((uint32_t)s.gps_status);
+  a.append(',');
+  a.appendU32(s.dropped_events);
+  a.append(',');
+  a.appendFixed2(s.temperature_C);
+  a.append(',');
+  a.appendFixed2(s.humidity_pct);
+  a.append(',');
+  a.appendFixed2(s.pressure_hPa);
+  a.append('\n');
+  return a.finish();
+}
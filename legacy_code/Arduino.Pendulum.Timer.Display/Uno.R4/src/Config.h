@@ -25,40 +25,192 @@
 // Sensor polling cadence
 constexpr uint32_t SENSOR_PERIOD_MS = 1000; // environmental sensor read interval
 
+// Optional analysis features. The UNO's 32 KB of SRAM also has to hold the
+// WiFiS3 and serial buffers, the SSD1306 framebuffer, HTTP Strings and the
+// stack, so the larger analyses are compiled in only on request: build with
+// e.g. -DENABLE_ADEV=1, or set it here, and disable something else if
+// MemoryMonitor then warns about free RAM. A disabled feature's endpoint
+// answers 404 and its module compiles to nothing. Static RAM per feature:
+#ifndef ENABLE_LONG_WINDOW
+#define ENABLE_LONG_WINDOW 0   // long stats window B, ~4.9 KB
+#endif
+#ifndef ENABLE_ADEV
+#define ENABLE_ADEV 0          // /adev.json, ~4.2 KB
+#endif
+#ifndef ENABLE_PSD
+#define ENABLE_PSD 0           // /psd.json, ~6 KB at PSD_SEGMENT_MAX 512
+#endif
+#ifndef ENABLE_ROLLUPS
+#define ENABLE_ROLLUPS 0       // /rollup.json, ~3.5 KB
+#endif
+#ifndef ENABLE_DEV_HIST
+#define ENABLE_DEV_HIST 0      // /hist.json, ~1.9 KB
+#endif
+#ifndef ENABLE_GOERTZEL
+#define ENABLE_GOERTZEL 1      // /goertzel.json, ~0.2 KB
+#endif
+#ifndef ENABLE_ENV_REGRESSION
+#define ENABLE_ENV_REGRESSION 1 // /env.json, ~0.3 KB
+#endif
+#ifndef ENABLE_DISTURBANCE
+#define ENABLE_DISTURBANCE 1   // /profile.json, ~0.2 KB; uses PSD, Goertzel and rollups when built
+#endif
+
 // Stats / buffering defaults
 // Reduce default stats window to trim RAM usage on the Uno R4 while still
 // providing several minutes of history at higher BPMs.
 constexpr uint16_t DEFAULT_STATS_WINDOW  = 288;      // ~3.2 min @ 180 BPM (~288 cycles)
 constexpr uint32_t DEFAULT_ROLLING_MS    = 300000UL; // 5 minutes
 
-// Rolling stats thresholds / safety defaults
-constexpr int32_t  DEFAULT_BLOCK_JUMP_US = 500;       // μs jump that triggers stats reset
+// The short stats window is a cursor over a sample ring (StatsEngine.cpp), so
+// it costs only its running sums; ~20 bytes per swing, so 288 is ~5.6 KB on
+// the UNO and can be raised on boards with more RAM. The short window also
+// keeps median/MAD order trees (~20 bytes per swing), which cap it at
+// STATS_SHORT_WINDOW_MAX.
+constexpr uint16_t STATS_RING_CAPACITY    = 288;
+constexpr uint16_t STATS_SHORT_WINDOW_MAX = DEFAULT_STATS_WINDOW;
+static_assert(STATS_SHORT_WINDOW_MAX <= STATS_RING_CAPACITY, "short window must fit the stats ring");
+
+// The long window covers at most STATS_LONG_BLOCKS * STATS_LONG_BLOCK_LEN =
+// 4096 swings, and only when built with ENABLE_LONG_WINDOW. It has no
+// per-swing storage: it is kept as blocks of STATS_LONG_BLOCK_LEN swings, each
+// with its exact sums and a STATS_LONG_SKETCH-point quantile sketch of the
+// period and beat error. Mean and stddev stay exact and follow every swing.
+// Median, MAD and quantiles are approximate: they come from the sketches of
+// the finished blocks only, so they move once per block and lag the newest
+// swings by up to a block. Each sketch point stands for 1/STATS_LONG_SKETCH
+// of its block, so a reported quantile is off by at most
+// 1/(2 * STATS_LONG_SKETCH) of the window in rank (+/-6.25 %): the median lies
+// between the true 44th and 56th percentiles, about +/-0.16 sigma for normal
+// data. p05/p95 are interpolated between the outer points and read no further
+// out than about the 6th/94th percentile. Exact order statistics over 4096
+// swings would take ~80 KB of tree. A block is sketched from the sample ring
+// as it finishes, so it must fit there. ~300 bytes per block plus a 1 KB sort
+// scratch on the UNO.
+constexpr uint16_t STATS_LONG_BLOCK_LEN  = 256;
+constexpr uint8_t  STATS_LONG_BLOCKS     = 16;       // up to 4096 swings, ~2.3 h @ 2 s period
+constexpr uint8_t  STATS_LONG_SKETCH     = 8;
+constexpr uint16_t DEFAULT_STATS_LONG_WINDOW = STATS_LONG_BLOCK_LEN * STATS_LONG_BLOCKS;
+static_assert(STATS_LONG_BLOCK_LEN <= STATS_RING_CAPACITY, "a long-window block must fit the stats ring");
+
+// Change-point detection (StatsEngine, Cusum.h): two-sided CUSUM on the
+// period and beat-error series, in units of the segment's own sigma. A change
+// segments the stats windows at the estimated change point.
+constexpr float    CUSUM_K              = 0.5f;     // allowance (sigma)
+constexpr float    CUSUM_H              = 12.0f;    // alarm threshold (sigma); ~1e6 swings between false alarms
+constexpr uint16_t CUSUM_WARMUP         = 32;       // swings to estimate mean/sigma
+constexpr uint8_t  CHANGE_EVENT_LOG     = 16;       // recent events kept for /changes.json
+
+// Median-of-means headline estimate: median of the last M means of K swings.
+constexpr uint8_t  MOM_MAX_BLOCKS        = 31;
+constexpr uint8_t  MOM_BLOCK_LEN_DEFAULT = 8;
+constexpr uint8_t  MOM_BLOCKS_DEFAULT    = 9;        // odd M gives a true middle block
 
 // Rolling stats thresholds / safety
 constexpr uint32_t MAX_PERIOD_US_EST    = 1000000UL; // conservative worst-case half-period sum
 constexpr uint32_t MAX_DELTA_US_EST     = 1000000UL; // conservative worst-case delta
 
+// The Allan/Hadamard/modified deviation cascade sizes live in AdevCascade.h,
+// which host tools share.
+
+// Welch PSD of swing-period residuals (Spectrum.*). The segment length is the
+// runtime tunable psdSegmentLen, a power of two from PSD_SEGMENT_MIN up to the
+// PSD_SEGMENT_MAX the buffers are sized for (~11.5 bytes per point, so 512 is
+// ~6 KB on the UNO); boards with more RAM can raise the maximum to 4096.
+constexpr uint16_t PSD_SEGMENT_MIN      = 256;
+constexpr uint16_t PSD_SEGMENT_MAX      = 512;
+constexpr uint16_t PSD_SEGMENT_LEN      = 256;      // default psdSegmentLen
+constexpr uint8_t  PSD_TOP_PEAKS        = 5;
+static_assert(PSD_SEGMENT_MAX <= 4096 && (PSD_SEGMENT_MAX & (PSD_SEGMENT_MAX - 1)) == 0 &&
+              (PSD_SEGMENT_MIN & (PSD_SEGMENT_MIN - 1)) == 0,
+              "PSD segment bounds must be powers of two up to 4096");
+static_assert(PSD_SEGMENT_LEN >= PSD_SEGMENT_MIN && PSD_SEGMENT_LEN <= PSD_SEGMENT_MAX &&
+              (PSD_SEGMENT_LEN & (PSD_SEGMENT_LEN - 1)) == 0,
+              "PSD_SEGMENT_LEN must be a power of two in [PSD_SEGMENT_MIN, PSD_SEGMENT_MAX]");
+
+// Goertzel detector bank for known disturbances (Goertzel.*). The default bank
+// tracks a Synchronome-style 30 s kick and its second harmonic; more periods
+// can be added at runtime via /goertzel.json.
+constexpr uint8_t  GOERTZEL_MAX_BINS          = 8;
+constexpr float    GOERTZEL_DEFAULT_PERIOD_S  = 30.0f;
+constexpr uint8_t  GOERTZEL_DEFAULT_HARMONICS = 2;
+constexpr float    GOERTZEL_TIME_CONSTANT_S   = 600.0f;  // exponential window
+
+// Deviation histograms (DeviationHist.*): 2^HIST_SUB_BITS buckets per octave
+// (<= 25% wide), magnitudes up to 2^HIST_MAX_BITS us plus an overflow bucket
+// per sign. 620 bytes per metric.
+constexpr uint8_t  HIST_SUB_BITS        = 2;
+constexpr uint8_t  HIST_MAX_BITS        = 20;       // ~1 s
+constexpr uint8_t  HIST_REF_SHIFT       = 6;        // reference EMA weight 1/64
+
+// Environmental regression (EnvRegression.*): RLS of rate deviation (ppm) on
+// temperature, humidity and pressure about fixed centres, so the persisted
+// coefficients keep their meaning across reboots. lambda = 0.9999 forgets
+// with a ~10k swing (~5 h at 2 s) memory. The model is saved every 6 h to
+// limit EEPROM wear.
+constexpr double   ENV_RLS_LAMBDA       = 0.9999;
+constexpr double   ENV_RLS_P0           = 1.0e4;    // initial covariance diagonal
+constexpr double   ENV_RLS_P_MAX        = 1.0e6;    // stop forgetting above this (windup guard)
+constexpr float    ENV_CENTER_TEMP_C    = 20.0f;
+constexpr float    ENV_CENTER_HUM_PCT   = 50.0f;
+constexpr float    ENV_CENTER_PRESS_HPA = 1013.25f;
+constexpr uint32_t ENV_SAVE_INTERVAL_MS = 6UL * 3600UL * 1000UL;
+
+// Long-horizon rollups (Rollups.*). 24 bytes per entry; these UNO sizes
+// (60 min, 48 h, 30 d) cost ~3.3 KB. An RP2040 build can hold 24 h of minutes,
+// 30 d of hours and a year of days (1440/720/365, ~60 KB).
+constexpr uint16_t ROLLUP_MINUTES       = 60;
+constexpr uint16_t ROLLUP_HOURS         = 48;
+constexpr uint16_t ROLLUP_DAYS          = 30;
+
+// Disturbance classifier (Disturbance.*). Features are accumulated per swing
+// and scored every DISTURB_REFRESH_SWINGS; each refresh is blended into the
+// published features with weight 1/2^DISTURB_SMOOTH_SHIFT. The *_REF values
+// are the feature levels that score 0.5 for their profile.
+constexpr uint16_t DISTURB_REFRESH_SWINGS = 256;
+constexpr uint8_t  DISTURB_SMOOTH_SHIFT   = 2;
+constexpr float    DISTURB_ASYM_REF       = 0.01f;   // |pass-speed asymmetry|, fraction
+constexpr float    DISTURB_ASYM_MIN_T     = 4.0f;    // asymmetry must be this many std errors
+constexpr float    DISTURB_LINE_REF       = 20.0f;   // spectral peak / mean PSD
+constexpr float    DISTURB_TONE_SNR_MIN   = 3.0f;    // Goertzel amplitude / noise floor, ignored below
+constexpr float    DISTURB_TONE_REF       = 5.0f;    // ... and scoring 0.5 this far above it
+constexpr float    DISTURB_KURT_REF       = 3.0f;    // excess kurtosis of period residual
+constexpr float    DISTURB_OUTLIER_SIGMA  = 5.0f;
+constexpr float    DISTURB_DRIFT_FAST     = 0.5f;    // s/day per day; shortens the suggested window
+constexpr uint8_t  DISTURB_DRIFT_MIN_HOURS = 6;
+
 // SD settings
 #define SD_CS_PIN          10
 #define LOG_FILENAME       "pendulum.csv"
 constexpr size_t LOG_FILENAME_LEN = 20;    // includes null terminator
+constexpr size_t LOG_PATH_LEN     = 32;    // active file path, directory included
+#define LOG_RAW_DIR        "logs/raw"
+#define LOG_STATS_DIR      "logs/stats"
+constexpr bool    LOG_SIZE_ROTATE_DEFAULT = false;
+constexpr uint8_t LOG_ROTATE_MB_DEFAULT   = 64;   // size rotation threshold, MB (1..255)
 constexpr bool   LOG_DAILY_DEFAULT   = false;
 constexpr bool   LOG_ENABLED_DEFAULT = false;
 constexpr bool   LOG_APPEND_DEFAULT  = false;
+constexpr uint8_t LOG_FORMAT_DEFAULT = 0;      // 0 = CSV, 1 = binary (BinLog.h, *.bin)
+#define FIRMWARE_ID        "UnoR4-Pendulum " __DATE__   // recorded in binary log headers
 
 // Serial from Nano Every (baud rate in PendulumProtocol.h)
 #define SERIAL_TIMEOUT_MS  50
 #define NANO_LINE_MAX      256
 #define NANO_SERIAL        Serial1
 
-// EEPROM layout (512 bytes total)
+// EEPROM layout (768 of EEPROM_SIZE bytes used)
 // 0 - 63   : shared TunableConfig (slot A)
 // 64 - 127 : shared TunableConfig (slot B)
 // 128 - 191: UnoConfig (slot A)
 // 192 - 255: UnoConfig (slot B)
 // 256 - 383: WiFi credentials (slot 0)
 // 384 - 511: WiFi credentials (slot 1)
-#define EEPROM_SIZE            512
+// 512 - 575: AnalysisConfig (slot A)
+// 576 - 639: AnalysisConfig (slot B)
+// 640 - 703: EnvModelRecord (slot A)
+// 704 - 767: EnvModelRecord (slot B)
+#define EEPROM_SIZE            1024
 #define MAX_SSID_LEN            32
 #define MAX_PASS_LEN            64
 
@@ -71,6 +223,12 @@ constexpr int EEPROM_WIFI_SLOT_SIZE         = 128;
 constexpr int EEPROM_WIFI_SLOT0_ADDR        = 256;                                     // WiFi credentials slot 0
 constexpr int EEPROM_WIFI_SLOT1_ADDR        = EEPROM_WIFI_SLOT0_ADDR + EEPROM_WIFI_SLOT_SIZE; // WiFi credentials slot 1
 static_assert(EEPROM_WIFI_SLOT1_ADDR + EEPROM_WIFI_SLOT_SIZE <= EEPROM_SIZE, "WiFi slots must fit EEPROM");
+constexpr int EEPROM_ANALYSIS_SLOT_A_ADDR   = EEPROM_WIFI_SLOT1_ADDR + EEPROM_WIFI_SLOT_SIZE; // AnalysisConfig slot A
+constexpr int EEPROM_ANALYSIS_SLOT_B_ADDR   = EEPROM_ANALYSIS_SLOT_A_ADDR + 64;        // AnalysisConfig slot B
+static_assert(EEPROM_ANALYSIS_SLOT_B_ADDR + 64 <= EEPROM_SIZE, "Analysis slots must fit EEPROM");
+constexpr int EEPROM_ENV_SLOT_A_ADDR        = EEPROM_ANALYSIS_SLOT_B_ADDR + 64;        // EnvModelRecord slot A
+constexpr int EEPROM_ENV_SLOT_B_ADDR        = EEPROM_ENV_SLOT_A_ADDR + 64;             // EnvModelRecord slot B
+static_assert(EEPROM_ENV_SLOT_B_ADDR + 64 <= EEPROM_SIZE, "Env model slots must fit EEPROM");
 
 // WiFi
 #define WIFI_CONNECT_TIMEOUT_MS 10000
@@ -84,9 +242,67 @@ constexpr unsigned WIFI_AP_START_TIMEOUT_MS = 5000; // timeout while waiting for
 constexpr unsigned WIFI_CONNECT_RETRY_MS  = 250;   // interval between WiFi status checks
 constexpr unsigned WIFI_RECONNECT_INTERVAL_MS = 30000; // interval between reconnect attempts
 
-// SD flush throttling
-const uint16_t FLUSH_EVERY_N = 32;
-const unsigned long FLUSH_EVERY_MS = 5000;
+// SD write-behind (SDLogger.cpp). Rows collect in sector buffers that are
+// written whole, one slice per SDLogger::service() call, so loop() never waits
+// for a flush. A partly filled buffer is written and the file synced once its
+// oldest row is SD_MAX_BUFFER_AGE_MS old; that is also the most data a power
+// cut can lose. A CSV row is ~50 bytes, so a sector holds ~20 s at a 2 s
+// period; a shorter age limit would turn most writes into partial ones.
+// The buffers are shared by the raw and stats logs: one filling and one
+// queued per log (2 KB) suits the UNO; raise on boards with more RAM to ride
+// out slow card erases. SD_LOG_TARGETS files can be open at once:
+// raw and stats, plus the next part or day's pair or the pair being closed.
+constexpr uint16_t SD_SECTOR_BYTES       = 512;
+constexpr uint8_t  SD_WRITE_BUFFERS      = 4;
+constexpr uint8_t  SD_LOG_TARGETS        = 4;
+constexpr uint32_t SD_SERVICE_BUDGET_US  = 2000;  // keep writing sectors while under this
+constexpr uint32_t SD_MAX_BUFFER_AGE_MS  = 30000;
+// The stats log gains a sector in ~50 s at its 10 s cadence; it is derived
+// from the raw log, so it may wait longer rather than add a partial write
+// and sync every 30 s.
+constexpr uint32_t SD_STATS_MAX_BUFFER_AGE_MS = 120000;
+static_assert(SD_WRITE_BUFFERS >= 4, "SD writer needs two buffers per log");
+
+// Reserve-ahead: the log file is kept SD_RESERVE_AHEAD_BYTES longer than its
+// data with pad sectors, topped up in idle service slices once the margin
+// drops below SD_RESERVE_LOW_BYTES, so row writes never allocate clusters.
+// SD.h cannot truncate, so up to this much pad stays at the end of a closed
+// file (blank lines in CSV); /download and the recovery scan skip it. A CSV
+// row is ~50 bytes, so 64 KB lasts ~40 min at a 2 s period.
+constexpr uint32_t SD_RESERVE_AHEAD_BYTES = 64UL * 1024UL;
+constexpr uint32_t SD_RESERVE_LOW_BYTES   = 32UL * 1024UL;
+static_assert(SD_RESERVE_LOW_BYTES < SD_RESERVE_AHEAD_BYTES, "reserve low mark must be below the target");
+
+// Spill queue: swings the writer cannot take right now (every buffer waiting
+// for the card, or the card gone) wait in RAM as binary records, 44 bytes
+// each; 64 ride out ~2 min at a 2 s period. When it is full the oldest record
+// is dropped and a counted gap marker is logged in its place. The backlog
+// drains SD_SPILL_DRAIN_ROWS per SDLogger::service() call, ahead of newer
+// swings. After SD_FAIL_LIMIT failed writes in a row the card is treated as
+// gone and a remount is tried every SD_REMOUNT_INTERVAL_MS; SD.begin() can
+// block for its ~2 s init timeout while no card is present. A failed write
+// has already lost its sector, so one is enough: the remount's recovery scan
+// is the quickest way back to a clean file.
+constexpr uint8_t  SD_SPILL_RECORDS       = 64;
+constexpr uint8_t  SD_SPILL_DRAIN_ROWS    = 4;
+constexpr uint8_t  SD_FAIL_LIMIT          = 1;
+constexpr uint32_t SD_REMOUNT_INTERVAL_MS = 10000;
+
+// SD health telemetry (SDLogger::health(), /sd.json): each card operation's
+// latency in log2 buckets, bucket b counting [2^b, 2^(b+1)) us and the last
+// one everything from ~0.5 s up. 80 bytes per operation type.
+constexpr uint8_t  SD_LATENCY_BUCKETS = 20;
+
+// Sparse index beside the raw log (LogIndex.h): one entry per
+// LOG_INDEX_INTERVAL CSV rows (binary: per sync block), ~3 KB of CSV apart;
+// entries reach the card LOG_INDEX_BATCH at a time (~30 min at a 2 s period).
+constexpr uint16_t LOG_INDEX_INTERVAL = 64;
+constexpr uint8_t  LOG_INDEX_BATCH    = 16;
+
+// Stats log (StatsLog.cpp): one StatsRecordV1 row per period while swings
+// arrive. A row is ~150 bytes, so a sector holds about 35 s of rows.
+constexpr uint32_t STATS_LOG_PERIOD_MS = 10000;
+constexpr size_t   STATS_LOG_LINE_MAX  = 256;
 
 // RAM monitor thresholds
 #define RAM_WARN_THRESHOLD   4000   // bytes
@@ -123,7 +339,6 @@ namespace UnoTunables {
 
   extern uint16_t statsWindowSize;
   extern uint32_t rollingWindowMs;
-  extern int32_t  blockJumpUs;
 
   extern uint16_t minEdgeSepTicks;
 
@@ -136,6 +351,18 @@ namespace UnoTunables {
   extern bool     logEnabled;
   extern bool     logAppend;
   extern char     logBaseName[LOG_FILENAME_LEN];
+  extern uint8_t  logFormat;
+  extern bool     logSizeRotate;
+  extern uint8_t  logRotateMB;
+}
+
+// Analysis tunables live in their own EEPROM slots (UnoConfig is full).
+namespace AnalysisTunables {
+  extern uint16_t statsLongWindow;
+  extern uint8_t  momBlockLen;
+  extern uint8_t  momBlocks;
+  extern uint32_t nominalPeriodUs;   // 0 = use the first measured period
+  extern uint16_t psdSegmentLen;
 }
 
 // Uno-specific tunables stored separately from shared TunableConfig
@@ -153,7 +380,7 @@ struct UnoConfig {
   uint32_t ppsMaxUs;
   uint32_t metricsPeriodMs;
   uint32_t rollingWindowMs;
-  int32_t  blockJumpUs;
+  int32_t  blockJumpUs;   // unused; was the block-jump reset threshold, kept for the saved layout
   uint32_t seq;      // sequence for Uno-specific config
 
   uint16_t statsWindowSize;
@@ -169,4 +396,30 @@ struct UnoConfig {
   bool     logEnabled;
   bool     logAppend;
   char     logBaseName[LOG_FILENAME_LEN];
+  uint8_t  logFormat;   // was tail padding; configs saved before it read as CSV unless 1
+  uint8_t  logSizeRotate;   // was tail padding: 1 = size rotation, anything else off
+  uint8_t  logRotateMB;     // read only when logSizeRotate == 1
+};
+
+struct AnalysisConfig {
+  uint32_t seq;
+  uint16_t crc16;
+  uint16_t statsLongWindow;
+  uint8_t  momBlockLen;
+  uint8_t  momBlocks;
+  uint16_t psdSegmentLen;   // was padding; configs saved before it read 0 (default)
+  uint32_t nominalPeriodUs;
+};
+
+// Persisted RLS state for EnvRegression. Only the covariance diagonal is kept;
+// off-diagonal terms are rebuilt from new data after a reboot.
+struct EnvModelRecord {
+  uint32_t seq;
+  uint16_t crc16;
+  uint16_t reserved;
+  double   refPeriodUs;   // rate deviation is period / refPeriodUs - 1
+  float    theta[4];      // intercept ppm, ppm/degC, ppm/%RH, ppm/hPa
+  float    pDiag[4];
+  float    residVar;      // ppm^2
+  uint32_t samples;
 };
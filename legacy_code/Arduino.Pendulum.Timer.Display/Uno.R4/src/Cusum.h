@@ -0,0 +1,136 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// Cusum.h
+// Two-sided CUSUM change-point detector for a single series.
+//
+// The first `warmup` samples of a segment estimate the reference mean and
+// scale. After that each sample is standardised, z = (x - mean) / sigma,
+// clipped to +/-zClip so a single impulse cannot raise an alarm alone, and
+// accumulated as
+//   S+ = max(0, S+ + z - k),  S- = max(0, S- - z - k).
+// An alarm fires when either sum exceeds h. The change is placed just after
+// the last sample at which that sum was zero. Between alarms the mean and the
+// (clipped) variance keep being refined: as a plain running average until the
+// segment holds 2^trackShift samples, then as an EMA of that weight so slow
+// drift is followed. This also recovers from a warmup spoiled by an impulse,
+// and keeps the short warmup's estimation error from looking like a small
+// shift. O(1) per sample.
+// Kept free of Arduino dependencies.
+// -----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdint.h>
+
+class CusumDetector {
+public:
+  CusumDetector() { configure(0.5f, 12.0f, 32, 1.0f); }
+
+  void configure(float k, float h, uint16_t warmup, float sigmaFloor,
+                 float zClip = 4.0f, uint8_t trackShift = 10) {
+    k_ = k;
+    h_ = h;
+    warmup_ = warmup < 2 ? 2 : warmup;
+    sigmaFloor_ = sigmaFloor;
+    zClip_ = zClip;
+    trackN_ = (uint16_t)(1u << (trackShift > 15 ? 15 : trackShift));
+    track_ = 1.0 / (double)trackN_;
+    reset();
+  }
+
+  // Start a new segment: the next `warmup` samples re-estimate the reference.
+  void reset() {
+    n_ = 0;
+    mean_ = 0.0;
+    m2_ = 0.0;
+    var_ = 0.0;
+    sigma_ = 0.0f;
+    sPos_ = 0.0f;
+    sNeg_ = 0.0f;
+    agePos_ = 0;
+    ageNeg_ = 0;
+    changeAge_ = 0;
+    shift_ = 0.0f;
+  }
+
+  // Returns +1 / -1 when an upward / downward shift is detected, else 0.
+  int8_t add(double x) {
+    if (n_ < warmup_) {
+      n_++;
+      double delta = x - mean_;
+      mean_ += delta / (double)n_;
+      m2_ += delta * (x - mean_);
+      if (n_ == warmup_) {
+        var_ = m2_ / (double)(n_ - 1);
+        updateSigma();
+      }
+      return 0;
+    }
+    double d = x - mean_;
+    float z = (float)(d / (double)sigma_);
+    if (z > zClip_) z = zClip_;
+    if (z < -zClip_) z = -zClip_;
+
+    sPos_ += z - k_;
+    if (sPos_ <= 0.0f) { sPos_ = 0.0f; agePos_ = 0; } else { agePos_++; }
+    sNeg_ += -z - k_;
+    if (sNeg_ <= 0.0f) { sNeg_ = 0.0f; ageNeg_ = 0; } else { ageNeg_++; }
+
+    int8_t dir = 0;
+    if (sPos_ > h_) {
+      dir = 1;
+      changeAge_ = agePos_;
+      shift_ = (sPos_ / (float)agePos_ + k_) * sigma_;
+    } else if (sNeg_ > h_) {
+      dir = -1;
+      changeAge_ = ageNeg_;
+      shift_ = -(sNeg_ / (float)ageNeg_ + k_) * sigma_;
+    }
+    if (!dir) {
+      double lim = (double)zClip_ * (double)sigma_;
+      double d2 = d * d < lim * lim ? d * d : lim * lim;
+      if (n_ < trackN_) n_++;
+      double w = n_ < trackN_ ? 1.0 / (double)n_ : track_;
+      mean_ += d * w;
+      var_ += (d2 - var_) * w;
+      updateSigma();
+    }
+    return dir;
+  }
+
+  // After an alarm: samples since the change, including the alarming one.
+  uint32_t changeAge() const { return changeAge_; }
+  // After an alarm: estimated size of the shift, in input units.
+  float shift() const { return shift_; }
+
+  bool  warmedUp() const { return n_ >= warmup_; }
+  float mean() const { return (float)mean_; }
+  float sigma() const { return sigma_; }
+  float upper() const { return sPos_; }
+  float lower() const { return sNeg_; }
+
+private:
+  void updateSigma() {
+    float sd = (float)sqrt(var_);
+    sigma_ = sd > sigmaFloor_ ? sd : sigmaFloor_;
+  }
+
+  double   mean_;
+  double   m2_;
+  double   var_;
+  double   track_;
+  float    sigma_;
+  float    sigmaFloor_;
+  float    k_;
+  float    h_;
+  float    zClip_;
+  float    sPos_;
+  float    sNeg_;
+  float    shift_;
+  uint32_t agePos_;
+  uint32_t ageNeg_;
+  uint32_t changeAge_;
+  uint16_t n_;
+  uint16_t warmup_;
+  uint16_t trackN_;
+};
@@ -0,0 +1,81 @@
+#include "DeviationHist.h"
+#include "NanoComm.h"
+
+#if ENABLE_DEV_HIST
+
+namespace DeviationHist {
+
+static DeviationHistogram hists[MetricCount];
+static double   refPeriodUs = 0.0;
+static double   refBlockUs = 0.0;
+static bool     haveRef = false;
+static uint16_t lastDropped = 0;
+static bool     haveSample = false;
+
+void reset() {
+  for (uint8_t i = 0; i < MetricCount; ++i) hists[i].clear();
+  haveRef = false;
+  haveSample = false;
+}
+
+static int32_t roundUs(double us) {
+  if (us > 2147483647.0) return 2147483647;
+  if (us < -2147483647.0) return -2147483647;
+  return (int32_t)(us < 0.0 ? us - 0.5 : us + 0.5);
+}
+
+void update(const PendulumSample &sample) {
+  uint32_t blockTicks = sample.tick_block + sample.tock_block;
+  uint32_t ticks = sample.tick + sample.tock + blockTicks;
+  if (ticks == 0) return;
+
+  // A dropped edge folds two swings into one period; keep it out of the
+  // histograms and the references.
+  bool dropped = haveSample && sample.dropped_events != lastDropped;
+  lastDropped = sample.dropped_events;
+  haveSample = true;
+  if (dropped) return;
+
+  double periodUs = NanoComm::ticksToSeconds(ticks, sample.corr_blend_ppm) * 1e6;
+  double blockUs  = NanoComm::ticksToSeconds(blockTicks, sample.corr_blend_ppm) * 1e6;
+  double beatUs   = (NanoComm::ticksToSeconds(sample.tick, sample.corr_blend_ppm) -
+                     NanoComm::ticksToSeconds(sample.tock, sample.corr_blend_ppm)) * 1e6;
+  if (!haveRef) {
+    refPeriodUs = periodUs;
+    refBlockUs = blockUs;
+    haveRef = true;
+  }
+
+  hists[Period].add(roundUs(periodUs - refPeriodUs));
+  hists[Beat].add(roundUs(beatUs));
+  hists[Block].add(roundUs(blockUs - refBlockUs));
+
+  const double w = 1.0 / (double)(1u << HIST_REF_SHIFT);
+  refPeriodUs += (periodUs - refPeriodUs) * w;
+  refBlockUs  += (blockUs - refBlockUs) * w;
+}
+
+const DeviationHistogram &histogram(Metric m) {
+  return hists[m < MetricCount ? m : Period];
+}
+
+float referenceUs(Metric m) {
+  switch (m) {
+    case Period: return (float)refPeriodUs;
+    case Block:  return (float)refBlockUs;
+    default:     return 0.0f;
+  }
+}
+
+const char *name(Metric m) {
+  switch (m) {
+    case Period: return "period";
+    case Beat:   return "beat";
+    case Block:  return "block";
+    default:     return "";
+  }
+}
+
+} // namespace DeviationHist
+
+#endif // ENABLE_DEV_HIST
@@ -0,0 +1,29 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// DeviationHist.h
+// Histograms of per-swing timing deviations, to make non-Gaussian events
+// (knocks, missed drives, bimodal beat) visible where stddev hides them.
+//
+// Metrics, all in us:
+//   Period - swing period minus a slow EMA of the period
+//   Beat   - beat error, tick minus tock
+//   Block  - block duration (tick_block + tock_block) minus its slow EMA
+// -----------------------------------------------------------------------------
+
+#include "Config.h"
+#include "HdrHistogram.h"
+#include "PendulumProtocol.h"
+
+using DeviationHistogram = HdrHistogram<HIST_SUB_BITS, HIST_MAX_BITS>;
+
+namespace DeviationHist {
+  enum Metric : uint8_t { Period = 0, Beat, Block, MetricCount };
+
+  void reset();
+  void update(const PendulumSample &sample);
+
+  const DeviationHistogram &histogram(Metric m);
+  float referenceUs(Metric m);   // EMA the deviation is taken against (0 for Beat)
+  const char *name(Metric m);
+}
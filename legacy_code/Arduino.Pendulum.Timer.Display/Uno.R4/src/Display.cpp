@@ -78,7 +78,10 @@ static void rebuildTickerMessages() {
   }
 
   if (count < MAX_TICKER_MESSAGES) {
-    tickerMessages[count++] = String(F("LOG: ")) + (SDLogger::isLogging() ? F("ON") : F("OFF"));
+    const __FlashStringHelper* logState = F("OFF");
+    if (SDLogger::isLogging()) logState = F("ON");
+    else if (SDLogger::isCardLost()) logState = F("NO SD");
+    tickerMessages[count++] = String(F("LOG: ")) + logState;
   }
 
   if (count < MAX_TICKER_MESSAGES) {
@@ -207,7 +210,12 @@ void update() {
   display.print(line);
 
   setRow(1);
-  snprintf(line, sizeof(line), "AVG BPM: %9.5f", st.avg_bpm);
+  const RobustStats &robust = StatsEngine::robust();
+  if (robust.ready) {
+    snprintf(line, sizeof(line), "MOM BPM: %9.5f", robust.bpm);
+  } else {
+    snprintf(line, sizeof(line), "AVG BPM: %9.5f", st.avg_bpm);
+  }
   display.print(line);
 
   uint32_t period_ticks = currentSample.tick + currentSample.tick_block +
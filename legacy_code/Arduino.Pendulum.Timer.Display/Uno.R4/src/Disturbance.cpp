@@ -0,0 +1,246 @@
+#include "Disturbance.h"
+#include "Goertzel.h"
+#include "NanoComm.h"
+#include "Rollups.h"
+#include "Spectrum.h"
+
+#include <math.h>
+
+#if ENABLE_DISTURBANCE
+
+namespace Disturbance {
+
+// Per-refresh accumulators
+static uint16_t n = 0;
+static double   sumAsym = 0.0;
+static double   sumAsym2 = 0.0;
+static double   sumBeat = 0.0;
+static double   s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0;   // residual power sums
+static uint16_t outliers = 0;
+
+static double   refPeriodUs = 0.0;
+static bool     haveRef = false;
+static uint16_t lastDropped = 0;
+static bool     haveSample = false;
+
+static DisturbanceFeatures feat;
+static float    scores[PROFILE_COUNT];
+static DisturbanceProfile current = PROFILE_UNKNOWN;
+static float    conf = 0.0f;
+static uint32_t refreshCount = 0;
+
+static void clearWindow() {
+  n = 0;
+  sumAsym = sumAsym2 = sumBeat = 0.0;
+  s1 = s2 = s3 = s4 = 0.0;
+  outliers = 0;
+}
+
+void reset() {
+  clearWindow();
+  haveRef = false;
+  haveSample = false;
+  feat = DisturbanceFeatures();
+  for (uint8_t i = 0; i < PROFILE_COUNT; ++i) scores[i] = 0.0f;
+  current = PROFILE_UNKNOWN;
+  conf = 0.0f;
+  refreshCount = 0;
+}
+
+// Maps a feature level to 0..1, reaching 0.5 at `ref`.
+static float saturate(float x, float ref) {
+  return x > 0.0f ? x / (x + ref) : 0.0f;
+}
+
+static void blend(float &f, float v, float w) { f += (v - f) * w; }
+
+// Swing period in seconds, the sample interval of the residual series.
+static float tau0Seconds() {
+  return haveRef ? (float)(refPeriodUs * 1e-6) : 0.0f;
+}
+
+static void scanLines() {
+  feat.line_ratio = 0.0f;
+  feat.line_period_swings = 0.0f;
+#if ENABLE_PSD
+  SpectrumPeak pk;
+  if (Spectrum::peaks(&pk, 1) == 1) {
+    uint16_t half = Spectrum::segmentLength() / 2;
+    double sum = 0.0;
+    for (uint16_t k = 1; k <= half; ++k) {
+      if (k != pk.bin) sum += Spectrum::psd(k);
+    }
+    double mean = half > 1 ? sum / (double)(half - 1) : 0.0;
+    if (mean > 0.0) {
+      feat.line_ratio = (float)(pk.psd / mean);
+      feat.line_period_swings = pk.period_swings;
+    }
+  }
+#endif
+
+  // Goertzel amplitude over its own noise floor: with an exponential window of
+  // weight a = tau0/tau, white residual of sigma s reads about s*sqrt(a).
+  feat.tone_snr = 0.0f;
+  feat.tone_period_s = 0.0f;
+#if ENABLE_GOERTZEL
+  float a = tau0Seconds() / Goertzel::timeConstantS();
+  if (feat.residual_sigma_us > 0.0f && a > 0.0f) {
+    float floorUs = feat.residual_sigma_us * sqrtf(a < 1.0f ? a : 1.0f);
+    GoertzelResult g;
+    for (uint8_t i = 0; Goertzel::bin(i, g); ++i) {
+      if (g.aliased) continue;
+      float r = g.amplitude_us / floorUs;
+      if (r > feat.tone_snr) {
+        feat.tone_snr = r;
+        feat.tone_period_s = g.period_s / (float)g.harmonic;
+      }
+    }
+  }
+#endif
+}
+
+static void refresh() {
+  double dn = (double)n;
+  double aMean = sumAsym / dn;
+  double aVar = sumAsym2 / dn - aMean * aMean;
+  double aSe = aVar > 0.0 ? sqrt(aVar / dn) : 0.0;
+
+  double m = s1 / dn;
+  double c2 = s2 / dn - m * m;
+  double c4 = s4 / dn - 4.0 * m * s3 / dn + 6.0 * m * m * s2 / dn - 3.0 * m * m * m * m;
+  double kurt = c2 > 0.0 ? c4 / (c2 * c2) - 3.0 : 0.0;
+
+  float w = refreshCount ? 1.0f / (float)(1u << DISTURB_SMOOTH_SHIFT) : 1.0f;
+  blend(feat.asymmetry, (float)aMean, w);
+  blend(feat.asymmetry_t, aSe > 0.0 ? (float)(fabs(aMean) / aSe) : 0.0f, w);
+  blend(feat.beat_us, (float)(sumBeat / dn), w);
+  blend(feat.residual_sigma_us, c2 > 0.0 ? (float)sqrt(c2) : 0.0f, w);
+  blend(feat.excess_kurtosis, (float)kurt, w);
+  blend(feat.outlier_rate, (float)outliers / (float)n, w);
+  scanLines();
+
+  // Minute rates are too noisy for a slope; use the hour tier once it has a few entries.
+  feat.drift_s_per_day2 = 0.0f;
+#if ENABLE_ROLLUPS
+  RollupTrend t;
+  if (Rollups::trend(Rollups::Hour, 0, t) && t.entries >= DISTURB_DRIFT_MIN_HOURS &&
+      fabsf(t.drift_s_per_day2) > 3.0f * t.drift_stderr) {
+    feat.drift_s_per_day2 = t.drift_s_per_day2;
+  }
+#endif
+
+  float asym = feat.asymmetry_t >= DISTURB_ASYM_MIN_T ? fabsf(feat.asymmetry) : 0.0f;
+  float em = saturate(asym, DISTURB_ASYM_REF);
+  float line = saturate(feat.line_ratio - 1.0f, DISTURB_LINE_REF);
+  float tone = saturate(feat.tone_snr - DISTURB_TONE_SNR_MIN, DISTURB_TONE_REF);
+  if (tone > line) line = tone;
+  float impulse = saturate(feat.excess_kurtosis, DISTURB_KURT_REF);
+
+  scores[PROFILE_UNKNOWN] = 0.0f;
+  scores[PROFILE_CONSTANT_FORCE] = (1.0f - em) * (1.0f - line) * (1.0f - impulse);
+  scores[PROFILE_PER_SWING_EM] = em;
+  scores[PROFILE_PERIODIC_KICK] = line;
+  scores[PROFILE_HIPP_RANDOM] = impulse * (1.0f - line);   // kicks are impulsive too
+
+  float total = 0.0f;
+  current = PROFILE_CONSTANT_FORCE;
+  for (uint8_t p = PROFILE_CONSTANT_FORCE; p < PROFILE_COUNT; ++p) {
+    total += scores[p];
+    if (scores[p] > scores[current]) current = (DisturbanceProfile)p;
+  }
+  conf = total > 0.0f ? scores[current] / total : 0.0f;
+  refreshCount++;
+}
+
+void update(const PendulumSample &sample) {
+  uint32_t blockTicks = sample.tick_block + sample.tock_block;
+  uint32_t ticks = sample.tick + sample.tock + blockTicks;
+  if (ticks == 0) return;
+
+  bool dropped = haveSample && sample.dropped_events != lastDropped;
+  lastDropped = sample.dropped_events;
+  haveSample = true;
+  if (dropped) return;
+
+  double periodUs = NanoComm::ticksToSeconds(ticks, sample.corr_blend_ppm) * 1e6;
+  if (!haveRef) {
+    refPeriodUs = periodUs;
+    haveRef = true;
+  }
+  double r = periodUs - refPeriodUs;
+  refPeriodUs += r / (double)(1u << HIST_REF_SHIFT);
+
+  if (blockTicks) {
+    double a = ((double)sample.tick_block - (double)sample.tock_block) / (double)blockTicks;
+    sumAsym += a;
+    sumAsym2 += a * a;
+  }
+  sumBeat += ((double)sample.tick - (double)sample.tock) * NanoComm::ticksToSeconds(1, sample.corr_blend_ppm) * 1e6;
+  double r2 = r * r;
+  s1 += r;
+  s2 += r2;
+  s3 += r2 * r;
+  s4 += r2 * r2;
+  if (refreshCount && fabs(r) > DISTURB_OUTLIER_SIGMA * feat.residual_sigma_us) outliers++;
+
+  if (++n >= DISTURB_REFRESH_SWINGS) {
+    refresh();
+    clearWindow();
+  }
+}
+
+DisturbanceProfile profile() { return current; }
+float confidence() { return conf; }
+float score(DisturbanceProfile p) { return p < PROFILE_COUNT ? scores[p] : 0.0f; }
+uint32_t refreshes() { return refreshCount; }
+const DisturbanceFeatures &features() { return feat; }
+
+DisturbancePreset preset() {
+  DisturbancePreset out = { DEFAULT_STATS_WINDOW, false };
+  uint16_t maxWin = STATS_SHORT_WINDOW_MAX;
+  switch (current) {
+    case PROFILE_CONSTANT_FORCE:
+      out.stats_window = maxWin;
+      break;
+    case PROFILE_PER_SWING_EM:
+      out.stats_window = (uint16_t)(maxWin & ~1u);   // whole odd/even pairs
+      break;
+    case PROFILE_PERIODIC_KICK: {
+      // A whole number of kick cycles, so each window sees the same kicks.
+      float swings = feat.line_period_swings;
+      float tau0 = tau0Seconds();
+      if (feat.tone_period_s > 0.0f && tau0 > 0.0f &&
+          saturate(feat.tone_snr - DISTURB_TONE_SNR_MIN, DISTURB_TONE_REF) >=
+          saturate(feat.line_ratio - 1.0f, DISTURB_LINE_REF)) {
+        swings = feat.tone_period_s / tau0;
+      }
+      uint16_t cycle = (uint16_t)(swings + 0.5f);
+      out.stats_window = (cycle >= 2 && cycle <= maxWin) ? (uint16_t)(maxWin / cycle * cycle) : maxWin;
+      break;
+    }
+    case PROFILE_HIPP_RANDOM:
+      out.stats_window = maxWin;
+      out.robust = true;
+      break;
+    default:
+      return out;
+  }
+  if (fabsf(feat.drift_s_per_day2) >= DISTURB_DRIFT_FAST && out.stats_window >= 32) {
+    out.stats_window /= 2;   // follow the drift rather than average over it
+  }
+  return out;
+}
+
+const char *name(DisturbanceProfile p) {
+  switch (p) {
+    case PROFILE_CONSTANT_FORCE: return "constant_force";
+    case PROFILE_PER_SWING_EM:   return "per_swing_em";
+    case PROFILE_PERIODIC_KICK:  return "periodic_kick";
+    case PROFILE_HIPP_RANDOM:    return "hipp_random";
+    default:                     return "unknown";
+  }
+}
+
+} // namespace Disturbance
+
+#endif // ENABLE_DISTURBANCE
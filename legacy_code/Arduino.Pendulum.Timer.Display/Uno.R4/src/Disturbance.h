@@ -0,0 +1,65 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// Disturbance.h
+// Classifies how the pendulum is being driven from its own timing, and
+// suggests a stats windowing preset to match.
+//
+// Features, accumulated per swing and scored every DISTURB_REFRESH_SWINGS:
+//   odd/even  - asymmetry of the two beam passes, (tick_block - tock_block) /
+//               (tick_block + tock_block); an impulse given on one half-swing
+//               only makes the two pass speeds differ
+//   line      - strongest Spectrum peak over the mean PSD, and the largest
+//               Goertzel bin amplitude over its noise floor
+//   impulse   - excess kurtosis and outlier rate of the period residual
+//   drift     - rate trend of the hour rollups, when significant
+//
+// Profiles: constant-force (none of the above), per-swing EM (odd/even),
+// periodic kick (a spectral line), Hipp-style random (impulsive with no line).
+// Confidence is the winning score over the sum of all scores. Each swing is
+// O(1); a refresh scans the PSD once, O(PSD_SEGMENT_LEN/2).
+// -----------------------------------------------------------------------------
+
+#include "Config.h"
+#include "PendulumProtocol.h"
+
+enum DisturbanceProfile : uint8_t {
+  PROFILE_UNKNOWN = 0,
+  PROFILE_CONSTANT_FORCE,
+  PROFILE_PER_SWING_EM,
+  PROFILE_PERIODIC_KICK,
+  PROFILE_HIPP_RANDOM,
+  PROFILE_COUNT
+};
+
+struct DisturbanceFeatures {
+  float asymmetry;          // mean pass-speed asymmetry, fraction
+  float asymmetry_t;        // asymmetry / its standard error
+  float beat_us;            // mean tick - tock
+  float line_ratio;         // strongest spectral peak / mean PSD
+  float line_period_swings; // period of that peak
+  float tone_snr;           // largest Goertzel amplitude / its noise floor
+  float tone_period_s;
+  float residual_sigma_us;
+  float excess_kurtosis;
+  float outlier_rate;       // fraction of swings beyond DISTURB_OUTLIER_SIGMA
+  float drift_s_per_day2;   // 0 until the hour rollups show a significant trend
+};
+
+struct DisturbancePreset {
+  uint16_t stats_window;    // suggested short window, swings
+  bool     robust;          // prefer the median-of-means headline
+};
+
+namespace Disturbance {
+  void reset();
+  void update(const PendulumSample &sample);
+
+  DisturbanceProfile profile();
+  float confidence();
+  float score(DisturbanceProfile p);   // 0..1, before normalisation
+  uint32_t refreshes();
+  const DisturbanceFeatures &features();
+  DisturbancePreset preset();
+  const char *name(DisturbanceProfile p);
+}
@@ -3,6 +3,8 @@
 #include "EEPROMConfig.h"
 
 static_assert(sizeof(UnoConfig) <= 64, "UnoConfig must fit EEPROM slot");
+static_assert(sizeof(AnalysisConfig) <= 64, "AnalysisConfig must fit EEPROM slot");
+static_assert(sizeof(EnvModelRecord) <= 64, "EnvModelRecord must fit EEPROM slot");
 
 uint16_t computeCRC16(const uint8_t* data, size_t len) {
   uint16_t crc = 0x0000;
@@ -25,8 +27,20 @@ static uint16_t crcUnoConfig(UnoConfig cfg) {
   return computeCRC16(reinterpret_cast<const uint8_t*>(&cfg), sizeof(cfg));
 }
 
+static uint16_t crcAnalysisConfig(AnalysisConfig cfg) {
+  cfg.crc16 = 0;
+  return computeCRC16(reinterpret_cast<const uint8_t*>(&cfg), sizeof(cfg));
+}
+
+static uint16_t crcEnvModel(EnvModelRecord rec) {
+  rec.crc16 = 0;
+  return computeCRC16(reinterpret_cast<const uint8_t*>(&rec), sizeof(rec));
+}
+
 static uint32_t currentSeqShared = 0;
 static uint32_t currentSeqUno    = 0;
+static uint32_t currentSeqAnalysis = 0;
+static uint32_t currentSeqEnv = 0;
 
 TunableConfig getCurrentConfig() {
   TunableConfig cfg;
@@ -46,7 +60,7 @@ UnoConfig getCurrentUnoConfig() {
   cfg.metricsPeriodMs    = UnoTunables::metricsPeriodMs;
   cfg.statsWindowSize    = UnoTunables::statsWindowSize;
   cfg.rollingWindowMs    = UnoTunables::rollingWindowMs;
-  cfg.blockJumpUs        = UnoTunables::blockJumpUs;
+  cfg.blockJumpUs        = 0;
   cfg.minEdgeSepTicks    = UnoTunables::minEdgeSepTicks;
   cfg.txBatchSize        = UnoTunables::txBatchSize;
   cfg.ringSize           = UnoTunables::ringSize;
@@ -57,6 +71,9 @@ UnoConfig getCurrentUnoConfig() {
   cfg.logAppend          = UnoTunables::logAppend;
   strncpy(cfg.logBaseName, UnoTunables::logBaseName, LOG_FILENAME_LEN);
   cfg.logBaseName[LOG_FILENAME_LEN-1] = 0;
+  cfg.logFormat          = UnoTunables::logFormat;
+  cfg.logSizeRotate      = UnoTunables::logSizeRotate ? 1 : 0;
+  cfg.logRotateMB        = UnoTunables::logRotateMB;
   cfg.seq                = currentSeqUno;
   cfg.crc16              = crcUnoConfig(cfg);
   return cfg;
@@ -74,7 +91,6 @@ void applyUnoConfig(const UnoConfig &cfg) {
   UnoTunables::metricsPeriodMs    = cfg.metricsPeriodMs;
   UnoTunables::statsWindowSize    = cfg.statsWindowSize;
   UnoTunables::rollingWindowMs    = cfg.rollingWindowMs;
-  UnoTunables::blockJumpUs        = cfg.blockJumpUs;
   UnoTunables::minEdgeSepTicks    = cfg.minEdgeSepTicks;
   UnoTunables::txBatchSize        = cfg.txBatchSize;
   UnoTunables::ringSize           = cfg.ringSize;
@@ -85,6 +101,9 @@ void applyUnoConfig(const UnoConfig &cfg) {
   UnoTunables::logAppend          = cfg.logAppend;
   strncpy(UnoTunables::logBaseName, cfg.logBaseName, LOG_FILENAME_LEN);
   UnoTunables::logBaseName[LOG_FILENAME_LEN-1] = 0;
+  UnoTunables::logFormat          = cfg.logFormat == 1 ? 1 : 0;
+  UnoTunables::logSizeRotate      = cfg.logSizeRotate == 1;
+  UnoTunables::logRotateMB        = (cfg.logSizeRotate == 1 && cfg.logRotateMB) ? cfg.logRotateMB : LOG_ROTATE_MB_DEFAULT;
 }
 
 bool loadConfig(TunableConfig &out, UnoConfig &unoOut) {
@@ -223,6 +242,9 @@ bool loadConfig(TunableConfig &out, UnoConfig &unoOut) {
     unoOut.logAppend          = LOG_APPEND_DEFAULT;
     strncpy(unoOut.logBaseName, LOG_FILENAME, LOG_FILENAME_LEN);
     unoOut.logBaseName[LOG_FILENAME_LEN-1] = 0;
+    unoOut.logFormat          = LOG_FORMAT_DEFAULT;
+    unoOut.logSizeRotate      = LOG_SIZE_ROTATE_DEFAULT ? 1 : 0;
+    unoOut.logRotateMB        = LOG_ROTATE_MB_DEFAULT;
     unoOut.seq                = best.seq;
     unoOut.crc16              = crcUnoConfig(unoOut);
 
@@ -254,3 +276,79 @@ void saveConfig(TunableConfig cfg, UnoConfig unoCfg) {
   EEPROM.put(addrUno, unoCfg);
   toggle = !toggle;
 }
+
+AnalysisConfig getCurrentAnalysisConfig() {
+  AnalysisConfig cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.statsLongWindow = AnalysisTunables::statsLongWindow;
+  cfg.momBlockLen     = AnalysisTunables::momBlockLen;
+  cfg.momBlocks       = AnalysisTunables::momBlocks;
+  cfg.nominalPeriodUs = AnalysisTunables::nominalPeriodUs;
+  cfg.psdSegmentLen   = AnalysisTunables::psdSegmentLen;
+  cfg.seq             = currentSeqAnalysis;
+  cfg.crc16           = crcAnalysisConfig(cfg);
+  return cfg;
+}
+
+void applyAnalysisConfig(const AnalysisConfig &cfg) {
+  AnalysisTunables::statsLongWindow = cfg.statsLongWindow;
+  AnalysisTunables::momBlockLen     = cfg.momBlockLen;
+  AnalysisTunables::momBlocks       = cfg.momBlocks;
+  AnalysisTunables::nominalPeriodUs = cfg.nominalPeriodUs;
+  AnalysisTunables::psdSegmentLen   = cfg.psdSegmentLen ? cfg.psdSegmentLen : PSD_SEGMENT_LEN;
+}
+
+bool loadAnalysisConfig(AnalysisConfig &out) {
+  AnalysisConfig a, b;
+  EEPROM.get(EEPROM_ANALYSIS_SLOT_A_ADDR, a);
+  EEPROM.get(EEPROM_ANALYSIS_SLOT_B_ADDR, b);
+  bool validA = (crcAnalysisConfig(a) == a.crc16);
+  bool validB = (crcAnalysisConfig(b) == b.crc16);
+  if (validA && validB) {
+    out = (b.seq > a.seq) ? b : a;
+  } else if (validA) {
+    out = a;
+  } else if (validB) {
+    out = b;
+  } else {
+    currentSeqAnalysis = 0;
+    return false;
+  }
+  currentSeqAnalysis = out.seq;
+  return true;
+}
+
+void saveAnalysisConfig(AnalysisConfig cfg) {
+  cfg.seq = ++currentSeqAnalysis;
+  cfg.crc16 = crcAnalysisConfig(cfg);
+  int addr = (cfg.seq & 1u) ? EEPROM_ANALYSIS_SLOT_A_ADDR : EEPROM_ANALYSIS_SLOT_B_ADDR;
+  EEPROM.put(addr, cfg);
+}
+
+bool loadEnvModel(EnvModelRecord &out) {
+  EnvModelRecord a, b;
+  EEPROM.get(EEPROM_ENV_SLOT_A_ADDR, a);
+  EEPROM.get(EEPROM_ENV_SLOT_B_ADDR, b);
+  bool validA = (crcEnvModel(a) == a.crc16);
+  bool validB = (crcEnvModel(b) == b.crc16);
+  if (validA && validB) {
+    out = (b.seq > a.seq) ? b : a;
+  } else if (validA) {
+    out = a;
+  } else if (validB) {
+    out = b;
+  } else {
+    currentSeqEnv = 0;
+    return false;
+  }
+  currentSeqEnv = out.seq;
+  return true;
+}
+
+void saveEnvModel(EnvModelRecord rec) {
+  rec.seq = ++currentSeqEnv;
+  rec.reserved = 0;
+  rec.crc16 = crcEnvModel(rec);
+  int addr = (rec.seq & 1u) ? EEPROM_ENV_SLOT_A_ADDR : EEPROM_ENV_SLOT_B_ADDR;
+  EEPROM.put(addr, rec);
+}
@@ -10,4 +10,12 @@ void applyUnoConfig(const UnoConfig &cfg);
 
 bool loadConfig(TunableConfig &sharedOut, UnoConfig &unoOut);
 void saveConfig(TunableConfig sharedCfg, UnoConfig unoCfg);
+
+AnalysisConfig getCurrentAnalysisConfig();
+void applyAnalysisConfig(const AnalysisConfig &cfg);
+bool loadAnalysisConfig(AnalysisConfig &out);
+void saveAnalysisConfig(AnalysisConfig cfg);
 uint16_t computeCRC16(const uint8_t* data, size_t len);
+
+bool loadEnvModel(EnvModelRecord &out);
+void saveEnvModel(EnvModelRecord rec);
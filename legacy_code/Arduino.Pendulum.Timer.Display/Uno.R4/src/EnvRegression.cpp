@@ -0,0 +1,159 @@
+#include "EnvRegression.h"
+#include "EEPROMConfig.h"
+#include "NanoComm.h"
+
+#include <math.h>
+
+#if ENABLE_ENV_REGRESSION
+
+namespace EnvRegression {
+
+static constexpr uint8_t P = 4;
+
+static double   theta[P];
+static double   cov[P][P];
+static double   residVar = 0.0;
+static double   refPeriodUs = 0.0;
+static uint32_t samples = 0;
+static EnvFit   current = {};
+static uint16_t lastDropped = 0;
+static bool     haveSample = false;
+static uint32_t lastSaveMs = 0;
+
+static void initCovariance(const float *diag) {
+  for (uint8_t i = 0; i < P; ++i) {
+    for (uint8_t j = 0; j < P; ++j) cov[i][j] = 0.0;
+    cov[i][i] = diag ? (double)diag[i] : ENV_RLS_P0;
+  }
+}
+
+static void publish() {
+  for (uint8_t i = 0; i < P; ++i) {
+    current.coef[i] = (float)theta[i];
+    current.std_err[i] = (float)sqrt(residVar * cov[i][i]);
+  }
+  current.resid_ppm = (float)sqrt(residVar);
+  current.ref_period_us = refPeriodUs;
+  current.samples = samples;
+}
+
+void reset() {
+  for (uint8_t i = 0; i < P; ++i) theta[i] = 0.0;
+  initCovariance(nullptr);
+  residVar = 0.0;
+  refPeriodUs = 0.0;
+  samples = 0;
+  haveSample = false;
+  current = {};
+  publish();
+}
+
+void begin() {
+  reset();
+  EnvModelRecord rec;
+  if (loadEnvModel(rec) && rec.refPeriodUs > 0.0) {
+    for (uint8_t i = 0; i < P; ++i) theta[i] = rec.theta[i];
+    initCovariance(rec.pDiag);
+    residVar = rec.residVar;
+    refPeriodUs = rec.refPeriodUs;
+    samples = rec.samples;
+    current.restored = true;
+    publish();
+  }
+  lastSaveMs = millis();
+}
+
+void save() {
+  EnvModelRecord rec = {};
+  rec.refPeriodUs = refPeriodUs;
+  for (uint8_t i = 0; i < P; ++i) {
+    rec.theta[i] = (float)theta[i];
+    rec.pDiag[i] = (float)cov[i][i];
+  }
+  rec.residVar = (float)residVar;
+  rec.samples = samples;
+  saveEnvModel(rec);
+  lastSaveMs = millis();
+}
+
+static bool centred(float v, float centre, double &x) {
+  if (!isfinite(v)) return false;
+  x = (double)(v - centre);
+  return true;
+}
+
+void update(const PendulumSample &sample) {
+  uint32_t ticks = sample.tick + sample.tock + sample.tick_block + sample.tock_block;
+  if (ticks == 0) return;
+  bool dropped = haveSample && sample.dropped_events != lastDropped;
+  lastDropped = sample.dropped_events;
+  haveSample = true;
+  if (dropped) return;
+
+  double periodUs = NanoComm::ticksToSeconds(ticks, sample.corr_blend_ppm) * 1e6;
+  if (refPeriodUs <= 0.0) refPeriodUs = periodUs;
+  double y = (periodUs / refPeriodUs - 1.0) * 1e6;
+  double x[P] = {1.0, 0.0, 0.0, 0.0};
+  bool present[P] = {
+    true,
+    centred(sample.temperature_C, ENV_CENTER_TEMP_C, x[1]),
+    centred(sample.humidity_pct, ENV_CENTER_HUM_PCT, x[2]),
+    centred(sample.pressure_hPa, ENV_CENTER_PRESS_HPA, x[3]),
+  };
+
+  // k = P x / (lambda + x' P x); theta += k e; P = (P - k x' P) / lambda.
+  // A missing regressor's row and column are left out: correlation through
+  // P would otherwise still move its coefficient on a reading it never had.
+  double px[P];
+  double denom = ENV_RLS_LAMBDA;
+  double e = y;
+  for (uint8_t i = 0; i < P; ++i) {
+    px[i] = 0.0;
+    if (!present[i]) continue;
+    for (uint8_t j = 0; j < P; ++j) {
+      if (present[j]) px[i] += cov[i][j] * x[j];
+    }
+    denom += x[i] * px[i];
+    e -= theta[i] * x[i];
+  }
+  for (uint8_t i = 0; i < P; ++i) {
+    if (present[i]) theta[i] += px[i] / denom * e;
+  }
+  // Without excitation (e.g. a steady room) dividing by lambda grows P without
+  // bound; skip the forgetting step once any variance reaches ENV_RLS_P_MAX.
+  double maxDiag = 0.0;
+  for (uint8_t i = 0; i < P; ++i) {
+    if (!present[i]) continue;
+    for (uint8_t j = i; j < P; ++j) {
+      if (!present[j]) continue;
+      double v = cov[i][j] - px[i] * px[j] / denom;
+      cov[i][j] = v;
+      cov[j][i] = v;
+    }
+    if (cov[i][i] > maxDiag) maxDiag = cov[i][i];
+  }
+  if (maxDiag < ENV_RLS_P_MAX * ENV_RLS_LAMBDA) {
+    for (uint8_t i = 0; i < P; ++i) {
+      if (!present[i]) continue;
+      for (uint8_t j = 0; j < P; ++j) {
+        if (present[j]) cov[i][j] /= ENV_RLS_LAMBDA;
+      }
+    }
+  }
+  residVar = samples ? ENV_RLS_LAMBDA * residVar + (1.0 - ENV_RLS_LAMBDA) * e * e : e * e;
+  samples++;
+
+  double envTerm = 0.0;
+  for (uint8_t i = 1; i < P; ++i) envTerm += theta[i] * x[i];
+  current.raw_ppm = (float)y;
+  current.compensated_ppm = (float)(y - envTerm);
+  publish();
+
+  if (millis() - lastSaveMs >= ENV_SAVE_INTERVAL_MS) save();
+}
+
+const EnvFit &fit() { return current; }
+
+} // namespace EnvRegression
+
+#endif // ENABLE_ENV_REGRESSION
@@ -0,0 +1,36 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// EnvRegression.h
+// Online regression of the clock's rate deviation on its environment.
+//
+// Exponentially weighted recursive least squares of
+//   rate_ppm = b0 + b1*(T - T0) + b2*(RH - RH0) + b3*(P - P0)
+// with rate_ppm = (period / reference - 1) * 1e6 (positive = running slow).
+// O(p^2) per swing for p = 4, no allocation. A missing sensor's row and
+// column are left out of the update, so its coefficient and covariance hold
+// until it reads again. The model is
+// restored from EEPROM at begin() and saved periodically.
+// -----------------------------------------------------------------------------
+
+#include "Config.h"
+#include "PendulumProtocol.h"
+
+struct EnvFit {
+  float    coef[4];        // intercept ppm, ppm/degC, ppm/%RH, ppm/hPa
+  float    std_err[4];     // approximate standard error (sqrt(resid var * P_ii))
+  float    resid_ppm;      // RMS of the (a priori) residual
+  float    raw_ppm;        // latest rate deviation
+  float    compensated_ppm;// latest rate deviation minus the env terms
+  double   ref_period_us;
+  uint32_t samples;
+  bool     restored;       // model came from EEPROM
+};
+
+namespace EnvRegression {
+  void begin();
+  void reset();            // forget the model (EEPROM copy is replaced at the next save)
+  void update(const PendulumSample &sample);
+  void save();             // persist now
+  const EnvFit &fit();
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// FastFormat.h
+// Decimal formatting for the per-swing CSV row without the printf machinery.
+//
+// An Appender writes into a caller's buffer with snprintf's contract: it
+// never writes past `cap` bytes, always NUL-terminates (cap > 0), and
+// finish() returns the length the full text would have had, so callers keep
+// their "len >= size means truncated" checks.
+//
+// Integers are written two digits at a time from a 00..99 pair table. A
+// float's "%.2f" is built from its bits: mantissa * 100 shifted by the
+// exponent gives the hundredths, rounded to nearest with ties to even on the
+// exact binary value, which is what snprintf does. Only integer operations,
+// so no soft double on the R4. NaN, infinities and magnitudes of 2^23 and
+// above go to snprintf, so the output is the same for every float.
+// Kept free of Arduino dependencies so host tools can share the same code.
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace FastFormat {
+
+inline const char *digitPairs() {
+  static const char pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+  return pairs;
+}
+
+// Writes v so that it ends just before `end`; returns its first character.
+// `end` needs 10 bytes in front of it.
+inline char *u32Backwards(char *end, uint32_t v) {
+  const char *pairs = digitPairs();
+  char *p = end;
+  while (v >= 100) {
+    uint32_t r = v % 100;
+    v /= 100;
+    p -= 2;
+    memcpy(p, pairs + 2 * r, 2);
+  }
+  if (v >= 10) {
+    p -= 2;
+    memcpy(p, pairs + 2 * v, 2);
+  } else {
+    *--p = (char)('0' + v);
+  }
+  return p;
+}
+
+class Appender {
+public:
+  Appender(char *out, size_t cap) : out_(out), cap_(cap), len_(0) {}
+
+  void append(const char *s, size_t n) {
+    if (len_ + n < cap_) {
+      memcpy(out_ + len_, s, n);
+    } else if (len_ + 1 < cap_) {
+      memcpy(out_ + len_, s, cap_ - 1 - len_);
+    }
+    len_ += n;
+  }
+
+  void append(char c) { append(&c, 1); }
+
+  void appendU32(uint32_t v) {
+    char buf[10];
+    char *p = u32Backwards(buf + sizeof(buf), v);
+    append(p, (size_t)(buf + sizeof(buf) - p));
+  }
+
+  void appendI32(int32_t v) {
+    char buf[11];
+    uint32_t u = v < 0 ? 0u - (uint32_t)v : (uint32_t)v;
+    char *p = u32Backwards(buf + sizeof(buf), u);
+    if (v < 0) *--p = '-';
+    append(p, (size_t)(buf + sizeof(buf) - p));
+  }
+
+  // Same text as snprintf("%.2f", (double)f).
+  void appendFixed2(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    uint32_t exp = (bits >> 23) & 0xFF;
+    if (exp >= 127 + 23) {                    // >= 2^23, inf or nan
+      char buf[48];
+      int n = snprintf(buf, sizeof(buf), "%.2f", (double)f);
+      if (n > 0) append(buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+      return;
+    }
+    // |f| = mant * 2^-shift exactly, with shift >= 1 here.
+    uint32_t mant = exp ? ((bits & 0x7FFFFF) | 0x800000) : (bits & 0x7FFFFF);
+    uint32_t shift = 150 - (exp ? exp : 1);
+    uint64_t scaled = (uint64_t)mant * 100;  // < 2^31
+    uint32_t q = 0;
+    if (shift < 33) {                         // from 33 on it rounds to 0
+      q = (uint32_t)(scaled >> shift);
+      uint64_t rem = scaled & ((1ull << shift) - 1);
+      uint64_t half = 1ull << (shift - 1);
+      if (rem > half || (rem == half && (q & 1))) q++;
+    }
+    char buf[16];
+    char *end = buf + sizeof(buf);
+    char *p = end - 2;
+    memcpy(p, digitPairs() + 2 * (q % 100), 2);
+    *--p = '.';
+    p = u32Backwards(p, q / 100);
+    if (bits >> 31) *--p = '-';
+    append(p, (size_t)(end - p));
+  }
+
+  // NUL-terminates and returns the untruncated length.
+  int finish() {
+    if (cap_) out_[len_ < cap_ ? len_ : cap_ - 1] = 0;
+    return (int)len_;
+  }
+
+private:
+  char  *out_;
+  size_t cap_;
+  size_t len_;
+};
+
+}
@@ -0,0 +1,137 @@
+#include "Goertzel.h"
+#include "NanoComm.h"
+
+#include <math.h>
+
+#if ENABLE_GOERTZEL
+
+namespace Goertzel {
+
+static constexpr double TWO_PI_D = 6.283185307179586;
+
+struct Bin {
+  float   period_s;
+  uint8_t harmonic;
+  double  cycle;     // position within the fundamental, [0, 1)
+  float   re;        // exponentially averaged residual * e^{-j*phase}
+  float   im;
+};
+
+static Bin      bins[GOERTZEL_MAX_BINS];
+static uint8_t  count = 0;
+static float    tauS = GOERTZEL_TIME_CONSTANT_S;
+static double   meanUs = 0.0;
+static double   lastPeriodS = 0.0;
+static bool     haveMean = false;
+static uint16_t lastDropped = 0;
+static bool     haveSample = false;
+
+void begin() {
+  clear();
+  if (GOERTZEL_DEFAULT_PERIOD_S > 0.0f) {
+    addPeriod(GOERTZEL_DEFAULT_PERIOD_S, GOERTZEL_DEFAULT_HARMONICS);
+  }
+}
+
+void reset() {
+  for (uint8_t i = 0; i < count; ++i) {
+    bins[i].cycle = 0.0;
+    bins[i].re = 0.0f;
+    bins[i].im = 0.0f;
+  }
+  meanUs = 0.0;
+  lastPeriodS = 0.0;
+  haveMean = false;
+  haveSample = false;
+}
+
+void clear() {
+  count = 0;
+  reset();
+}
+
+bool addPeriod(float period_s, uint8_t harmonics) {
+  if (!(period_s > 0.0f) || harmonics == 0) return false;
+  if (count + harmonics > GOERTZEL_MAX_BINS) return false;
+  for (uint8_t h = 1; h <= harmonics; ++h) {
+    Bin &b = bins[count++];
+    b.period_s = period_s;
+    b.harmonic = h;
+    b.cycle = 0.0;
+    b.re = 0.0f;
+    b.im = 0.0f;
+  }
+  return true;
+}
+
+void setTimeConstantS(float tau_s) {
+  if (tau_s > 0.0f) tauS = tau_s;
+}
+
+float timeConstantS() { return tauS; }
+
+void update(const PendulumSample &sample) {
+  uint32_t ticks = sample.tick + sample.tock + sample.tick_block + sample.tock_block;
+  if (ticks == 0) return;
+  double period_s = NanoComm::ticksToSeconds(ticks, sample.corr_blend_ppm);
+
+  // After a dropped edge the period spans two swings: keep phase in step with
+  // elapsed time, but do not feed the bogus residual.
+  bool usable = !(haveSample && sample.dropped_events != lastDropped);
+  lastDropped = sample.dropped_events;
+  haveSample = true;
+
+  double alpha = period_s / (double)tauS;
+  if (alpha > 1.0) alpha = 1.0;
+  double periodUs = period_s * 1e6;
+  if (!haveMean) {
+    meanUs = periodUs;
+    haveMean = true;
+  }
+  double resid = periodUs - meanUs;
+
+  for (uint8_t i = 0; i < count; ++i) {
+    Bin &b = bins[i];
+    b.cycle += period_s / (double)b.period_s;
+    b.cycle -= floor(b.cycle);
+    if (!usable) continue;
+    double ph = TWO_PI_D * (double)b.harmonic * b.cycle;
+    b.re += (float)(alpha * (resid * cos(ph) - (double)b.re));
+    b.im += (float)(alpha * (-resid * sin(ph) - (double)b.im));
+  }
+  if (usable) {
+    meanUs += alpha * resid;
+    lastPeriodS = period_s;
+  }
+}
+
+float predictUs() {
+  if (lastPeriodS <= 0.0) return 0.0f;
+  double sum = 0.0;
+  for (uint8_t i = 0; i < count; ++i) {
+    const Bin &b = bins[i];
+    double cyc = b.cycle + lastPeriodS / (double)b.period_s;
+    double ph = TWO_PI_D * (double)b.harmonic * cyc;
+    // r = A cos(ph + theta) averages to (A/2) e^{j theta}; rebuild 2 Re{Z e^{j ph}}.
+    sum += 2.0 * ((double)b.re * cos(ph) - (double)b.im * sin(ph));
+  }
+  return (float)sum;
+}
+
+uint8_t binCount() { return count; }
+
+bool bin(uint8_t i, GoertzelResult &out) {
+  if (i >= count) return false;
+  const Bin &b = bins[i];
+  out.period_s = b.period_s;
+  out.harmonic = b.harmonic;
+  out.amplitude_us = 2.0f * sqrtf(b.re * b.re + b.im * b.im);
+  out.phase_deg = (float)(atan2((double)b.im, (double)b.re) * (360.0 / TWO_PI_D));
+  double hz = (double)b.harmonic / (double)b.period_s;
+  out.aliased = lastPeriodS > 0.0 && hz >= 0.5 / lastPeriodS;
+  return true;
+}
+
+} // namespace Goertzel
+
+#endif // ENABLE_GOERTZEL
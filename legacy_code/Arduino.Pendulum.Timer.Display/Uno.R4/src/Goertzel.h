@@ -0,0 +1,43 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// Goertzel.h
+// Detector bank for known periodic disturbances in the period residual.
+//
+// Each bin demodulates the residual (period minus its slow mean, in us) at a
+// fixed disturbance period P and harmonic h, e.g. a 30 s Synchronome kick or
+// a remontoire rewind. Swings are not uniformly spaced in time, so the phase
+// is advanced by the measured period rather than a fixed step. The bins use
+// an exponential window with time constant `tau`, which makes each update
+// O(1) per bin without keeping sample history.
+// -----------------------------------------------------------------------------
+
+#include "Config.h"
+#include "PendulumProtocol.h"
+
+struct GoertzelResult {
+  float   period_s;      // disturbance period of the fundamental
+  uint8_t harmonic;      // 1 = fundamental
+  float   amplitude_us;  // peak amplitude of this component
+  float   phase_deg;     // phase at the start of the fundamental cycle
+  bool    aliased;       // component frequency is above the swing Nyquist rate
+};
+
+namespace Goertzel {
+  void begin();   // loads the default bank from Config.h
+  void reset();
+  void clear();
+  // Add `period_s` and its harmonics 1..harmonics. False if the bank is full.
+  bool addPeriod(float period_s, uint8_t harmonics);
+  void setTimeConstantS(float tau_s);
+  float timeConstantS();
+
+  void update(const PendulumSample &sample);
+
+  // Sum of all tracked components extrapolated one swing ahead; subtract from
+  // the next residual for synchronous cancellation.
+  float predictUs();
+
+  uint8_t binCount();
+  bool bin(uint8_t i, GoertzelResult &out);
+}
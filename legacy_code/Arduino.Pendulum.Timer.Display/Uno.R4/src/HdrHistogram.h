@@ -0,0 +1,84 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// HdrHistogram.h
+// Signed log/linear bucketed histogram (HDR-style) in a fixed arena.
+//
+// Magnitudes below 2^SUB land in unit-wide buckets; above that each octave
+// [2^e, 2^(e+1)) is split into 2^SUB equal buckets, so the relative bucket
+// width stays at or below 2^-SUB. Magnitudes at or above 2^MAXBITS go to a
+// bucket of their own, the last of each sign (OVERFLOW_BUCKET), so they never
+// mix with the top octave. Buckets 0..PER_SIGN-1 hold values >= 0 and
+// PER_SIGN..2*PER_SIGN-1 hold negative values, by magnitude.
+//
+// Insert is O(1). Two histograms with the same layout merge by adding counts,
+// so snapshots can be rolled up hourly/daily elsewhere. Kept free of Arduino
+// dependencies.
+// -----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+template <uint8_t SUB, uint8_t MAXBITS>
+class HdrHistogram {
+public:
+  static_assert(SUB >= 1 && SUB < MAXBITS && MAXBITS <= 31, "invalid HdrHistogram layout");
+
+  static constexpr uint16_t SUB_COUNT = (uint16_t)(1u << SUB);
+  static constexpr uint16_t PER_SIGN  = (uint16_t)((MAXBITS - SUB + 1) * SUB_COUNT + 1);
+  static constexpr uint16_t OVERFLOW_BUCKET = (uint16_t)(PER_SIGN - 1);   // per sign
+  static constexpr uint16_t BUCKETS   = (uint16_t)(2 * PER_SIGN);
+
+  HdrHistogram() { clear(); }
+
+  void clear() {
+    for (uint16_t i = 0; i < BUCKETS; ++i) counts_[i] = 0;
+    total_ = 0;
+  }
+
+  static uint16_t bucketFor(int32_t v) {
+    uint32_t mag = v < 0 ? (uint32_t)(-(int64_t)v) : (uint32_t)v;
+    uint16_t idx;
+    if (mag < SUB_COUNT) {
+      idx = (uint16_t)mag;
+    } else {
+      uint8_t e = (uint8_t)(31 - __builtin_clz(mag));
+      if (e >= MAXBITS) {
+        idx = OVERFLOW_BUCKET;
+      } else {
+        uint16_t sub = (uint16_t)((mag >> (e - SUB)) & (SUB_COUNT - 1));
+        idx = (uint16_t)((e - SUB + 1) * SUB_COUNT + sub);
+      }
+    }
+    return v < 0 ? (uint16_t)(PER_SIGN + idx) : idx;
+  }
+
+  // Smallest magnitude mapped to bucket `b` (sign given by b >= PER_SIGN);
+  // 2^MAXBITS for OVERFLOW_BUCKET.
+  static uint32_t bucketLowerMagnitude(uint16_t b) {
+    uint16_t idx = b >= PER_SIGN ? (uint16_t)(b - PER_SIGN) : b;
+    if (idx < SUB_COUNT) return idx;
+    uint8_t e = (uint8_t)(idx / SUB_COUNT + SUB - 1);
+    return (uint32_t)(SUB_COUNT + idx % SUB_COUNT) << (e - SUB);
+  }
+
+  void add(int32_t v) {
+    uint16_t b = bucketFor(v);
+    if (counts_[b] != UINT32_MAX) counts_[b]++;
+    total_++;
+  }
+
+  void merge(const HdrHistogram &other) {
+    for (uint16_t i = 0; i < BUCKETS; ++i) {
+      uint32_t sum = counts_[i] + other.counts_[i];
+      counts_[i] = sum < counts_[i] ? UINT32_MAX : sum;
+    }
+    total_ += other.total_;
+  }
+
+  uint32_t count(uint16_t b) const { return b < BUCKETS ? counts_[b] : 0; }
+  uint32_t total() const { return total_; }
+
+private:
+  uint32_t counts_[BUCKETS];
+  uint32_t total_;
+};
@@ -1,10 +1,20 @@
 #include "HttpServer.h"
 #include "WiFiStorage.h"
 #include "SDLogger.h"
+#include "LogIndex.h"
+#include "BinLog.h"
 #include "Display.h"
 #include "EEPROMConfig.h"
 #include "NanoComm.h"
 #include "StatsEngine.h"
+#include "Cusum.h"
+#include "AllanDev.h"
+#include "Spectrum.h"
+#include "Goertzel.h"
+#include "DeviationHist.h"
+#include "EnvRegression.h"
+#include "Rollups.h"
+#include "Disturbance.h"
 #include "WiFiConfig.h"
 #include "ArduinoHttpServer.h"
 #include <SD.h>
@@ -28,7 +38,7 @@ static const char HOME_PAGE[] PROGMEM = R"rawliteral(<!DOCTYPE html><html><head>
 
 static const char NOT_FOUND_PAGE[] PROGMEM = R"rawliteral(<!DOCTYPE html><html><head><meta charset="utf-8"><title>Not Found</title></head><body><h2>404 - Not Found</h2><p>The requested resource could not be located.</p><a href='/' aria-label='Return to home page'>Home</a><hr><small>UNO R4 Pendulum Logger</small></body></html>)rawliteral";
 
-static const char STATS_PAGE[] PROGMEM = R"rawliteral(<!DOCTYPE html><html><head><meta charset="utf-8"><title>Stats</title><style>body{font-family:sans-serif;font-size:14px;}#meta{margin-bottom:8px;}pre{background:#f6f8fa;padding:8px;}</style></head><body><h2>Pendulum Stats</h2><div id='meta'>Loading...</div><pre id='vals'></pre><pre id='roll'></pre><script>function formatNum(v,dec){return isFinite(v)?v.toFixed(dec):'--';}function formatSig(v,sig){return isFinite(v)?Number(v).toPrecision(sig):'--';}function update(){Promise.all([fetch('/json'),fetch('/stats.json')]).then(r=>Promise.all(r.map(x=>x.json()))).then(([sample,stats])=>{const tick=+sample.tick_us,tock=+sample.tock_us,tb=+sample.tick_block_us,sb=+sample.tock_block_us;const period=tick+tb+tock+sb;const bpmNow=period?60000000/period:0;const cap=stats.window_capacity||stats.window_size;const requested=stats.window_size;const windowLabel=cap===requested?`${cap}`:`${cap} (requested ${requested})`;document.getElementById('meta').textContent=`Data units: ${stats.data_units} | window: ${stats.samples}/${windowLabel} samples (${stats.rolling_window_ms} ms) | block jump reset: ${stats.block_jump_us} µs`;document.getElementById('vals').textContent=`tick_us: ${tick}\ntock_us: ${tock}\ntick_block_us: ${tb}\ntock_block_us: ${sb}\nperiod_us: ${period}\n\ndelta_beat_us: ${tick-tock}\ndelta_block_us: ${tb-sb}\nbpm: ${formatNum(bpmNow,2)}\ncorr_inst_ppm: ${sample.corr_inst_ppm}\ncorr_blend_ppm: ${sample.corr_blend_ppm}\ngps_status: ${sample.gps_status}\ndropped_events: ${sample.dropped_events}\ntemperature_C: ${formatNum(sample.temperature_C,2)}\nhumidity_pct: ${formatNum(sample.humidity_pct,2)}\npressure_hPa: ${formatNum(sample.pressure_hPa,2)}`;document.getElementById('roll').textContent=`Rolling stats (avg over latest ${stats.samples} samples)\navg_bpm: ${formatSig(stats.avg_bpm,5)}\nstddev_bpm: ${formatSig(stats.stddev_bpm,5)}\navg_period_us: ${formatNum(stats.avg_period_us,1)}\nstddev_period_us: ${formatNum(stats.stddev_period_us,1)}\navg_delta_beat (${stats.data_units}): ${formatNum(stats.avg_delta_beat,1)}\nstddev_delta_beat (${stats.data_units}): ${formatNum(stats.stddev_delta_beat,1)}\navg_delta_block (${stats.data_units}): ${formatNum(stats.avg_delta_block,1)}\nstddev_delta_block (${stats.data_units}): ${formatNum(stats.stddev_delta_block,1)}\navg_block_jump (${stats.data_units}): ${formatNum(stats.avg_block_jump,1)}\nstddev_block_jump (${stats.data_units}): ${formatNum(stats.stddev_block_jump,1)}`;}).catch(()=>{document.getElementById('meta').textContent='Waiting for samples...';});}setInterval(update,1000);update();</script><a href='/'>Home</a><hr><small>UNO R4 Pendulum Logger</small></body></html>)rawliteral";
+static const char STATS_PAGE[] PROGMEM = R"rawliteral(<!DOCTYPE html><html><head><meta charset="utf-8"><title>Stats</title><style>body{font-family:sans-serif;font-size:14px;}#meta{margin-bottom:8px;}pre{background:#f6f8fa;padding:8px;}</style></head><body><h2>Pendulum Stats</h2><div id='meta'>Loading...</div><pre id='vals'></pre><pre id='roll'></pre><script>function formatNum(v,dec){return isFinite(v)?v.toFixed(dec):'--';}function formatSig(v,sig){return isFinite(v)?Number(v).toPrecision(sig):'--';}function update(){Promise.all([fetch('/json'),fetch('/stats.json')]).then(r=>Promise.all(r.map(x=>x.json()))).then(([sample,stats])=>{const tick=+sample.tick_us,tock=+sample.tock_us,tb=+sample.tick_block_us,sb=+sample.tock_block_us;const period=tick+tb+tock+sb;const bpmNow=period?60000000/period:0;const cap=stats.window_capacity||stats.window_size;const requested=stats.window_size;const windowLabel=cap===requested?`${cap}`:`${cap} (requested ${requested})`;document.getElementById('meta').textContent=`Data units: ${stats.data_units} | window: ${stats.samples}/${windowLabel} samples (${stats.rolling_window_ms} ms)`;document.getElementById('vals').textContent=`tick_us: ${tick}\ntock_us: ${tock}\ntick_block_us: ${tb}\ntock_block_us: ${sb}\nperiod_us: ${period}\n\ndelta_beat_us: ${tick-tock}\ndelta_block_us: ${tb-sb}\nbpm: ${formatNum(bpmNow,2)}\ncorr_inst_ppm: ${sample.corr_inst_ppm}\ncorr_blend_ppm: ${sample.corr_blend_ppm}\ngps_status: ${sample.gps_status}\ndropped_events: ${sample.dropped_events}\ntemperature_C: ${formatNum(sample.temperature_C,2)}\nhumidity_pct: ${formatNum(sample.humidity_pct,2)}\npressure_hPa: ${formatNum(sample.pressure_hPa,2)}`;document.getElementById('roll').textContent=`Rolling stats (avg over latest ${stats.samples} samples)\navg_bpm: ${formatSig(stats.avg_bpm,5)}\nstddev_bpm: ${formatSig(stats.stddev_bpm,5)}\navg_period_us: ${formatNum(stats.avg_period_us,1)}\nstddev_period_us: ${formatNum(stats.stddev_period_us,1)}\navg_delta_beat (${stats.data_units}): ${formatNum(stats.avg_delta_beat,1)}\nstddev_delta_beat (${stats.data_units}): ${formatNum(stats.stddev_delta_beat,1)}\navg_delta_block (${stats.data_units}): ${formatNum(stats.avg_delta_block,1)}\nstddev_delta_block (${stats.data_units}): ${formatNum(stats.stddev_delta_block,1)}\navg_block_jump (${stats.data_units}): ${formatNum(stats.avg_block_jump,1)}\nstddev_block_jump (${stats.data_units}): ${formatNum(stats.stddev_block_jump,1)}`;}).catch(()=>{document.getElementById('meta').textContent='Waiting for samples...';});}setInterval(update,1000);update();</script><a href='/'>Home</a><hr><small>UNO R4 Pendulum Logger</small></body></html>)rawliteral";
 
 static const char* dataUnitsLabel() {
   switch (NanoComm::getDataUnits()) {
@@ -132,9 +142,11 @@ static void sendNotFound(HttpResponse& response) {
 
 static void sendStatsJson(HttpResponse& response) {
   const RollingStats &st = StatsEngine::get();
-  char buf[512];
+  const RollingStats &lt = StatsEngine::get(StatsEngine::STATS_WINDOW_LONG);
+  const RobustStats &rb = StatsEngine::robust();
+  char buf[1280];
   int len = snprintf(buf, sizeof(buf),
-    "{\"bpm\":%.3f,\"delta_beat\":%.3f,\"delta_block\":%.3f,\"avg_bpm\":%.5g,\"avg_delta_beat\":%.3f,\"avg_delta_block\":%.3f,\"avg_block_jump\":%.3f,\"avg_period_us\":%.1f,\"stddev_bpm\":%.5g,\"stddev_delta_beat\":%.3f,\"stddev_delta_block\":%.3f,\"stddev_block_jump\":%.3f,\"stddev_period_us\":%.1f,\"samples\":%u,\"window_size\":%u,\"window_capacity\":%u,\"rolling_window_ms\":%lu,\"block_jump_us\":%ld,\"data_units\":\"%s\"}\n",
+    "{\"bpm\":%.3f,\"delta_beat\":%.3f,\"delta_block\":%.3f,\"avg_bpm\":%.5g,\"avg_delta_beat\":%.3f,\"avg_delta_block\":%.3f,\"avg_block_jump\":%.3f,\"avg_period_us\":%.1f,\"stddev_bpm\":%.5g,\"stddev_delta_beat\":%.3f,\"stddev_delta_block\":%.3f,\"stddev_block_jump\":%.3f,\"stddev_period_us\":%.1f,\"median_period_us\":%.1f,\"mad_period_us\":%.1f,\"p05_period_us\":%.1f,\"p95_period_us\":%.1f,\"median_delta_beat\":%.1f,\"mad_delta_beat\":%.1f,\"samples\":%u,\"window_size\":%u,\"window_capacity\":%u,\"rolling_window_ms\":%lu,\"data_units\":\"%s\",\"long\":{\"avg_bpm\":%.5g,\"avg_period_us\":%.1f,\"stddev_period_us\":%.1f,\"avg_delta_beat\":%.3f,\"stddev_delta_beat\":%.3f,\"avg_block_jump\":%.3f,\"median_period_us\":%.1f,\"mad_period_us\":%.1f,\"p05_period_us\":%.1f,\"p95_period_us\":%.1f,\"median_delta_beat\":%.1f,\"mad_delta_beat\":%.1f,\"samples\":%u,\"window_size\":%u,\"window_capacity\":%u},\"mom\":{\"bpm\":%.5g,\"period_us\":%.1f,\"delta_beat\":%.3f,\"residual_us\":%.1f,\"blocks\":%u,\"block_len\":%u,\"ready\":%s}}\n",
     st.bpm,
     st.delta_beat,
     st.delta_block,
@@ -148,12 +160,39 @@ static void sendStatsJson(HttpResponse& response) {
     st.stddev_delta_block,
     st.stddev_block_jump,
     st.stddev_period_us,
+    st.median_period_us,
+    st.mad_period_us,
+    StatsEngine::periodQuantileUs(0.05f),
+    StatsEngine::periodQuantileUs(0.95f),
+    st.median_delta_beat,
+    st.mad_delta_beat,
     (unsigned int)StatsEngine::windowCount(),
     (unsigned int)UnoTunables::statsWindowSize,
     (unsigned int)StatsEngine::windowCapacityLimit(),
     (unsigned long)UnoTunables::rollingWindowMs,
-    (long)UnoTunables::blockJumpUs,
-    dataUnitsLabel());
+    dataUnitsLabel(),
+    lt.avg_bpm,
+    lt.avg_period_us,
+    lt.stddev_period_us,
+    lt.avg_delta_beat,
+    lt.stddev_delta_beat,
+    lt.avg_block_jump,
+    lt.median_period_us,
+    lt.mad_period_us,
+    StatsEngine::periodQuantileUs(StatsEngine::STATS_WINDOW_LONG, 0.05f),
+    StatsEngine::periodQuantileUs(StatsEngine::STATS_WINDOW_LONG, 0.95f),
+    lt.median_delta_beat,
+    lt.mad_delta_beat,
+    (unsigned int)StatsEngine::windowCount(StatsEngine::STATS_WINDOW_LONG),
+    (unsigned int)AnalysisTunables::statsLongWindow,
+    (unsigned int)StatsEngine::windowCapacityLimit(StatsEngine::STATS_WINDOW_LONG),
+    rb.bpm,
+    rb.period_us,
+    rb.delta_beat,
+    rb.residual_us,
+    (unsigned int)rb.blocks,
+    (unsigned int)AnalysisTunables::momBlockLen,
+    rb.ready ? "true" : "false");
   size_t jsonLen = clampJsonLength(len, sizeof(buf));
   sendBufferedJson(response, buf, jsonLen);
 }
@@ -189,6 +228,369 @@ static void handleStatsJsonRequest(HttpRequest& request, HttpResponse& response)
   sendStatsJson(response);
 }
 
+#if ENABLE_ADEV
+static void printAdevSeries(HttpResponse& response, const AdevCascade &cascade, float tau0_s) {
+  char buf[160];
+  bool first = true;
+  response.print(F("["));
+  for (uint8_t k = 0; k < ADEV_LEVELS; ++k) {
+    AdevPoint pt;
+    if (!cascade.point(k, tau0_s, pt)) break;
+    int len = snprintf(buf, sizeof(buf), "%s{\"m\":%u,\"tau_s\":%.3f,\"adev\":%.4e,\"hdev\":%.4e,\"mdev\":%.4e,\"tdev_s\":%.4e,\"n\":%lu}",
+                       first ? "" : ",", (unsigned int)pt.m, pt.tau_s, pt.adev, pt.hdev, pt.mdev, pt.tdev_s,
+                       (unsigned long)pt.n);
+    if (len > 0) response.print(buf);
+    first = false;
+  }
+  response.print(F("]"));
+}
+
+static void handleAdevJsonRequest(HttpRequest& request, HttpResponse& response) {
+  (void)request;
+  float tau0 = AllanDev::tau0Seconds();
+  response.setStatusCode(F("200 OK"));
+  response.setHeader("Content-Type", "application/json");
+  response.setHeader("Connection", "close");
+  char buf[96];
+  snprintf(buf, sizeof(buf), "{\"tau0_s\":%.6f,\"period_samples\":%lu,\"pps_samples\":%lu,\"period\":",
+           tau0,
+           (unsigned long)AllanDev::period().samples(),
+           (unsigned long)AllanDev::pps().samples());
+  response.print(buf);
+  printAdevSeries(response, AllanDev::period(), tau0);
+  response.print(F(",\"pps\":"));
+  printAdevSeries(response, AllanDev::pps(), tau0);
+  response.println(F("}"));
+}
+#endif
+
+#if ENABLE_PSD
+static void handlePsdJsonRequest(HttpRequest& request, HttpResponse& response) {
+  (void)request;
+  response.setStatusCode(F("200 OK"));
+  response.setHeader("Content-Type", "application/json");
+  response.setHeader("Connection", "close");
+  char buf[128];
+  snprintf(buf, sizeof(buf),
+           "{\"segment\":%u,\"segment_max\":%u,\"segments\":%lu,\"skipped\":%lu,\"tau0_s\":%.6f,\"bin_hz\":%.6g,\"units\":\"us^2/Hz\",\"peaks\":[",
+           (unsigned int)Spectrum::segmentLength(),
+           (unsigned int)PSD_SEGMENT_MAX,
+           (unsigned long)Spectrum::segmentsAveraged(),
+           (unsigned long)Spectrum::segmentsSkipped(),
+           Spectrum::tau0Seconds(),
+           Spectrum::binHz());
+  response.print(buf);
+  SpectrumPeak peaks[PSD_TOP_PEAKS];
+  uint8_t n = Spectrum::peaks(peaks, PSD_TOP_PEAKS);
+  for (uint8_t i = 0; i < n; ++i) {
+    snprintf(buf, sizeof(buf), "%s{\"bin\":%u,\"hz\":%.5g,\"period_swings\":%.2f,\"psd\":%.4e}",
+             i ? "," : "", (unsigned int)peaks[i].bin, peaks[i].hz, peaks[i].period_swings, peaks[i].psd);
+    response.print(buf);
+  }
+  response.print(F("],\"psd\":["));
+  // Batch bins so each client write carries ~100 bytes rather than one value.
+  uint16_t bins = Spectrum::segmentLength() / 2 + 1;
+  size_t used = 0;
+  for (uint16_t k = 0; k < bins; ++k) {
+    int len = snprintf(buf + used, sizeof(buf) - used, "%s%.4e", k ? "," : "", Spectrum::psd(k));
+    if (len > 0) used += (size_t)len;
+    if (used > sizeof(buf) - 16) {
+      response.print(buf);
+      used = 0;
+    }
+  }
+  if (used) response.print(buf);
+  response.println(F("]}"));
+}
+#endif
+
+#if ENABLE_DEV_HIST
+// /hist.json[?reset=1] - sparse [bucket,count,...] pairs per metric. With
+// reset=1 the histograms are cleared after the dump, so successive dumps are
+// disjoint snapshots the host can merge into hourly/daily rollups.
+static void handleHistJsonRequest(HttpRequest& request, HttpResponse& response) {
+  String queryStr = request.query();
+  QueryParams query(queryStr);
+  response.setStatusCode(F("200 OK"));
+  response.setHeader("Content-Type", "application/json");
+  response.setHeader("Connection", "close");
+  char buf[128];
+  snprintf(buf, sizeof(buf), "{\"sub_bits\":%u,\"max_bits\":%u,\"per_sign\":%u,\"units\":\"us\"",
+           (unsigned int)HIST_SUB_BITS, (unsigned int)HIST_MAX_BITS,
+           (unsigned int)DeviationHistogram::PER_SIGN);
+  response.print(buf);
+  for (uint8_t m = 0; m < DeviationHist::MetricCount; ++m) {
+    DeviationHist::Metric metric = (DeviationHist::Metric)m;
+    const DeviationHistogram &h = DeviationHist::histogram(metric);
+    snprintf(buf, sizeof(buf), ",\"%s\":{\"n\":%lu,\"ref_us\":%.1f,\"b\":[",
+             DeviationHist::name(metric), (unsigned long)h.total(), DeviationHist::referenceUs(metric));
+    response.print(buf);
+    size_t used = 0;
+    bool first = true;
+    for (uint16_t b = 0; b < DeviationHistogram::BUCKETS; ++b) {
+      uint32_t c = h.count(b);
+      if (!c) continue;
+      int len = snprintf(buf + used, sizeof(buf) - used, "%s%u,%lu", first ? "" : ",",
+                         (unsigned int)b, (unsigned long)c);
+      if (len > 0) used += (size_t)len;
+      first = false;
+      if (used > sizeof(buf) - 24) {
+        response.print(buf);
+        used = 0;
+      }
+    }
+    if (used) response.print(buf);
+    response.print(F("]}"));
+  }
+  response.println(F("}"));
+  if (query.flagEnabled("reset=")) DeviationHist::reset();
+}
+#endif
+
+// /sd.json[?reset=1] - SD health: per-operation log2 latency histograms as
+// sparse [bucket,count,...] pairs (bucket b covers [2^b, 2^(b+1)) us), errors
+// by type, bytes written and the write backlog. reset=1 clears the health
+// counters after the dump; the writer stats are left alone.
+static void handleSdJsonRequest(HttpRequest& request, HttpResponse& response) {
+  String queryStr = request.query();
+  QueryParams query(queryStr);
+  response.setStatusCode(F("200 OK"));
+  response.setHeader("Content-Type", "application/json");
+  response.setHeader("Connection", "close");
+  const SDLogger::SdHealth &h = SDLogger::health();
+  SDLogger::WriterStats ws = SDLogger::writerStats();
+  char buf[192];
+  snprintf(buf, sizeof(buf),
+           "{\"ready\":%s,\"logging\":%s,\"bytes_written\":%lu,\"units\":\"us\","
+           "\"queue\":{\"queued\":%u,\"max_queued\":%u,\"buffers\":%u,\"buffered_bytes\":%u,\"dropped_rows\":%lu}",
+           SDLogger::ready() ? "true" : "false", SDLogger::isLogging() ? "true" : "false",
+           (unsigned long)h.bytes_written, (unsigned int)ws.queued, (unsigned int)h.max_queued,
+           (unsigned int)SD_WRITE_BUFFERS, (unsigned int)ws.buffered_bytes, (unsigned long)ws.dropped_rows);
+  response.print(buf);
+  snprintf(buf, sizeof(buf),
+           ",\"spill\":{\"waiting\":%u,\"max\":%u,\"capacity\":%u,\"spilled\":%lu,\"gaps\":%lu,\"card_lost\":%s,\"remounts\":%lu}",
+           (unsigned int)ws.spill, (unsigned int)ws.max_spill, (unsigned int)SD_SPILL_RECORDS,
+           (unsigned long)ws.spilled, (unsigned long)ws.gaps, SDLogger::isCardLost() ? "true" : "false",
+           (unsigned long)ws.remounts);
+  response.print(buf);
+  response.print(F(",\"errors\":{"));
+  for (uint8_t e = 0; e < SDLogger::SD_ERROR_COUNT; ++e) {
+    snprintf(buf, sizeof(buf), "%s\"%s\":%lu", e ? "," : "",
+             SDLogger::sdErrorName((SDLogger::SdError)e), (unsigned long)h.errors[e]);
+    response.print(buf);
+  }
+  response.print(F("},\"ops\":{"));
+  for (uint8_t op = 0; op < SDLogger::SD_OP_COUNT; ++op) {
+    uint32_t n = 0;
+    for (uint32_t c : h.latency[op]) n += c;
+    snprintf(buf, sizeof(buf), "%s\"%s\":{\"n\":%lu,\"max_us\":%lu,\"b\":[", op ? "," : "",
+             SDLogger::sdOpName((SDLogger::SdOp)op), (unsigned long)n, (unsigned long)h.max_us[op]);
+    response.print(buf);
+    size_t used = 0;
+    bool first = true;
+    for (uint8_t b = 0; b < SD_LATENCY_BUCKETS; ++b) {
+      uint32_t c = h.latency[op][b];
+      if (!c) continue;
+      int len = snprintf(buf + used, sizeof(buf) - used, "%s%u,%lu", first ? "" : ",",
+                         (unsigned int)b, (unsigned long)c);
+      if (len > 0) used += (size_t)len;
+      first = false;
+      if (used > sizeof(buf) - 24) {
+        response.print(buf);
+        used = 0;
+      }
+    }
+    if (used) response.print(buf);
+    response.print(F("]}"));
+  }
+  snprintf(buf, sizeof(buf),
+           "},\"writer\":{\"max_loop_us\":%lu,\"syncs\":%lu,\"write_errors\":%lu,\"reserved_bytes\":%lu,\"torn_bytes\":%lu}}",
+           (unsigned long)ws.max_loop_us, (unsigned long)ws.syncs, (unsigned long)ws.write_errors,
+           (unsigned long)ws.reserved_bytes, (unsigned long)ws.torn_bytes);
+  response.println(buf);
+  if (query.flagEnabled("reset=")) SDLogger::resetHealth();
+}
+
+#if ENABLE_ENV_REGRESSION
+// /env.json[?reset=1][&save=1]
+static void handleEnvJsonRequest(HttpRequest& request, HttpResponse& response) {
+  String queryStr = request.query();
+  QueryParams query(queryStr);
+  if (query.flagEnabled("reset=")) EnvRegression::reset();
+  if (query.flagEnabled("save=")) EnvRegression::save();
+  const EnvFit &f = EnvRegression::fit();
+  char buf[512];
+  int len = snprintf(buf, sizeof(buf),
+    "{\"samples\":%lu,\"restored\":%s,\"ref_period_us\":%.3f,\"raw_ppm\":%.4f,\"compensated_ppm\":%.4f,\"resid_ppm\":%.4f,"
+    "\"intercept_ppm\":%.4f,\"intercept_se\":%.3g,\"temp_ppm_per_C\":%.5f,\"temp_se\":%.3g,"
+    "\"hum_ppm_per_pct\":%.5f,\"hum_se\":%.3g,\"press_ppm_per_hPa\":%.5f,\"press_se\":%.3g,"
+    "\"centres\":{\"temp_C\":%.2f,\"hum_pct\":%.1f,\"press_hPa\":%.2f}}\n",
+    (unsigned long)f.samples, f.restored ? "true" : "false", f.ref_period_us,
+    f.raw_ppm, f.compensated_ppm, f.resid_ppm,
+    f.coef[0], f.std_err[0], f.coef[1], f.std_err[1],
+    f.coef[2], f.std_err[2], f.coef[3], f.std_err[3],
+    ENV_CENTER_TEMP_C, ENV_CENTER_HUM_PCT, ENV_CENTER_PRESS_HPA);
+  size_t jsonLen = clampJsonLength(len, sizeof(buf));
+  sendBufferedJson(response, buf, jsonLen);
+}
+#endif
+
+#if ENABLE_ROLLUPS
+// /rollup.json?tier=minute|hour|day[&n=<entries>][&span=<entries>]
+// Rows are newest first: [start_s,count,mean_dev_us,min_dev_us,max_dev_us,stddev_us,rate_s_per_day].
+// The trend is fitted over the newest `span` entries (default: all held).
+static void handleRollupJsonRequest(HttpRequest& request, HttpResponse& response) {
+  String queryStr = request.query();
+  QueryParams query(queryStr);
+  char val[16];
+  Rollups::Tier tier = Rollups::Hour;
+  if (query.copyValue("tier=", val, sizeof(val))) {
+    if (strcmp(val, "minute") == 0) tier = Rollups::Minute;
+    else if (strcmp(val, "day") == 0) tier = Rollups::Day;
+  }
+  long rows = query.toLong("n=", Rollups::entries(tier));
+  long span = query.toLong("span=", 0);
+  if (rows < 0) rows = 0;
+  if (span < 0) span = 0;
+
+  RollupTrend tr;
+  Rollups::trend(tier, (uint16_t)(span > 0xFFFF ? 0xFFFF : span), tr);
+  response.setStatusCode(F("200 OK"));
+  response.setHeader("Content-Type", "application/json");
+  response.setHeader("Connection", "close");
+  char buf[160];
+  snprintf(buf, sizeof(buf),
+           "{\"tier\":\"%s\",\"elapsed_s\":%.0f,\"ref_period_us\":%.3f,\"capacity\":%u,\"entries\":%u,",
+           Rollups::name(tier), Rollups::elapsedSeconds(), Rollups::referencePeriodUs(),
+           (unsigned int)Rollups::capacity(tier), (unsigned int)Rollups::entries(tier));
+  response.print(buf);
+  snprintf(buf, sizeof(buf),
+           "\"trend\":{\"rate_s_per_day\":%.4f,\"drift_s_per_day2\":%.5f,\"drift_stderr\":%.5f,\"entries\":%u},\"rows\":[",
+           tr.rate_s_per_day, tr.drift_s_per_day2, tr.drift_stderr, (unsigned int)tr.entries);
+  response.print(buf);
+  RollupEntry e;
+  for (uint16_t i = 0; i < (uint16_t)rows && Rollups::entry(tier, i, e); ++i) {
+    snprintf(buf, sizeof(buf), "%s[%lu,%lu,%.3f,%.1f,%.1f,%.2f,%.4f]", i ? "," : "",
+             (unsigned long)e.start_s, (unsigned long)e.count, e.mean_dev_us, e.min_dev_us,
+             e.max_dev_us, Rollups::stddevUs(e), Rollups::rateSecPerDay(e));
+    response.print(buf);
+  }
+  response.println(F("]}"));
+}
+#endif
+
+#if ENABLE_DISTURBANCE
+// /profile.json - disturbance classification, its features and the suggested preset.
+static void handleProfileJsonRequest(HttpRequest& request, HttpResponse& response) {
+  (void)request;
+  response.setStatusCode(F("200 OK"));
+  response.setHeader("Content-Type", "application/json");
+  response.setHeader("Connection", "close");
+  char buf[192];
+  DisturbanceProfile p = Disturbance::profile();
+  snprintf(buf, sizeof(buf), "{\"profile\":\"%s\",\"confidence\":%.2f,\"refreshes\":%lu,\"every_swings\":%u,\"scores\":{",
+           Disturbance::name(p), Disturbance::confidence(), (unsigned long)Disturbance::refreshes(),
+           (unsigned int)DISTURB_REFRESH_SWINGS);
+  response.print(buf);
+  for (uint8_t i = PROFILE_CONSTANT_FORCE; i < PROFILE_COUNT; ++i) {
+    snprintf(buf, sizeof(buf), "%s\"%s\":%.3f", i == PROFILE_CONSTANT_FORCE ? "" : ",",
+             Disturbance::name((DisturbanceProfile)i), Disturbance::score((DisturbanceProfile)i));
+    response.print(buf);
+  }
+  const DisturbanceFeatures &f = Disturbance::features();
+  snprintf(buf, sizeof(buf),
+           "},\"features\":{\"asymmetry\":%.5f,\"asymmetry_t\":%.1f,\"beat_us\":%.1f,\"line_ratio\":%.2f,\"line_period_swings\":%.2f,",
+           f.asymmetry, f.asymmetry_t, f.beat_us, f.line_ratio, f.line_period_swings);
+  response.print(buf);
+  snprintf(buf, sizeof(buf),
+           "\"tone_snr\":%.2f,\"tone_period_s\":%.2f,\"sigma_us\":%.2f,\"excess_kurtosis\":%.2f,\"outlier_rate\":%.4f,\"drift_s_per_day2\":%.4f},",
+           f.tone_snr, f.tone_period_s, f.residual_sigma_us, f.excess_kurtosis, f.outlier_rate, f.drift_s_per_day2);
+  response.print(buf);
+  DisturbancePreset pre = Disturbance::preset();
+  snprintf(buf, sizeof(buf), "\"preset\":{\"statsWindow\":%u,\"robust\":%s}}",
+           (unsigned int)pre.stats_window, pre.robust ? "true" : "false");
+  response.println(buf);
+}
+#endif
+
+static const char* changeSeriesLabel(uint8_t series) {
+  return series == CHANGE_BEAT ? "beat" : "period";
+}
+
+// /changes.json - CUSUM detector state and the most recent change points.
+static void handleChangesJsonRequest(HttpRequest& request, HttpResponse& response) {
+  (void)request;
+  response.setStatusCode(F("200 OK"));
+  response.setHeader("Content-Type", "application/json");
+  response.setHeader("Connection", "close");
+  char buf[192];
+  snprintf(buf, sizeof(buf), "{\"k\":%.2f,\"h\":%.2f,\"total\":%lu,\"detectors\":{",
+           CUSUM_K, CUSUM_H, (unsigned long)StatsEngine::changeEventsTotal());
+  response.print(buf);
+  for (uint8_t s = CHANGE_PERIOD; s <= CHANGE_BEAT; ++s) {
+    const CusumDetector &d = StatsEngine::detector((ChangeSeries)s);
+    snprintf(buf, sizeof(buf), "%s\"%s\":{\"ready\":%s,\"mean\":%.2f,\"sigma\":%.3f,\"upper\":%.2f,\"lower\":%.2f}",
+             s ? "," : "", changeSeriesLabel(s), d.warmedUp() ? "true" : "false",
+             d.mean(), d.sigma(), d.upper(), d.lower());
+    response.print(buf);
+  }
+  response.print(F("},\"events\":["));
+  ChangeEvent ev;
+  for (uint8_t i = 0; StatsEngine::changeEvent(i, ev); ++i) {
+    snprintf(buf, sizeof(buf),
+             "%s{\"swing_id\":%lu,\"change_swing_id\":%lu,\"ms\":%lu,\"series\":\"%s\",\"direction\":%d,\"shift\":%.2f,\"sigma\":%.3f}",
+             i ? "," : "", (unsigned long)ev.swing_id, (unsigned long)ev.change_swing_id,
+             (unsigned long)ev.ms, changeSeriesLabel(ev.series), (int)ev.direction, ev.shift, ev.sigma);
+    response.print(buf);
+  }
+  response.println(F("]}"));
+}
+
+#if ENABLE_GOERTZEL
+// /goertzel.json[?clear=1][&period=<s>&harmonics=<n>][&tau=<s>]
+static void handleGoertzelJsonRequest(HttpRequest& request, HttpResponse& response) {
+  String queryStr = request.query();
+  QueryParams query(queryStr);
+  char val[16];
+  bool changed = false;
+  bool rejected = false;
+  if (query.flagEnabled("clear=")) {
+    Goertzel::clear();
+    changed = true;
+  }
+  if (query.copyValue("period=", val, sizeof(val))) {
+    long harmonics = query.toLong("harmonics=", 1);
+    if (harmonics < 1 || harmonics > GOERTZEL_MAX_BINS ||
+        !Goertzel::addPeriod((float)atof(val), (uint8_t)harmonics)) {
+      rejected = true;
+    }
+    changed = true;
+  }
+  if (query.copyValue("tau=", val, sizeof(val))) {
+    Goertzel::setTimeConstantS((float)atof(val));
+    changed = true;
+  }
+  if (changed) Goertzel::reset();
+
+  response.setStatusCode(rejected ? F("400 Bad Request") : F("200 OK"));
+  response.setHeader("Content-Type", "application/json");
+  response.setHeader("Connection", "close");
+  char buf[128];
+  snprintf(buf, sizeof(buf), "{\"tau_s\":%.1f,\"predicted_us\":%.3f,\"max_bins\":%u,\"bins\":[",
+           Goertzel::timeConstantS(), Goertzel::predictUs(), (unsigned int)GOERTZEL_MAX_BINS);
+  response.print(buf);
+  for (uint8_t i = 0; i < Goertzel::binCount(); ++i) {
+    GoertzelResult r;
+    if (!Goertzel::bin(i, r)) break;
+    snprintf(buf, sizeof(buf), "%s{\"period_s\":%.3f,\"harmonic\":%u,\"amplitude_us\":%.3f,\"phase_deg\":%.1f,\"aliased\":%s}",
+             i ? "," : "", r.period_s, (unsigned int)r.harmonic, r.amplitude_us, r.phase_deg,
+             r.aliased ? "true" : "false");
+    response.print(buf);
+  }
+  response.println(F("]}"));
+}
+#endif
+
 static void sendHomePage(HttpResponse& response) {
   sendProgmemHtml(response, HOME_PAGE);
 }
@@ -205,13 +607,25 @@ static void renderLoggingPage(HttpResponse& response) {
   response.println(F("<!DOCTYPE html><html><head><meta charset='utf-8'><title>Logging</title></head><body>"));
   response.println(F("<h2>Logging Control</h2>"));
   response.print(F("<p>Status: "));
-  response.print(SDLogger::isLogging() ? F("Logging") : F("Stopped"));
+  if (SDLogger::isLogging()) response.print(F("Logging"));
+  else if (SDLogger::isCardLost()) response.print(F("Waiting for SD card"));
+  else response.print(F("Stopped"));
   response.print(F(" | Mode: "));
-  response.print(SDLogger::getLogMode() == SDLogger::LogMode::Daily ? F("Daily rollover") : F("Continuous"));
+  switch (SDLogger::getLogMode()) {
+    case SDLogger::LogMode::Daily: response.print(F("Daily rollover")); break;
+    case SDLogger::LogMode::Size:
+      response.print(F("Size rotation at "));
+      response.print(SDLogger::getRotateSizeMB());
+      response.print(F(" MB"));
+      break;
+    default: response.print(F("Continuous")); break;
+  }
   response.print(F(" | Active file: "));
   response.print(SDLogger::getActiveFilename());
   response.print(F(" | Append: "));
   response.print(SDLogger::getAppendMode() ? F("yes") : F("no"));
+  response.print(F(" | Format: "));
+  response.print(SDLogger::getLogFormat() == SDLogger::LogFormat::Binary ? F("binary") : F("CSV"));
   response.println(F("</p>"));
 
   response.print(F("<p>Time sync: "));
@@ -224,13 +638,34 @@ static void renderLoggingPage(HttpResponse& response) {
   }
   response.println(F("</p>"));
 
+  SDLogger::WriterStats ws = SDLogger::writerStats();
+  char line[320];
+  snprintf(line, sizeof(line),
+           "<p>SD writer: max %lu us/loop (last %lu), slowest write %lu us, %lu sectors, %lu partial, %lu syncs, %u bytes buffered, %lu rows dropped, %lu errors; reserve %lu KB ahead, %lu pad sectors, slowest %lu us; %lu torn bytes recovered</p>",
+           (unsigned long)ws.max_loop_us, (unsigned long)ws.last_loop_us, (unsigned long)ws.max_write_us,
+           (unsigned long)ws.sectors, (unsigned long)ws.partial_writes, (unsigned long)ws.syncs,
+           (unsigned int)ws.buffered_bytes, (unsigned long)ws.dropped_rows, (unsigned long)ws.write_errors,
+           (unsigned long)(ws.reserved_bytes / 1024), (unsigned long)ws.reserve_sectors,
+           (unsigned long)ws.max_reserve_us, (unsigned long)ws.torn_bytes);
+  response.println(line);
+  snprintf(line, sizeof(line),
+           "<p>Spill queue: %u of %u swings waiting (most %u), %lu spilled, %lu gap markers, %lu remounts</p>",
+           (unsigned int)ws.spill, (unsigned int)SD_SPILL_RECORDS, (unsigned int)ws.max_spill,
+           (unsigned long)ws.spilled, (unsigned long)ws.gaps, (unsigned long)ws.remounts);
+  response.println(line);
+
   response.println(F("<h3>Settings</h3>"));
   response.println(F("<form action='/log' method='get'>"));
   response.println(F("Mode: <select name='mode'>"));
   response.print(F("<option value='continuous'")); if (SDLogger::getLogMode() == SDLogger::LogMode::Continuous) response.print(F(" selected")); response.println(F(">Continuous</option>"));
-  response.print(F("<option value='daily'")); if (SDLogger::getLogMode() == SDLogger::LogMode::Daily) response.print(F(" selected")); response.println(F(">Daily rollover</option></select><br>"));
+  response.print(F("<option value='daily'")); if (SDLogger::getLogMode() == SDLogger::LogMode::Daily) response.print(F(" selected")); response.println(F(">Daily rollover</option>"));
+  response.print(F("<option value='size'")); if (SDLogger::getLogMode() == SDLogger::LogMode::Size) response.print(F(" selected")); response.println(F(">Size rotation (" LOG_RAW_DIR "/rNNNpMMM)</option></select><br>"));
+  response.print(F("Rotate at (MB): <input name='rotate' type='number' min='1' max='255' value='")); response.print(SDLogger::getRotateSizeMB()); response.println(F("'><br>"));
   response.print(F("Base filename (continuous): <input name='file' value='")); response.print(SDLogger::getFilename()); response.println(F("'><br>"));
   response.print(F("Append: <input name='append' type='number' min='0' max='1' value='")); response.print(SDLogger::getAppendMode() ? 1 : 0); response.println(F("'><br>"));
+  response.println(F("Format: <select name='format'>"));
+  response.print(F("<option value='csv'")); if (SDLogger::getLogFormat() == SDLogger::LogFormat::Csv) response.print(F(" selected")); response.println(F(">CSV</option>"));
+  response.print(F("<option value='bin'")); if (SDLogger::getLogFormat() == SDLogger::LogFormat::Binary) response.print(F(" selected")); response.println(F(">Binary (.bin)</option></select> (applies to the next file)<br>"));
   response.println(F("<input type='submit' value='Save Settings'></form>"));
 
   response.println(F("<h3>Actions</h3>"));
@@ -239,7 +674,7 @@ static void renderLoggingPage(HttpResponse& response) {
   response.println(F("<form action='/log' method='get'><input type='hidden' name='restart' value='1'><input type='submit' value='Restart (same file)'></form>"));
   response.println(F("<form action='/log' method='get'><input type='hidden' name='restart' value='new'><input type='submit' value='Restart with new file'></form>"));
 
-  response.println(F("<p><a href='/logfiles'>Log files</a> | <a href='/' aria-label='Return to home page'>Home</a></p>"));
+  response.println(F("<p><a href='/logfiles'>Log files</a> | <a href='/sd.json'>SD health</a> | <a href='/' aria-label='Return to home page'>Home</a></p>"));
   response.println(F("<hr><small>UNO R4 Pendulum Logger</small></body></html>"));
 }
 
@@ -251,8 +686,10 @@ static void handleLogRequest(HttpRequest& request, HttpResponse& response) {
   TunableConfig shared = getCurrentConfig();
   UnoConfig unoCfg = getCurrentUnoConfig();
 
-  SDLogger::setLogMode(unoCfg.logDaily ? SDLogger::LogMode::Daily : SDLogger::LogMode::Continuous);
+  SDLogger::setLogMode(SDLogger::logModeFor(unoCfg.logDaily, unoCfg.logSizeRotate == 1));
+  SDLogger::setRotateSizeMB(unoCfg.logSizeRotate == 1 ? unoCfg.logRotateMB : 0);
   SDLogger::setAppendMode(unoCfg.logAppend);
+  SDLogger::setLogFormat((SDLogger::LogFormat)unoCfg.logFormat);
   SDLogger::setFilename(unoCfg.logBaseName);
 
   bool startCmd = false, stopCmd = false, restartCmd = false, restartNew = false;
@@ -262,12 +699,20 @@ static void handleLogRequest(HttpRequest& request, HttpResponse& response) {
     char buf[32] = {0};
     if (query.copyValue("mode=", buf, sizeof(buf))) {
       if (strcmp(buf, "daily") == 0) { unoCfg.logDaily = true; SDLogger::setLogMode(SDLogger::LogMode::Daily); }
+      else if (strcmp(buf, "size") == 0) { unoCfg.logDaily = false; SDLogger::setLogMode(SDLogger::LogMode::Size); }
       else { unoCfg.logDaily = false; SDLogger::setLogMode(SDLogger::LogMode::Continuous); }
     }
+    if (query.copyValue("rotate=", buf, sizeof(buf))) {
+      SDLogger::setRotateSizeMB((uint8_t)constrain(atoi(buf), 1, 255));
+    }
     if (query.copyValue("append=", buf, sizeof(buf))) {
       unoCfg.logAppend = atoi(buf);
       SDLogger::setAppendMode(unoCfg.logAppend);
     }
+    if (query.copyValue("format=", buf, sizeof(buf))) {
+      unoCfg.logFormat = strcmp(buf, "bin") == 0 ? 1 : 0;
+      SDLogger::setLogFormat((SDLogger::LogFormat)unoCfg.logFormat);
+    }
     if (query.copyValue("file=", val, sizeof(val))) {
       SDLogger::setFilename(val);
       strncpy(unoCfg.logBaseName, SDLogger::getFilename(), LOG_FILENAME_LEN);
@@ -291,8 +736,10 @@ static void handleLogRequest(HttpRequest& request, HttpResponse& response) {
     SDLogger::stopLogging();
   }
 
-  unoCfg.logEnabled = SDLogger::isLogging();
+  unoCfg.logEnabled = SDLogger::isLogEnabled();
   unoCfg.logDaily   = (SDLogger::getLogMode() == SDLogger::LogMode::Daily);
+  unoCfg.logSizeRotate = (SDLogger::getLogMode() == SDLogger::LogMode::Size) ? 1 : 0;
+  unoCfg.logRotateMB = SDLogger::getRotateSizeMB();
   unoCfg.logAppend  = SDLogger::getAppendMode();
   strncpy(unoCfg.logBaseName, SDLogger::getFilename(), LOG_FILENAME_LEN);
   unoCfg.logBaseName[LOG_FILENAME_LEN-1] = 0;
@@ -305,6 +752,40 @@ static void handleLogRequest(HttpRequest& request, HttpResponse& response) {
   renderLoggingPage(response);
 }
 
+// Lists the log files in `dir` ("/" for the root) with download links.
+// Returns false if the directory cannot be opened.
+static bool listLogDirectory(HttpResponse& response, const char* dir) {
+  File root = SD.open(dir);
+  if (!root) return false;
+  bool atRoot = strcmp(dir, "/") == 0;
+  response.print(F("<h3>"));
+  response.print(dir);
+  response.println(F("</h3><ul>"));
+  File entry = root.openNextFile();
+  while (entry) {
+    const char* nm = entry.name();
+    if (!entry.isDirectory() && nm) {
+      char path[LOG_PATH_LEN] = {0};
+      snprintf(path, sizeof(path), "%s%s%s", atRoot ? "" : dir, atRoot ? "" : "/", nm);
+      if (SDLogger::isValidLogPath(path)) {
+        response.print(F("<li><a href='/download?file="));
+        response.print(path);
+        response.print(F("'>"));
+        response.print(nm);
+        response.print(F("</a> ("));
+        response.print((unsigned long)entry.size());
+        response.println(F(" bytes)</li>"));
+      }
+    }
+    File next = root.openNextFile();
+    entry.close();
+    entry = next;
+  }
+  response.println(F("</ul>"));
+  root.close();
+  return true;
+}
+
 static void handleLogFilesRequest(HttpRequest& request, HttpResponse& response) {
   (void)request;
   response.setStatusCode(F("200 OK"));
@@ -313,46 +794,84 @@ static void handleLogFilesRequest(HttpRequest& request, HttpResponse& response)
   response.println(F("<!DOCTYPE html><html><head><meta charset='utf-8'><title>Log Files</title></head><body>"));
   response.println(F("<h2>Log Files</h2>"));
 
-  File root = SD.open("/");
-  if (!root) {
+  if (!listLogDirectory(response, "/")) {
     response.println(F("<p>SD not available.</p>"));
   } else {
-    response.println(F("<ul>"));
-    File entry = root.openNextFile();
-    while (entry) {
-      if (!entry.isDirectory()) {
-        char nameBuf[LOG_FILENAME_LEN] = {0};
-        const char* nm = entry.name();
-        if (nm) {
-          strncpy(nameBuf, nm, sizeof(nameBuf)-1);
-        }
-        if (nameBuf[0] && SDLogger::isValidFilename(nameBuf)) {
-          response.print(F("<li><a href='/download?file="));
-          response.print(nameBuf);
-          response.print(F("'>"));
-          response.print(nameBuf);
-          response.print(F("</a> ("));
-          response.print((unsigned long)entry.size());
-          response.println(F(" bytes)</li>"));
-        }
-      }
-      File next = root.openNextFile();
-      entry.close();
-      entry = next;
-    }
-    response.println(F("</ul>"));
-    root.close();
+    listLogDirectory(response, LOG_RAW_DIR);
+    listLogDirectory(response, LOG_STATS_DIR);
+    response.println(F("<p>Raw logs: add <code>&amp;from=&amp;to=</code> (swing ids) or <code>&amp;t0=&amp;t1=</code> (UTC seconds) to a download link for an extract.</p>"));
   }
 
   response.println(F("<p><a href='/log'>Back</a> | <a href='/' aria-label='Return to home page'>Home</a></p>"));
   response.println(F("<hr><small>UNO R4 Pendulum Logger</small></body></html>"));
 }
 
+// Sends `len` bytes of `f` from `pos`.
+static void sendFileSpan(HttpResponse& response, File& f, uint32_t pos, uint32_t len) {
+  if (!f.seek(pos)) return;
+  uint8_t buf[128];
+  while (len) {
+    int n = f.read(buf, len < sizeof(buf) ? len : sizeof(buf));
+    if (n <= 0) break;
+    response.write(buf, (size_t)n);
+    len -= (uint32_t)n;
+  }
+}
+
+// Leading bytes an extract needs to be read on its own: the CSV header line
+// or the binary file header; 0 if the file starts with neither.
+static uint32_t extractPrefixLength(File& f, bool binary) {
+  if (!f.seek(0)) return 0;
+  if (binary) {
+    BinLogFileHeader h;
+    if (f.read((uint8_t*)&h, sizeof(h)) != (int)sizeof(h) || !binLogHeaderValid(h)) return 0;
+    return h.header_bytes;
+  }
+  uint8_t buf[64];
+  uint32_t pos = 0;
+  while (pos < 512) {
+    int n = f.read(buf, sizeof(buf));
+    if (n <= 0) return 0;
+    for (int i = 0; i < n; ++i) {
+      if (buf[i] == '\n') return pos + (uint32_t)i + 1;
+    }
+    pos += (uint32_t)n;
+  }
+  return 0;
+}
+
+// A single "bytes=a-b", "bytes=a-" or "bytes=-n" range of a `size`-byte body,
+// as [start, end). False when it cannot be served.
+static bool parseByteRange(const String& hdr, uint32_t size, uint32_t& start, uint32_t& end) {
+  if (!hdr.startsWith("bytes=") || hdr.indexOf(',') >= 0) return false;
+  int dash = hdr.indexOf('-');
+  if (dash < 0) return false;
+  String first = hdr.substring(6, dash);
+  String last = hdr.substring(dash + 1);
+  first.trim();
+  last.trim();
+  if (!first.length()) {
+    uint32_t n = strtoul(last.c_str(), nullptr, 10);
+    if (!n || !size) return false;
+    start = n >= size ? 0 : size - n;
+    end = size;
+    return true;
+  }
+  start = strtoul(first.c_str(), nullptr, 10);
+  end = last.length() ? strtoul(last.c_str(), nullptr, 10) + 1 : size;
+  if (end > size) end = size;
+  return start < end;
+}
+
+// /download?file=<path>, whole file or one byte range (Range header). On a
+// raw log, from=/to= (swing ids) or t0=/t1= (UTC seconds) extract the rows
+// found through the sidecar index, rounded out to its entries, with the
+// file's header in front.
 static void handleDownloadRequest(HttpRequest& request, HttpResponse& response) {
   String queryStr = request.query();
   QueryParams query(queryStr);
-  char fname[LOG_FILENAME_LEN] = {0};
-  if (!query.copyValue("file=", fname, sizeof(fname)) || !SDLogger::isValidFilename(fname)) {
+  char fname[LOG_PATH_LEN] = {0};
+  if (!query.copyValue("file=", fname, sizeof(fname)) || !SDLogger::isValidLogPath(fname)) {
     sendNotFound(response);
     return;
   }
@@ -362,18 +881,59 @@ static void handleDownloadRequest(HttpRequest& request, HttpResponse& response)
     return;
   }
 
-  size_t fsize = f.size();
-  response.setStatusCode(F("200 OK"));
-  response.setHeader("Content-Type", "text/csv");
-  response.setHeader("Content-Disposition", String("attachment; filename=\"") + fname + "\"");
-  response.setHeader("Connection", "close");
-  response.setHeader("Content-Length", String(fsize));
-  response.beginBody(fsize);
-  uint8_t buf[128];
-  while (f.available()) {
-    size_t n = f.read(buf, sizeof(buf));
-    if (n) response.write(buf, n);
+  const char* ext = strrchr(fname, '.');
+  bool binary = ext && strcasecmp(ext, ".bin") == 0;
+  bool index = LogIndex::isIndexPath(fname);
+  // Without the reserve-ahead pad; index files have none.
+  uint32_t fsize = index ? (uint32_t)f.size() : SDLogger::dataLength(f, binary);
+  uint32_t start = 0, end = fsize, prefix = 0;
+  bool partial = false;
+
+  char lo[12] = {0}, hi[12] = {0};
+  bool bySwing = query.copyValue("from=", lo, sizeof(lo));
+  bool byTime = !bySwing && query.copyValue("t0=", lo, sizeof(lo));
+  if (!index && (bySwing || byTime)) {
+    bool haveHi = query.copyValue(bySwing ? "to=" : "t1=", hi, sizeof(hi));
+    uint32_t loVal = strtoul(lo, nullptr, 10);
+    uint32_t hiVal = haveHi ? strtoul(hi, nullptr, 10) : UINT32_MAX;
+    LogIndex::Key key = bySwing ? LogIndex::Key::Swing : LogIndex::Key::Epoch;
+    if (!LogIndex::findRange(fname, key, loVal, hiVal, fsize, start, end)) {
+      f.close();
+      sendNotFound(response);
+      return;
+    }
+    if (start) prefix = extractPrefixLength(f, binary);
+    if (prefix >= start) {
+      start = 0;
+      prefix = 0;
+    }
+  } else if (request.range().length()) {
+    if (!parseByteRange(request.range(), fsize, start, end)) {
+      f.close();
+      response.setStatusCode(F("416 Range Not Satisfiable"));
+      response.setHeader("Content-Range", String("bytes */") + String(fsize));
+      response.setHeader("Content-Length", "0");
+      response.setHeader("Connection", "close");
+      response.beginBody(0);
+      return;
+    }
+    partial = true;
   }
+
+  response.setStatusCode(partial ? F("206 Partial Content") : F("200 OK"));
+  response.setHeader("Content-Type", binary || index ? "application/octet-stream" : "text/csv");
+  const char* base = strrchr(fname, '/');
+  response.setHeader("Content-Disposition", String("attachment; filename=\"") + (base ? base + 1 : fname) + "\"");
+  response.setHeader("Accept-Ranges", "bytes");
+  if (partial) {
+    response.setHeader("Content-Range", String("bytes ") + String(start) + "-" + String(end - 1) + "/" + String(fsize));
+  }
+  response.setHeader("Connection", "close");
+  uint32_t length = prefix + (end - start);
+  response.setHeader("Content-Length", String(length));
+  response.beginBody(length);
+  if (prefix) sendFileSpan(response, f, 0, prefix);
+  sendFileSpan(response, f, start, end - start);
   f.close();
 }
 
@@ -447,34 +1007,50 @@ static void handleUnoRequest(HttpRequest& request, HttpResponse& response) {
   bool save = !query.empty();
   TunableConfig shared = getCurrentConfig();
   UnoConfig unoCfg = getCurrentUnoConfig();
+  AnalysisConfig analysisCfg = getCurrentAnalysisConfig();
   if (save) {
     char val[32];
+    uint8_t prevUnits = shared.dataUnits;
     if (query.copyValue("statsWindowSize=", val, sizeof(val))) unoCfg.statsWindowSize = atoi(val);
+    if (query.copyValue("statsLongWindow=", val, sizeof(val))) analysisCfg.statsLongWindow = atoi(val);
+    if (query.copyValue("momBlockLen=", val, sizeof(val)))     analysisCfg.momBlockLen = constrain(atoi(val), 1, 255);
+    if (query.copyValue("momBlocks=", val, sizeof(val)))       analysisCfg.momBlocks = constrain(atoi(val), 1, (int)MOM_MAX_BLOCKS);
+    if (query.copyValue("nominalPeriodUs=", val, sizeof(val))) analysisCfg.nominalPeriodUs = strtoul(val, nullptr, 10);
+    if (query.copyValue("psdSegmentLen=", val, sizeof(val)))   analysisCfg.psdSegmentLen = constrain(atol(val), 1L, 65535L);
     if (query.copyValue("rollingWindowMs=", val, sizeof(val))) unoCfg.rollingWindowMs = atoi(val);
-    if (query.copyValue("blockJumpUs=", val, sizeof(val)))    unoCfg.blockJumpUs = atoi(val);
     if (query.copyValue("dataUnits=", val, sizeof(val)))      shared.dataUnits = atoi(val);
 
     bool logParam=false; int logVal=0;
     if (query.copyValue("log=", val, sizeof(val))) { logParam=true; logVal=atoi(val); unoCfg.logEnabled = logVal; }
     if (query.copyValue("logDaily=", val, sizeof(val))) unoCfg.logDaily = atoi(val);
+    if (query.copyValue("logSizeRotate=", val, sizeof(val))) unoCfg.logSizeRotate = atoi(val) == 1 ? 1 : 0;
+    if (query.copyValue("logRotateMB=", val, sizeof(val))) unoCfg.logRotateMB = (uint8_t)constrain(atoi(val), 1, 255);
     if (query.copyValue("append=", val, sizeof(val))) { unoCfg.logAppend = atoi(val); SDLogger::setAppendMode(unoCfg.logAppend); }
+    if (query.copyValue("logFormat=", val, sizeof(val))) { unoCfg.logFormat = atoi(val) == 1 ? 1 : 0; SDLogger::setLogFormat((SDLogger::LogFormat)unoCfg.logFormat); }
     if (query.copyValue("file=", val, sizeof(val))) { SDLogger::setFilename(val); strncpy(unoCfg.logBaseName, SDLogger::getFilename(), LOG_FILENAME_LEN); unoCfg.logBaseName[LOG_FILENAME_LEN-1] = 0; }
-    SDLogger::setLogMode(unoCfg.logDaily ? SDLogger::LogMode::Daily : SDLogger::LogMode::Continuous);
+    SDLogger::setLogMode(SDLogger::logModeFor(unoCfg.logDaily, unoCfg.logSizeRotate == 1));
+    SDLogger::setRotateSizeMB(unoCfg.logRotateMB);
     applyUnoConfig(unoCfg);
     applyConfig(shared);
-    StatsEngine::reset();
+    applyAnalysisConfig(analysisCfg);
+    // Window sizes change in place; stored samples are only invalid if the units change.
+    if (shared.dataUnits != prevUnits) StatsEngine::reset();
+    else StatsEngine::resize();
 
     if (logParam) {
       if (logVal) SDLogger::startLogging(SDLogger::getLogMode(), false);
       else SDLogger::stopLogging();
     }
 
-    unoCfg.logEnabled = SDLogger::isLogging();
+    unoCfg.logEnabled = SDLogger::isLogEnabled();
     unoCfg.logDaily   = (SDLogger::getLogMode() == SDLogger::LogMode::Daily);
+    unoCfg.logSizeRotate = (SDLogger::getLogMode() == SDLogger::LogMode::Size) ? 1 : 0;
+    unoCfg.logRotateMB = SDLogger::getRotateSizeMB();
     unoCfg.logAppend  = SDLogger::getAppendMode();
     strncpy(unoCfg.logBaseName, SDLogger::getFilename(), LOG_FILENAME_LEN);
     unoCfg.logBaseName[LOG_FILENAME_LEN-1] = 0;
     saveConfig(shared, unoCfg);
+    saveAnalysisConfig(analysisCfg);
     response.setStatusCode(F("200 OK"));
     response.setHeader("Content-Type", "text/html");
     response.setHeader("Connection", "close");
@@ -485,8 +1061,10 @@ static void handleUnoRequest(HttpRequest& request, HttpResponse& response) {
     return;
   }
 
-  unoCfg.logEnabled = SDLogger::isLogging();
+  unoCfg.logEnabled = SDLogger::isLogEnabled();
   unoCfg.logDaily   = (SDLogger::getLogMode() == SDLogger::LogMode::Daily);
+  unoCfg.logSizeRotate = (SDLogger::getLogMode() == SDLogger::LogMode::Size) ? 1 : 0;
+  unoCfg.logRotateMB = SDLogger::getRotateSizeMB();
   unoCfg.logAppend  = SDLogger::getAppendMode();
   strncpy(unoCfg.logBaseName, SDLogger::getFilename(), LOG_FILENAME_LEN);
   unoCfg.logBaseName[LOG_FILENAME_LEN-1] = 0;
@@ -498,13 +1076,20 @@ static void handleUnoRequest(HttpRequest& request, HttpResponse& response) {
   response.println(F("<h2>UNO Tunables</h2>"));
   response.println(F("<form action='/uno' method='get'>"));
   response.print(F("statsWindowSize: <input name='statsWindowSize' value='")); response.print(unoCfg.statsWindowSize); response.println(F("'><br>"));
+  response.print(F("statsLongWindow: <input name='statsLongWindow' value='")); response.print(analysisCfg.statsLongWindow); response.println(F("'><br>"));
+  response.print(F("momBlockLen: <input name='momBlockLen' value='")); response.print(analysisCfg.momBlockLen); response.println(F("'><br>"));
+  response.print(F("momBlocks: <input name='momBlocks' value='")); response.print(analysisCfg.momBlocks); response.println(F("'><br>"));
+  response.print(F("nominalPeriodUs: <input name='nominalPeriodUs' value='")); response.print(analysisCfg.nominalPeriodUs); response.println(F("'><br>"));
+  response.print(F("psdSegmentLen: <input name='psdSegmentLen' value='")); response.print(analysisCfg.psdSegmentLen); response.println(F("'><br>"));
   response.print(F("rollingWindowMs: <input name='rollingWindowMs' value='")); response.print(unoCfg.rollingWindowMs); response.println(F("'><br>"));
-  response.print(F("blockJumpUs: <input name='blockJumpUs' value='")); response.print(unoCfg.blockJumpUs); response.println(F("'><br>"));
   response.print(F("dataUnits: <input name='dataUnits' value='")); response.print(shared.dataUnits); response.println(F("'><br>"));
 
   response.print(F("log: <input name='log' value='")); response.print(unoCfg.logEnabled ? 1 : 0); response.println(F("'><br>"));
   response.print(F("logDaily: <input name='logDaily' value='")); response.print(unoCfg.logDaily ? 1 : 0); response.println(F("'><br>"));
   response.print(F("append: <input name='append' value='")); response.print(unoCfg.logAppend ? 1 : 0); response.println(F("'><br>"));
+  response.print(F("logFormat: <input name='logFormat' value='")); response.print(unoCfg.logFormat); response.println(F("'><br>"));
+  response.print(F("logSizeRotate: <input name='logSizeRotate' value='")); response.print(unoCfg.logSizeRotate); response.println(F("'><br>"));
+  response.print(F("logRotateMB: <input name='logRotateMB' value='")); response.print(unoCfg.logRotateMB); response.println(F("'><br>"));
   response.print(F("file: <input name='file' value='")); response.print(unoCfg.logBaseName); response.println(F("'><br>"));
   response.println(F("<input type='submit' value='Save'></form>"));
   response.println(F("<p>Configure WiFi on the <a href='/wifi'>WiFi page</a>.</p>"));
@@ -662,6 +1247,29 @@ static void handleUnknown(HttpRequest& request, HttpResponse& response) {
     httpServer.on(Method::GET, "/nano", handleNanoRequest);
     httpServer.on(Method::GET, "/stats", handleStatsRequest);
     httpServer.on(Method::GET, "/stats.json", handleStatsJsonRequest);
+#if ENABLE_ADEV
+    httpServer.on(Method::GET, "/adev.json", handleAdevJsonRequest);
+#endif
+#if ENABLE_PSD
+    httpServer.on(Method::GET, "/psd.json", handlePsdJsonRequest);
+#endif
+#if ENABLE_GOERTZEL
+    httpServer.on(Method::GET, "/goertzel.json", handleGoertzelJsonRequest);
+#endif
+#if ENABLE_DEV_HIST
+    httpServer.on(Method::GET, "/hist.json", handleHistJsonRequest);
+#endif
+#if ENABLE_ENV_REGRESSION
+    httpServer.on(Method::GET, "/env.json", handleEnvJsonRequest);
+#endif
+    httpServer.on(Method::GET, "/sd.json", handleSdJsonRequest);
+#if ENABLE_ROLLUPS
+    httpServer.on(Method::GET, "/rollup.json", handleRollupJsonRequest);
+#endif
+    httpServer.on(Method::GET, "/changes.json", handleChangesJsonRequest);
+#if ENABLE_DISTURBANCE
+    httpServer.on(Method::GET, "/profile.json", handleProfileJsonRequest);
+#endif
     httpServer.on(Method::GET, "/log", handleLogRequest);
     httpServer.on(Method::GET, "/logfiles", handleLogFilesRequest);
     httpServer.on(Method::GET, "/download", handleDownloadRequest);
@@ -0,0 +1,274 @@
+#include "LogIndex.h"
+#include "BinLog.h"
+#include "SDLogger.h"
+#include <SD.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace LogIndex {
+
+struct Batch {
+  char          path[LOG_PATH_LEN];   // index file
+  LogIndexEntry entries[LOG_INDEX_BATCH];
+  uint8_t       count;
+  bool          binary;
+};
+
+// Double-buffered: new entries go to batches[fill]; the other one, when not
+// empty, is waiting for service().
+static Batch batches[2];
+static uint8_t fill = 0;
+static uint32_t written = 0;
+static uint32_t dropped = 0;
+
+static bool hasExt(const char *path, const char *ext) {
+  const char *dot = strrchr(path, '.');
+  return dot && strcasecmp(dot, ext) == 0;
+}
+
+void pathFor(char *out, size_t len, const char *dataPath) {
+  const char *dot = strrchr(dataPath, '.');
+  const char *slash = strrchr(dataPath, '/');
+  int base = (dot && (!slash || dot > slash)) ? (int)(dot - dataPath) : (int)strlen(dataPath);
+  snprintf(out, len, "%.*s%s", base, dataPath, hasExt(dataPath, ".bin") ? ".bix" : ".idx");
+}
+
+bool isIndexPath(const char *path) {
+  return path && (hasExt(path, ".idx") || hasExt(path, ".bix"));
+}
+
+// Card time is reported to SDLogger's health histograms as an open, one
+// write (the header included) and a close.
+static void writeBatch(Batch &b) {
+  uint32_t t0 = micros();
+  File f = SD.open(b.path, O_READ | O_WRITE | O_CREAT);
+  SDLogger::recordSdOp(SDLogger::SdOp::Open, micros() - t0);
+  if (!f) {
+    SDLogger::recordSdError(SDLogger::SdError::Index);
+    dropped += b.count;
+    b.count = 0;
+    return;
+  }
+  t0 = micros();
+  uint32_t size = (uint32_t)f.size();
+  uint32_t bytes = 0;
+  if (size < sizeof(LogIndexHeader)) {
+    LogIndexHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = LOG_INDEX_MAGIC;
+    h.version = LOG_INDEX_VERSION;
+    h.header_bytes = sizeof(LogIndexHeader);
+    h.entry_bytes = sizeof(LogIndexEntry);
+    h.interval = b.binary ? BINLOG_SYNC_INTERVAL : LOG_INDEX_INTERVAL;
+    h.binary = b.binary ? 1 : 0;
+    f.seek(0);
+    bytes += (uint32_t)f.write((const uint8_t*)&h, sizeof(h));
+    size = sizeof(h);
+  } else {
+    size -= (size - sizeof(LogIndexHeader)) % sizeof(LogIndexEntry);   // a torn entry
+  }
+  f.seek(size);
+  size_t want = (size_t)b.count * sizeof(LogIndexEntry);
+  size_t w = f.write((const uint8_t*)b.entries, want);
+  bytes += (uint32_t)w;
+  SDLogger::recordSdOp(SDLogger::SdOp::Write, micros() - t0, bytes);
+  if (w == want) {
+    written += b.count;
+  } else {
+    SDLogger::recordSdError(SDLogger::SdError::Index);
+    dropped += b.count;
+  }
+  t0 = micros();
+  f.close();
+  SDLogger::recordSdOp(SDLogger::SdOp::Close, micros() - t0);
+  b.count = 0;
+}
+
+void add(const char *dataPath, bool binary, uint32_t swingId, uint32_t offset) {
+  char path[LOG_PATH_LEN];
+  pathFor(path, sizeof(path), dataPath);
+  Batch *b = &batches[fill];
+  if (b->count && (b->count >= LOG_INDEX_BATCH || strcmp(b->path, path) != 0)) {
+    Batch &other = batches[fill ^ 1];
+    if (other.count) {
+      dropped++;
+      return;
+    }
+    fill ^= 1;
+    b = &other;
+  }
+  if (!b->count) {
+    strncpy(b->path, path, LOG_PATH_LEN - 1);
+    b->path[LOG_PATH_LEN - 1] = 0;
+    b->binary = binary;
+  }
+  LogIndexEntry &e = b->entries[b->count++];
+  e.swing_id = swingId;
+  e.epoch = (uint32_t)SDLogger::currentEpoch();
+  e.uptime_ms = millis();
+  e.offset = offset;
+}
+
+void remove(const char *dataPath) {
+  char path[LOG_PATH_LEN];
+  pathFor(path, sizeof(path), dataPath);
+  for (Batch &b : batches) {
+    if (b.count && strcmp(b.path, path) == 0) b.count = 0;
+  }
+  uint32_t t0 = micros();
+  SD.remove(path);
+  SDLogger::recordSdOp(SDLogger::SdOp::Dir, micros() - t0);
+}
+
+bool service() {
+  Batch &waiting = batches[fill ^ 1];
+  if (waiting.count) {
+    writeBatch(waiting);
+    return true;
+  }
+  Batch &current = batches[fill];
+  if (current.count >= LOG_INDEX_BATCH) {
+    fill ^= 1;
+    writeBatch(current);
+    return true;
+  }
+  return false;
+}
+
+void flush() {
+  if (batches[fill ^ 1].count) writeBatch(batches[fill ^ 1]);
+  if (batches[fill].count) writeBatch(batches[fill]);
+}
+
+// Entries still in RAM may point at rows that never reached the card; an
+// index without them is only coarser.
+void discard() {
+  for (Batch &b : batches) {
+    dropped += b.count;
+    b.count = 0;
+  }
+}
+
+// Entries are fed in file order. A swing id lower than the one before starts
+// a new run (a reboot while appending).
+struct RangeScan {
+  Key      key;
+  uint32_t lo, hi;
+  bool     started = false;     // start found, looking for the end
+  bool     done = false;
+  bool     none = false;        // nothing in range
+  bool     firstRun = true;
+  bool     skipRun = false;     // this run starts after lo
+  bool     havePrev = false;
+  uint32_t prevKey = 0;
+  bool     haveCand = false;    // last entry <= lo in this run
+  uint32_t cand = 0;
+  bool     haveTail = false;    // first earlier run ending at or below lo
+  uint32_t tailStart = 0, tailEnd = 0;
+  uint32_t start = 0, end = 0;
+
+  void feed(const LogIndexEntry &e) {
+    if (done) return;
+    uint32_t k = key == Key::Swing ? e.swing_id : e.epoch;
+    if (key == Key::Epoch && k == 0) return;   // before NTP sync
+    if (key == Key::Swing && havePrev && k < prevKey) {
+      if (started) {
+        end = e.offset;
+        done = true;
+        return;
+      }
+      if (haveCand && !haveTail) {
+        haveTail = true;
+        tailStart = cand;
+        tailEnd = e.offset;
+      }
+      haveCand = false;
+      firstRun = false;
+      skipRun = false;
+    }
+    havePrev = true;
+    prevKey = k;
+    if (started) {
+      if (k > hi) {
+        end = e.offset;
+        done = true;
+      }
+      return;
+    }
+    if (skipRun) return;
+    if (k <= lo) {
+      haveCand = true;
+      cand = e.offset;
+      return;
+    }
+    if (haveCand) {
+      start = cand;
+    } else if (firstRun) {
+      if (k > hi) {            // the whole range precedes the file
+        none = done = true;
+        return;
+      }
+      start = 0;
+    } else {
+      skipRun = true;
+      return;
+    }
+    started = true;
+    if (k > hi) {
+      end = e.offset;
+      done = true;
+    }
+  }
+};
+
+bool findRange(const char *dataPath, Key key, uint32_t lo, uint32_t hi, uint32_t dataLen,
+               uint32_t &start, uint32_t &end) {
+  if (hi < lo) return false;
+  RangeScan scan;
+  scan.key = key;
+  scan.lo = lo;
+  scan.hi = hi;
+
+  char path[LOG_PATH_LEN];
+  pathFor(path, sizeof(path), dataPath);
+  File f = SD.open(path, FILE_READ);
+  if (f) {
+    LogIndexHeader h;
+    if (f.read((uint8_t*)&h, sizeof(h)) == (int)sizeof(h) && h.magic == LOG_INDEX_MAGIC &&
+        h.entry_bytes == sizeof(LogIndexEntry) && f.seek(h.header_bytes)) {
+      LogIndexEntry chunk[8];
+      int n;
+      while (!scan.done && (n = f.read((uint8_t*)chunk, sizeof(chunk))) >= (int)sizeof(LogIndexEntry)) {
+        for (int i = 0; i < n / (int)sizeof(LogIndexEntry); ++i) scan.feed(chunk[i]);
+      }
+    }
+    f.close();
+  }
+  // Entries not on the card yet, oldest batch first.
+  for (uint8_t i = 1; i <= 2; ++i) {
+    const Batch &b = batches[(fill + i) & 1];
+    if (!b.count || strcmp(b.path, path) != 0) continue;
+    for (uint8_t j = 0; j < b.count; ++j) scan.feed(b.entries[j]);
+  }
+
+  if (scan.none) return false;
+  if (scan.started) {
+    start = scan.start;
+    end = scan.done ? scan.end : dataLen;
+  } else if (scan.haveTail) {    // lo past the last entry of a run: the first such run
+    start = scan.tailStart;
+    end = scan.tailEnd;
+  } else if (scan.haveCand) {
+    start = scan.cand;
+    end = dataLen;
+  } else {
+    return false;
+  }
+  if (end > dataLen) end = dataLen;
+  return start < end;
+}
+
+uint32_t entriesWritten() { return written; }
+uint32_t droppedEntries() { return dropped; }
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// LogIndex.h
+// Sparse sidecar index of the raw log, for swing/time range extracts.
+//
+// Beside each raw file (pendulum.csv -> pendulum.idx, *.bin -> *.bix) the
+// logger keeps a LogIndexHeader followed by one LogIndexEntry per
+// LOG_INDEX_INTERVAL CSV rows, or per binary block (the record after each
+// header or sync marker, so an extract decodes from its first byte). Each
+// entry is the swing id, the time and the byte offset of that row.
+//
+// Entries collect in RAM and are appended LOG_INDEX_BATCH at a time from an
+// idle writer slice (one open/write/close); a reset loses at most one batch,
+// which only makes lookups near the tail coarser. The index is a lower bound:
+// a range always starts at or before the wanted row and ends at or after it.
+// Swing ids restart at a reboot, so an appended file can hold several runs;
+// a swing lookup takes the first run that contains it.
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Config.h"
+
+constexpr uint32_t LOG_INDEX_MAGIC   = 0x58495450;   // "PTIX" on disk
+constexpr uint16_t LOG_INDEX_VERSION = 1;
+
+struct __attribute__((packed)) LogIndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_bytes;    // sizeof(LogIndexHeader)
+  uint16_t entry_bytes;     // sizeof(LogIndexEntry)
+  uint16_t interval;        // rows per entry (CSV) or records per block (binary)
+  uint8_t  binary;          // 1 when the data file is a binary log
+  uint8_t  reserved[3];
+};
+static_assert(sizeof(LogIndexHeader) == 16, "LogIndexHeader layout changed");
+
+struct __attribute__((packed)) LogIndexEntry {
+  uint32_t swing_id;
+  uint32_t epoch;           // UTC seconds, 0 before NTP sync
+  uint32_t uptime_ms;
+  uint32_t offset;          // byte offset of the row in the data file
+};
+static_assert(sizeof(LogIndexEntry) == 16, "LogIndexEntry layout changed");
+
+namespace LogIndex {
+  enum class Key : uint8_t { Swing = 0, Epoch = 1 };
+
+  // Index path for a data file: its extension replaced by .idx (CSV) or .bix.
+  void pathFor(char *out, size_t len, const char *dataPath);
+  bool isIndexPath(const char *path);
+
+  void add(const char *dataPath, bool binary, uint32_t swingId, uint32_t offset);
+  void remove(const char *dataPath);   // the data file is being recreated
+  bool service();                      // writes a full batch; true if it used the card
+  void flush();                        // blocking: writes everything held in RAM
+  void discard();                      // the card went away: drops what RAM holds
+
+  // Byte range [start, end) of `dataPath` covering keys lo..hi, within the
+  // first `dataLen` bytes. False if no indexed run contains lo.
+  bool findRange(const char *dataPath, Key key, uint32_t lo, uint32_t hi, uint32_t dataLen,
+                 uint32_t &start, uint32_t &end);
+
+  uint32_t entriesWritten();
+  uint32_t droppedEntries();           // no batch free (two file switches within one slice)
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// MedianOfMeans.h
+// Incremental median-of-means estimator in a fixed arena.
+//
+// Samples are averaged in blocks of K; the estimate is the median of the last
+// M completed block means. A single impulsive swing (a missed drive, a knock)
+// can only move one block mean, so it cannot drag the estimate the way it
+// drags a plain mean. Each sample costs O(1); each completed block updates a
+// sorted copy of the block means in O(M), so the amortised cost per sample is
+// O(M/K). Kept free of Arduino dependencies.
+// -----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+template <uint8_t MAXM>
+class MedianOfMeans {
+public:
+  static_assert(MAXM > 0, "MedianOfMeans needs at least one block");
+
+  MedianOfMeans() { configure(1, 1); }
+
+  // Block length K (>= 1) and block count M (1..MAXM). Clears the history.
+  void configure(uint8_t k, uint8_t m) {
+    k_ = k ? k : 1;
+    m_ = m == 0 ? 1 : (m > MAXM ? MAXM : m);
+    reset();
+  }
+
+  void reset() {
+    sum_ = 0.0;
+    inBlock_ = 0;
+    head_ = 0;
+    filled_ = 0;
+  }
+
+  // Returns true when this sample completed a block (the median moved).
+  bool add(double x) {
+    sum_ += x;
+    if (++inBlock_ < k_) return false;
+    float mean = (float)(sum_ / (double)k_);
+    sum_ = 0.0;
+    inBlock_ = 0;
+    if (filled_ == m_) {
+      eraseSorted(ring_[head_]);
+    } else {
+      filled_++;
+    }
+    ring_[head_] = mean;
+    head_ = (uint8_t)((head_ + 1) % m_);
+    insertSorted(mean);
+    return true;
+  }
+
+  uint8_t blockLen() const { return k_; }
+  uint8_t blockCount() const { return m_; }
+  uint8_t blocks() const { return filled_; }     // completed blocks held
+  bool ready() const { return filled_ == m_; }
+
+  float median() const {
+    if (!filled_) return 0.0f;
+    uint8_t n = filled_;
+    return 0.5f * (sorted_[(n - 1) / 2] + sorted_[n / 2]);
+  }
+
+private:
+  void eraseSorted(float v) {
+    uint8_t last = (uint8_t)(filled_ - 1);   // if not found earlier, it is the last entry
+    uint8_t i = 0;
+    while (i < last && sorted_[i] != v) ++i;
+    for (; i + 1 < filled_; ++i) sorted_[i] = sorted_[i + 1];
+  }
+
+  void insertSorted(float v) {
+    uint8_t i = (uint8_t)(filled_ - 1);
+    while (i > 0 && sorted_[i - 1] > v) {
+      sorted_[i] = sorted_[i - 1];
+      --i;
+    }
+    sorted_[i] = v;
+  }
+
+  float    ring_[MAXM];     // block means in arrival order
+  float    sorted_[MAXM];   // the same values, ascending
+  double   sum_;
+  uint8_t  k_;
+  uint8_t  m_;
+  uint8_t  inBlock_;
+  uint8_t  head_;
+  uint8_t  filled_;
+};
@@ -8,6 +8,7 @@ constexpr unsigned long RAM_CHECK_INTERVAL_MS = 2000;
 
 enum RamState { RAM_OK, RAM_LOW, RAM_CRIT };
 static RamState ramState = RAM_OK;
+static bool ramReported = false;   // the first reading is always shown
 static unsigned long lastRamCheck = 0;
 
 extern "C" char* sbrk(int);
@@ -21,8 +22,9 @@ void poll() {
   lastRamCheck = millis();
   int fr = freeRam();
   RamState newState = (fr < RAM_CRIT_THRESHOLD) ? RAM_CRIT : (fr < RAM_WARN_THRESHOLD ? RAM_LOW : RAM_OK);
-  if (newState != ramState) {
+  if (newState != ramState || !ramReported) {
     ramState = newState;
+    ramReported = true;
     char msg[40];
     switch (ramState) {
       case RAM_OK:
@@ -1,6 +1,7 @@
 #include "NanoComm.h"
 #include "Display.h"
 #include "SDLogger.h"
+#include "BinLog.h"
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
@@ -8,21 +9,12 @@
 namespace NanoComm {
 
 PendulumSample currentSample = {0};
+static uint32_t swingId = 0;
 static bool csvStreamingStarted = false;
 static char csvHeader[256];
 
 static DataUnits dataUnits = DATA_UNITS_DEFAULT;
-static constexpr uint32_t NANO_TICK_FREQ = 16000000UL;
-
-static const char* dataUnitsLabel() {
-  switch (dataUnits) {
-    case DataUnits::RawCycles:  return "cycles";
-    case DataUnits::AdjustedMs: return "ms";
-    case DataUnits::AdjustedUs: return "us";
-    case DataUnits::AdjustedNs: return "ns";
-    default: return "units";
-  }
-}
+static constexpr uint32_t NANO_TICK_FREQ = NANO_TICK_HZ;
 
 static bool isNumericToken(const char* tok) {
   if (!tok || !*tok) return false;
@@ -65,10 +57,7 @@ static uint32_t unitsToTicks(uint32_t v, int32_t corr_ppm) {
 }
 
 static void buildCsvHeader() {
-  const char* units = dataUnitsLabel();
-  snprintf(csvHeader, sizeof(csvHeader),
-           "tick_%s,tock_%s,tick_block_%s,tock_block_%s,corr_inst_ppm,corr_blend_ppm,gps_status,dropped,temperature_C,humidity_pct,pressure_hPa",
-           units, units, units, units);
+  rawLogCsvHeader(csvHeader, sizeof(csvHeader), dataUnits);
 }
 
 uint32_t ticksToMicros(uint32_t ticks) {
@@ -82,6 +71,13 @@ float ticksToMs(uint32_t ticks, int32_t corr_ppm) {
   return (float)((adjusted * 1000.0) / (double)NANO_TICK_FREQ);
 }
 
+double ticksToSeconds(uint32_t ticks, int32_t corr_ppm) {
+  double adjusted =
+      (double)ticks * ((double)CORR_PPM_SCALE + (double)corr_ppm) /
+      (double)CORR_PPM_SCALE;
+  return adjusted / (double)NANO_TICK_FREQ;
+}
+
 uint32_t ticksToUnits(uint32_t ticks, int32_t corr_blend_ppm) {
   uint64_t adjusted = ((uint64_t)ticks * (CORR_PPM_SCALE + (int64_t)corr_blend_ppm)) / CORR_PPM_SCALE;
   switch (dataUnits) {
@@ -100,6 +96,8 @@ uint32_t ticksToUnits(uint32_t ticks, int32_t corr_blend_ppm) {
 
 DataUnits getDataUnits() { return dataUnits; }
 
+uint32_t currentSwingId() { return swingId; }
+
 bool streamingStarted() { return csvStreamingStarted; }
 
 bool parseLine(const char* line) {
@@ -142,7 +140,9 @@ bool parseLine(const char* line) {
   currentSample.tock       = unitsToTicks(tock_raw, corr_blend_ppm_tmp);
   currentSample.tick_block = unitsToTicks(tick_block_raw, corr_blend_ppm_tmp);
   currentSample.tock_block = unitsToTicks(tock_block_raw, corr_blend_ppm_tmp);
-  return (fieldIndex == CF_COUNT);
+  if (fieldIndex != CF_COUNT) return false;
+  swingId++;
+  return true;
 }
 
 void readStartup() {
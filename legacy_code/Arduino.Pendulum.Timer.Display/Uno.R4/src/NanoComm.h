@@ -5,12 +5,14 @@
 
 namespace NanoComm {
   extern PendulumSample currentSample;
+  uint32_t currentSwingId();   // monotonic id of currentSample (UNO-assigned)
   bool parseLine(const char* line);
   void readStartup();
   bool streamingStarted();
   const char* getCSVHeader();
   uint32_t ticksToMicros(uint32_t ticks);
   float ticksToMs(uint32_t ticks, int32_t corr_ppm);
+  double ticksToSeconds(uint32_t ticks, int32_t corr_ppm);
   uint32_t ticksToUnits(uint32_t ticks, int32_t corr_blend_ppm);
   DataUnits getDataUnits();
 }
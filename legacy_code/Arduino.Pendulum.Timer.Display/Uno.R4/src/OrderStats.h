@@ -0,0 +1,214 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// OrderStats.h
+// Sliding-window order statistics (median, MAD, quantiles) in a fixed arena.
+//
+// A treap keyed by (value, slot) with subtree sizes. Node storage is indexed
+// by the caller's ring slot, so inserting a new sample and erasing the evicted
+// one are both O(log n) with no allocation. Priorities are a hash of the slot
+// index and are never stored.
+//
+// median()/quantile() are O(log n); mad() binary-searches the deviation and is
+// O(log n * log range). Kept free of Arduino dependencies.
+// -----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+template <uint16_t N>
+class OrderStatTree {
+public:
+  static constexpr uint16_t NIL = 0xFFFF;
+  static_assert(N < NIL, "OrderStatTree capacity must fit uint16_t slot indices");
+
+  OrderStatTree() { clear(); }
+
+  void clear() {
+    root_ = NIL;
+    for (uint16_t i = 0; i < N; ++i) size_[i] = 0;  // size 0 marks a free slot
+  }
+
+  uint16_t size() const { return sz(root_); }
+  bool contains(uint16_t slot) const { return slot < N && size_[slot] != 0; }
+
+  // Insert `value` under ring slot `slot`. The slot must not already be used.
+  void insert(uint16_t slot, int32_t value) {
+    if (slot >= N || size_[slot] != 0) return;
+    key_[slot] = value;
+    left_[slot] = NIL;
+    right_[slot] = NIL;
+    size_[slot] = 1;
+    root_ = insertAt(root_, slot);
+  }
+
+  void erase(uint16_t slot) {
+    if (!contains(slot)) return;
+    root_ = eraseAt(root_, slot);
+    size_[slot] = 0;
+  }
+
+  // k-th smallest value, 0-based. Returns 0 when k is out of range.
+  int32_t kth(uint16_t k) const {
+    uint16_t t = root_;
+    while (t != NIL) {
+      uint16_t ls = sz(left_[t]);
+      if (k < ls) {
+        t = left_[t];
+      } else if (k == ls) {
+        return key_[t];
+      } else {
+        k -= ls + 1;
+        t = right_[t];
+      }
+    }
+    return 0;
+  }
+
+  // Number of values strictly below / at or below `v`.
+  uint16_t countLess(int64_t v) const {
+    uint16_t n = 0;
+    uint16_t t = root_;
+    while (t != NIL) {
+      if ((int64_t)key_[t] < v) {
+        n += sz(left_[t]) + 1;
+        t = right_[t];
+      } else {
+        t = left_[t];
+      }
+    }
+    return n;
+  }
+
+  uint16_t countLessEqual(int64_t v) const { return countLess(v + 1); }
+
+  // Quantile with linear interpolation between order statistics, q in [0,1].
+  float quantile(float q) const {
+    uint16_t n = size();
+    if (n == 0) return 0.0f;
+    if (q <= 0.0f) return (float)kth(0);
+    if (q >= 1.0f) return (float)kth(n - 1);
+    float pos = q * (float)(n - 1);
+    uint16_t lo = (uint16_t)pos;
+    float frac = pos - (float)lo;
+    float a = (float)kth(lo);
+    if (frac == 0.0f || lo + 1 >= n) return a;
+    return a + frac * ((float)kth(lo + 1) - a);
+  }
+
+  float median() const {
+    uint16_t n = size();
+    if (n == 0) return 0.0f;
+    return (float)twiceMedian() * 0.5f;
+  }
+
+  // Median absolute deviation from the median (unscaled).
+  float mad() const {
+    uint16_t n = size();
+    if (n < 2) return 0.0f;
+    // Work in doubled units so an even-count median stays integral.
+    int64_t m2 = twiceMedian();
+    uint16_t lo = (n - 1) / 2;
+    uint16_t hi = n / 2;
+    int64_t dLo = kthDoubledDeviation(m2, lo);
+    int64_t dHi = (hi == lo) ? dLo : kthDoubledDeviation(m2, hi);
+    return (float)(dLo + dHi) * 0.25f;
+  }
+
+private:
+  uint16_t sz(uint16_t t) const { return t == NIL ? 0 : size_[t]; }
+
+  static uint16_t prio(uint16_t slot) {
+    uint32_t h = (uint32_t)slot * 0x9E3779B1u;
+    h ^= h >> 15;
+    h *= 0x85EBCA77u;
+    h ^= h >> 13;
+    return (uint16_t)h;
+  }
+
+  bool lessThan(uint16_t a, uint16_t b) const {
+    return key_[a] < key_[b] || (key_[a] == key_[b] && a < b);
+  }
+
+  void pull(uint16_t t) { size_[t] = (uint16_t)(1 + sz(left_[t]) + sz(right_[t])); }
+
+  uint16_t rotateRight(uint16_t t) {
+    uint16_t l = left_[t];
+    left_[t] = right_[l];
+    right_[l] = t;
+    pull(t);
+    pull(l);
+    return l;
+  }
+
+  uint16_t rotateLeft(uint16_t t) {
+    uint16_t r = right_[t];
+    right_[t] = left_[r];
+    left_[r] = t;
+    pull(t);
+    pull(r);
+    return r;
+  }
+
+  uint16_t insertAt(uint16_t t, uint16_t node) {
+    if (t == NIL) return node;
+    if (lessThan(node, t)) {
+      left_[t] = insertAt(left_[t], node);
+      pull(t);
+      if (prio(left_[t]) > prio(t)) t = rotateRight(t);
+    } else {
+      right_[t] = insertAt(right_[t], node);
+      pull(t);
+      if (prio(right_[t]) > prio(t)) t = rotateLeft(t);
+    }
+    return t;
+  }
+
+  uint16_t eraseAt(uint16_t t, uint16_t node) {
+    if (t == NIL) return NIL;
+    if (t == node) {
+      if (left_[t] == NIL) return right_[t];
+      if (right_[t] == NIL) return left_[t];
+      if (prio(left_[t]) > prio(right_[t])) {
+        t = rotateRight(t);
+        right_[t] = eraseAt(right_[t], node);
+      } else {
+        t = rotateLeft(t);
+        left_[t] = eraseAt(left_[t], node);
+      }
+    } else if (lessThan(node, t)) {
+      left_[t] = eraseAt(left_[t], node);
+    } else {
+      right_[t] = eraseAt(right_[t], node);
+    }
+    pull(t);
+    return t;
+  }
+
+  int64_t twiceMedian() const {
+    uint16_t n = size();
+    return (int64_t)kth((n - 1) / 2) + (int64_t)kth(n / 2);
+  }
+
+  // k-th smallest |2x - m2| (0-based), found by binary search on the
+  // deviation: values within D of m2 lie in [(m2 - D)/2, (m2 + D)/2].
+  int64_t kthDoubledDeviation(int64_t m2, uint16_t k) const {
+    int64_t lo = 0;
+    int64_t hi = 2 * ((int64_t)kth(size() - 1) - (int64_t)kth(0)) + 1;
+    while (lo < hi) {
+      int64_t d = lo + (hi - lo) / 2;
+      int64_t minX = floorDiv2(m2 - d + 1);   // ceil((m2 - d) / 2)
+      int64_t maxX = floorDiv2(m2 + d);
+      uint16_t within = countLessEqual(maxX) - countLess(minX);
+      if (within > k) hi = d; else lo = d + 1;
+    }
+    return lo;
+  }
+
+  static int64_t floorDiv2(int64_t v) { return v >= 0 ? v / 2 : -((-v + 1) / 2); }
+
+  int32_t  key_[N];
+  uint16_t left_[N];
+  uint16_t right_[N];
+  uint16_t size_[N];
+  uint16_t root_;
+};
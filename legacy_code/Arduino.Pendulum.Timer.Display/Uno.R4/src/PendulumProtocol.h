@@ -130,6 +130,7 @@ inline const char* dataUnitsTag(DataUnits du) {
 }
 
 static constexpr int32_t CORR_PPM_SCALE = 1000000;
+static constexpr uint32_t NANO_TICK_HZ = 16000000UL;   // nominal Nano timer clock
 
 // Serial baud rate
 #define SERIAL_BAUD_NANO   115200
@@ -0,0 +1,223 @@
+#include "Rollups.h"
+#include "NanoComm.h"
+
+#include <math.h>
+
+#if ENABLE_ROLLUPS
+
+namespace Rollups {
+
+// Open (still accumulating) entry, kept in double.
+struct Accumulator {
+  uint32_t start_s = 0;
+  uint32_t count = 0;
+  double   mean = 0.0;
+  double   m2 = 0.0;
+  float    minDev = 0.0f;
+  float    maxDev = 0.0f;
+  uint16_t children = 0;   // closed lower-tier entries merged in
+
+  void clear(uint32_t start) {
+    start_s = start;
+    count = 0;
+    mean = 0.0;
+    m2 = 0.0;
+    children = 0;
+  }
+
+  void add(double x) {
+    float xf = (float)x;
+    if (!count || xf < minDev) minDev = xf;
+    if (!count || xf > maxDev) maxDev = xf;
+    count++;
+    double delta = x - mean;
+    mean += delta / (double)count;
+    m2 += delta * (x - mean);
+  }
+
+  // Chan et al. combination of two (count, mean, M2) summaries.
+  void merge(const RollupEntry &e) {
+    children++;
+    if (!e.count) return;
+    if (!count || e.min_dev_us < minDev) minDev = e.min_dev_us;
+    if (!count || e.max_dev_us > maxDev) maxDev = e.max_dev_us;
+    double n = (double)count + (double)e.count;
+    double delta = (double)e.mean_dev_us - mean;
+    mean += delta * (double)e.count / n;
+    m2 += (double)e.m2 + delta * delta * (double)count * (double)e.count / n;
+    count += e.count;
+  }
+
+  RollupEntry close() const {
+    RollupEntry e;
+    e.start_s = start_s;
+    e.count = count;
+    e.mean_dev_us = (float)mean;
+    e.min_dev_us = count ? minDev : 0.0f;
+    e.max_dev_us = count ? maxDev : 0.0f;
+    e.m2 = (float)m2;
+    return e;
+  }
+};
+
+struct TierStore {
+  RollupEntry *ring;
+  uint16_t     cap;
+  uint16_t     head;      // next write slot
+  uint16_t     filled;
+  Accumulator  open;
+
+  void push(const RollupEntry &e) {
+    ring[head] = e;
+    head = (uint16_t)((head + 1) % cap);
+    if (filled < cap) filled++;
+  }
+
+  const RollupEntry &newest(uint16_t i) const {
+    return ring[(uint16_t)((head + cap - 1 - i) % cap)];
+  }
+};
+
+static RollupEntry minuteRing[ROLLUP_MINUTES];
+static RollupEntry hourRing[ROLLUP_HOURS];
+static RollupEntry dayRing[ROLLUP_DAYS];
+
+static TierStore tiers[TierCount] = {
+  { minuteRing, ROLLUP_MINUTES, 0, 0, {} },
+  { hourRing,   ROLLUP_HOURS,   0, 0, {} },
+  { dayRing,    ROLLUP_DAYS,    0, 0, {} },
+};
+
+// Entries per closed parent entry, and entries per day for each tier.
+static constexpr uint16_t CHILDREN_PER_PARENT[TierCount] = { 0, 60, 24 };
+static constexpr float    ENTRIES_PER_DAY[TierCount]     = { 1440.0f, 24.0f, 1.0f };
+
+static double   elapsedS = 0.0;
+static double   minuteEndS = 60.0;
+static double   refUs = 0.0;
+static uint16_t lastDropped = 0;
+static bool     haveSample = false;
+
+void reset() {
+  for (uint8_t t = 0; t < TierCount; ++t) {
+    tiers[t].head = 0;
+    tiers[t].filled = 0;
+    tiers[t].open.clear(0);
+  }
+  elapsedS = 0.0;
+  minuteEndS = 60.0;
+  refUs = 0.0;
+  haveSample = false;
+}
+
+static void closeMinute() {
+  RollupEntry e = tiers[Minute].open.close();
+  tiers[Minute].push(e);
+  uint32_t now = (uint32_t)minuteEndS;
+  tiers[Minute].open.clear(now);
+  for (uint8_t t = Hour; t < TierCount; ++t) {
+    Accumulator &acc = tiers[t].open;
+    acc.merge(e);
+    if (acc.children < CHILDREN_PER_PARENT[t]) break;
+    e = acc.close();
+    tiers[t].push(e);
+    acc.clear(now);
+  }
+}
+
+void update(const PendulumSample &sample) {
+  uint32_t ticks = sample.tick + sample.tock + sample.tick_block + sample.tock_block;
+  if (ticks == 0) return;
+  double periodS = NanoComm::ticksToSeconds(ticks, sample.corr_blend_ppm);
+
+  // A dropped edge still took real time but is not a valid period.
+  bool dropped = haveSample && sample.dropped_events != lastDropped;
+  lastDropped = sample.dropped_events;
+  haveSample = true;
+
+  elapsedS += periodS;
+  if (!dropped) {
+    double periodUs = periodS * 1e6;
+    if (refUs <= 0.0) {
+      refUs = AnalysisTunables::nominalPeriodUs ? (double)AnalysisTunables::nominalPeriodUs : periodUs;
+    }
+    tiers[Minute].open.add(periodUs - refUs);
+  }
+  while (elapsedS >= minuteEndS) {
+    closeMinute();
+    minuteEndS += 60.0;
+  }
+}
+
+uint16_t capacity(Tier t) { return t < TierCount ? tiers[t].cap : 0; }
+uint16_t entries(Tier t) { return t < TierCount ? tiers[t].filled : 0; }
+
+bool entry(Tier t, uint16_t i, RollupEntry &out) {
+  if (t >= TierCount || i >= tiers[t].filled) return false;
+  out = tiers[t].newest(i);
+  return true;
+}
+
+float rateSecPerDay(const RollupEntry &e) {
+  if (!e.count || refUs <= 0.0) return 0.0f;
+  double mean = refUs + (double)e.mean_dev_us;
+  return (float)((refUs / mean - 1.0) * 86400.0);
+}
+
+float stddevUs(const RollupEntry &e) {
+  return e.count ? sqrtf(e.m2 / (float)e.count) : 0.0f;
+}
+
+bool trend(Tier t, uint16_t span, RollupTrend &out) {
+  out = {};
+  if (t >= TierCount) return false;
+  const TierStore &ts = tiers[t];
+  uint16_t n = (span && span < ts.filled) ? span : ts.filled;
+  // x = entry age in days (newest = 0), skipping empty entries.
+  double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, syy = 0.0;
+  uint16_t used = 0;
+  for (uint16_t i = 0; i < n; ++i) {
+    const RollupEntry &e = ts.newest(i);
+    if (!e.count) continue;
+    double x = -(double)i / (double)ENTRIES_PER_DAY[t];
+    double y = (double)rateSecPerDay(e);
+    sx += x; sy += y; sxx += x * x; sxy += x * y; syy += y * y;
+    used++;
+  }
+  out.entries = used;
+  if (used < 2) {
+    out.rate_s_per_day = used ? (float)sy : 0.0f;
+    return false;
+  }
+  double un = (double)used;
+  double sxxc = sxx - sx * sx / un;
+  double sxyc = sxy - sx * sy / un;
+  double syyc = syy - sy * sy / un;
+  if (sxxc <= 0.0) return false;
+  double slope = sxyc / sxxc;
+  double intercept = (sy - slope * sx) / un;
+  out.rate_s_per_day = (float)intercept;
+  out.drift_s_per_day2 = (float)slope;
+  if (used > 2) {
+    double sse = syyc - slope * sxyc;
+    if (sse < 0.0) sse = 0.0;
+    out.drift_stderr = (float)sqrt(sse / (un - 2.0) / sxxc);
+  }
+  return true;
+}
+
+double referencePeriodUs() { return refUs; }
+double elapsedSeconds() { return elapsedS; }
+
+const char *name(Tier t) {
+  switch (t) {
+    case Minute: return "minute";
+    case Hour:   return "hour";
+    case Day:    return "day";
+    default:     return "";
+  }
+}
+
+} // namespace Rollups
+
+#endif // ENABLE_ROLLUPS
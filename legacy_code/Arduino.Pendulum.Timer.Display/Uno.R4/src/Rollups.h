@@ -0,0 +1,55 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// Rollups.h
+// Minute/hour/day summaries of the swing period for multi-week runs.
+//
+// Time is the sum of the (GPS-corrected) swing periods, so tiers stay aligned
+// with the pendulum rather than millis(). Each closed minute is merged into the
+// open hour and each closed hour into the open day, using the parallel
+// mean/M2 combination, so higher tiers are exact rather than means of means.
+// Each tier keeps a fixed ring of its most recent entries (sizes in Config.h).
+//
+// Deviations are period minus the reference period (AnalysisTunables::
+// nominalPeriodUs, or the first measured period when that is 0). The rate is
+// in seconds/day; positive means the clock gains.
+// -----------------------------------------------------------------------------
+
+#include "Config.h"
+#include "PendulumProtocol.h"
+
+struct RollupEntry {
+  uint32_t start_s;      // elapsed pendulum seconds at the start of the entry
+  uint32_t count;        // swings
+  float    mean_dev_us;
+  float    min_dev_us;
+  float    max_dev_us;
+  float    m2;           // sum of squared deviations from the mean, us^2
+};
+
+struct RollupTrend {
+  float    rate_s_per_day;       // fitted rate at the newest entry
+  float    drift_s_per_day2;     // slope: change in rate per day
+  float    drift_stderr;
+  uint16_t entries;              // entries used
+};
+
+namespace Rollups {
+  enum Tier : uint8_t { Minute = 0, Hour, Day, TierCount };
+
+  void reset();
+  void update(const PendulumSample &sample);
+
+  uint16_t capacity(Tier t);
+  uint16_t entries(Tier t);                  // closed entries held
+  // i = 0 is the newest closed entry.
+  bool entry(Tier t, uint16_t i, RollupEntry &out);
+  float rateSecPerDay(const RollupEntry &e);
+  float stddevUs(const RollupEntry &e);
+  // Least-squares line through the rates of the newest `span` entries (0 = all).
+  bool trend(Tier t, uint16_t span, RollupTrend &out);
+
+  double referencePeriodUs();
+  double elapsedSeconds();
+  const char *name(Tier t);
+}
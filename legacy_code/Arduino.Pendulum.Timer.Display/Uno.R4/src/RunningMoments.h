@@ -0,0 +1,117 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// RunningMoments.h
+// Exact windowed mean and stddev of an integer series.
+//
+// The window keeps the exact sum (64-bit) and sum of squares (80-bit, as two
+// words) of its samples; add() and remove() are exact inverses, so no rounding
+// error can build up however long the window slides. The variance is formed
+// at read time as (n * sumSq - sum^2) / n^2, with the subtraction done in
+// integers, so nothing cancels either: the old double sumSq/n - mean^2 lost
+// most of its digits with period_us around 1e6, and a Welford/West update
+// with removal kept the rounding left behind by a step after it had left the
+// window. O(1) per sample, with no floating point until the read.
+// Samples must satisfy |x| < 2^32 and a window holds at most 65535 of them.
+// tools/moments_test.cpp checks it against exact recomputation over 10^8
+// samples. Kept free of Arduino dependencies.
+// -----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdint.h>
+
+struct RunningMoments {
+  int64_t  sum = 0;
+  uint64_t sqLo = 0;    // sum of squares, low and high words; below
+  uint16_t sqHi = 0;    // 65535 * 2^64, so the high word fits 16 bits
+  uint16_t n = 0;
+
+  void reset() {
+    n = 0;
+    sum = 0;
+    sqLo = 0;
+    sqHi = 0;
+  }
+
+  void add(int64_t x) {
+    n++;
+    sum += x;
+    uint64_t sq = square(x);
+    sqLo += sq;
+    if (sqLo < sq) sqHi++;
+  }
+
+  void remove(int64_t x) {
+    if (n <= 1) {
+      reset();
+      return;
+    }
+    n--;
+    sum -= x;
+    uint64_t sq = square(x);
+    if (sqLo < sq) sqHi--;
+    sqLo -= sq;
+  }
+
+  // Merges or takes out a whole group of samples summed on its own; the
+  // counts must stay within the same limit.
+  void add(const RunningMoments &o) {
+    n += o.n;
+    sum += o.sum;
+    sqLo += o.sqLo;
+    sqHi += o.sqHi + (sqLo < o.sqLo ? 1 : 0);
+  }
+
+  void remove(const RunningMoments &o) {
+    if (o.n >= n) {
+      reset();
+      return;
+    }
+    n -= o.n;
+    sum -= o.sum;
+    sqHi -= o.sqHi + (sqLo < o.sqLo ? 1 : 0);
+    sqLo -= o.sqLo;
+  }
+
+  double mean() const {
+    return n ? (double)sum / (double)n : 0.0;
+  }
+
+  // Population variance.
+  double variance() const {
+    if (n < 2) return 0.0;
+    // n * sumSq: at most 2^96.
+    uint64_t a0 = (sqLo & 0xFFFFFFFFu) * n;
+    uint64_t a1 = (sqLo >> 32) * n;
+    uint64_t lo = a0 + (a1 << 32);
+    uint64_t hi = (uint64_t)sqHi * n + (a1 >> 32) + (lo < a0 ? 1 : 0);
+    // sum^2: |sum| < 2^48.
+    uint64_t s = sum < 0 ? 0 - (uint64_t)sum : (uint64_t)sum;
+    uint64_t sLo, sHi;
+    mulWide(s, s, sHi, sLo);
+    // The difference is n^2 times the variance, never negative.
+    uint64_t dLo = lo - sLo;
+    uint64_t dHi = hi - sHi - (lo < sLo ? 1 : 0);
+    double num = (double)dHi * 18446744073709551616.0 + (double)dLo;
+    return num / ((double)n * (double)n);
+  }
+
+  float stddev() const {
+    return (float)sqrt(variance());
+  }
+
+private:
+  static uint64_t square(int64_t x) {
+    uint64_t a = x < 0 ? 0 - (uint64_t)x : (uint64_t)x;
+    return a * a;
+  }
+
+  static void mulWide(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo) {
+    uint64_t a0 = a & 0xFFFFFFFFu, a1 = a >> 32;
+    uint64_t b0 = b & 0xFFFFFFFFu, b1 = b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFFu) + (p10 & 0xFFFFFFFFu);
+    lo = (mid << 32) | (p00 & 0xFFFFFFFFu);
+    hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+  }
+};
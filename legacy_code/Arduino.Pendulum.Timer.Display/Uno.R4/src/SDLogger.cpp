@@ -1,5 +1,7 @@
 #include "SDLogger.h"
+#include "BinLog.h"
 #include "Display.h"
+#include "LogIndex.h"
 #include "NanoComm.h"
 #include "WiFiConfig.h"
 #include <WiFiS3.h>
@@ -9,15 +11,143 @@
 
 namespace SDLogger {
 
-static File logFile;
 static bool sdReady = false;
 static bool loggingEnabled = false;
 static bool appendMode = LOG_APPEND_DEFAULT;
 static LogMode logMode = LogMode::Continuous;
+static LogFormat logFormat = (LogFormat)LOG_FORMAT_DEFAULT;
 static char baseFile[LOG_FILENAME_LEN] = LOG_FILENAME;
-static char currentFile[LOG_FILENAME_LEN] = LOG_FILENAME;
-static uint16_t writesSinceFlush = 0;
-static unsigned long lastFlushMs = 0;
+static char currentFile[LOG_PATH_LEN] = LOG_FILENAME;
+static uint32_t rotateBytes = (uint32_t)LOG_ROTATE_MB_DEFAULT << 20;
+static uint16_t runNumber = 0;
+static uint16_t partNumber = 0;
+static const char *statsHeader = nullptr;   // no stats file until the stats log registers one
+
+static const uint8_t NO_SLOT = 0xFF;
+
+// Open log files. The raw and stats streams each write one; size and daily
+// rotation pre-open the next pair, and a file rotated out stays open until its
+// queued buffers are written, so SD_LOG_TARGETS = 4 covers every case.
+struct LogTarget {
+  File     file;
+  char     path[LOG_PATH_LEN];
+  uint32_t dataEnd;       // bytes appended, buffered ones included
+  uint32_t cardPos;       // where file's position is on the card, UINT32_MAX if unknown
+  uint8_t  pending;       // queued buffers not yet written
+  uint8_t  padByte;
+  bool     used;
+  bool     retiring;      // rotated out: closed once `pending` drains
+  bool     syncPending;
+  // Reserve-ahead. SD.h cannot preallocate or truncate, so the file is kept
+  // extended past its data with pad sectors, written in idle slices; data
+  // then overwrites clusters that are already allocated, and the FAT search
+  // that a growing file triggers happens while nothing is waiting for the
+  // card. The pad stays behind the data when a file closes: '\n' in CSV
+  // (blank lines), BINLOG_PAD_BYTE in binary. dataLength() finds the end again.
+  uint32_t reservedEnd;   // allocated file size, pad included
+  bool     reserving;
+};
+
+static LogTarget targets[SD_LOG_TARGETS];
+
+enum : uint8_t { RAW_STREAM = 0, STATS_STREAM = 1, STREAM_COUNT = 2 };
+
+struct LogStream {
+  uint8_t  target;            // file being written, NO_SLOT when closed
+  uint8_t  next;              // next part or day, pre-opened
+  uint8_t  fill;              // buffer rows are appended to, NO_SLOT if none
+  unsigned long fillStartMs;  // arrival of the oldest unqueued byte
+};
+
+static LogStream streams[STREAM_COUNT];
+
+// Write-behind sector buffers, shared by both streams. Rows are appended to
+// the stream's filling buffer, which is queued once it reaches the next
+// sector boundary of its file; service() hands queued buffers to the card in
+// order, so each write() covers whole sectors at sector-aligned offsets and
+// the library can skip its own cache. A buffer queued early (age limit,
+// rotation) only reaches the boundary's remainder, and the next one is sized
+// to realign.
+struct SectorBuffer {
+  uint8_t  data[SD_SECTOR_BYTES];
+  uint32_t pos;     // file offset of data[0]
+  uint16_t len;
+  uint16_t limit;   // bytes up to the next sector boundary
+  uint8_t  target;
+  bool     rowEnd;  // a raw row ends here: swingId is on the card once this is
+  uint32_t swingId;
+};
+
+static SectorBuffer buffers[SD_WRITE_BUFFERS];
+static uint8_t freeList[SD_WRITE_BUFFERS];
+static uint8_t freeCount = 0;
+static uint8_t writeQueue[SD_WRITE_BUFFERS];
+static uint8_t queueHead = 0;         // oldest queued buffer
+static uint8_t queued = 0;            // buffers waiting for the card
+static uint8_t lastFilled = NO_SLOT;  // buffer the last appendBytes() ended in
+static uint8_t prevFilled = NO_SLOT;  // ... and the one its next-to-last byte went to
+
+// Spill queue, between logSample() and the sector buffers: swings the writer
+// cannot take (no buffer room, card gone) wait here in order, and while any
+// wait, newer ones queue behind them. When it is full the oldest is dropped
+// and added to the pending gap, which is logged before the next record:
+// "# gap ..." in CSV, a sync marker naming the first missing swing in binary.
+static BinSwingRecordV1 spill[SD_SPILL_RECORDS];
+static uint8_t  spillHead = 0;
+static uint8_t  spillCount = 0;
+static uint32_t gapFirst = 0, gapLast = 0;
+static bool     gapPending = false;
+
+// Card loss: the raw rows still buffered when the card goes are added to the
+// gap, from the first swing whose row had not reached the card.
+static bool     cardLost = false;
+static bool     restartOnMount = false;   // logging was started with no card
+static uint8_t  failStreak = 0;           // failed writes in a row
+static unsigned long lastMountMs = 0;
+static uint32_t writtenSwing = 0;         // last raw row on the card
+static uint32_t bufferedSwing = 0;        // last raw row buffered
+
+static void addGap(uint32_t first, uint32_t last);
+static void drainSpill(uint8_t maxRows);
+
+// Binary format state: the open block's running CRC and record count. The
+// format is latched when a file opens; setLogFormat() applies to the next one.
+static bool     binaryFile = false;
+static uint16_t blockCrc = 0;
+static uint16_t blockRecords = 0;
+static uint16_t syncSeq = 0;
+static uint32_t nextSwingId = 0;
+static uint16_t indexRows = 0;        // CSV rows since the last index entry
+static uint8_t  openReason = RESET_UNKNOWN;   // for the next resume: the reset, then RESET_RESTART
+
+static WriterStats wstats;
+static uint32_t loopSdUs = 0;
+
+// Accumulates time spent in SD code into the current loop() iteration; only
+// the outermost timer counts, so nested entry points are not added twice.
+static uint8_t timerDepth = 0;
+struct SdTimer {
+  uint32_t t0;
+  SdTimer() : t0(micros()) { timerDepth++; }
+  ~SdTimer() { if (--timerDepth == 0) loopSdUs += micros() - t0; }
+};
+
+static SdHealth sdHealth;
+
+// Times one card operation into its health histogram.
+struct OpTimer {
+  SdOp     op;
+  uint32_t t0;
+  uint32_t bytes = 0;
+  explicit OpTimer(SdOp o) : op(o), t0(micros()) {}
+  ~OpTimer() { recordSdOp(op, micros() - t0, bytes); }
+};
+
+// Errors on the logging path also count in WriterStats::write_errors.
+static void countError(SdError e) {
+  recordSdError(e);
+  wstats.write_errors++;
+}
 
 static time_t ntpEpoch = 0;
 static unsigned long ntpSyncMs = 0;
@@ -30,6 +160,24 @@ static unsigned long fallbackDayStartMs = 0;
 
 static bool timeIsValid(time_t t) { return t > 1600000000; }
 
+// The cause of the last reset, from the RA4M1 reset status registers; read
+// once at begin() and cleared (each flag clears by writing 0 after reading 1).
+static uint8_t readResetReason() {
+#if defined(ARDUINO_ARCH_RENESAS)
+  uint8_t rst0 = R_SYSTEM->RSTSR0;
+  uint16_t rst1 = R_SYSTEM->RSTSR1;
+  R_SYSTEM->RSTSR0 = 0;
+  R_SYSTEM->RSTSR1 = 0;
+  if (rst0 & 0x01) return RESET_POWER_ON;   // PORF
+  if (rst0 & 0x0E) return RESET_BROWNOUT;   // LVD0RF..LVD2RF
+  if (rst1 & 0x03) return RESET_WATCHDOG;   // IWDTRF, WDTRF
+  if (rst1 & 0x04) return RESET_SOFTWARE;   // SWRF
+  return RESET_PIN;
+#else
+  return RESET_UNKNOWN;
+#endif
+}
+
 static bool validFilename(const char* fn) {
   if (!fn || !*fn) return false;
   size_t len = strlen(fn);
@@ -42,8 +190,411 @@ static bool validFilename(const char* fn) {
 }
 
 bool isValidFilename(const char* fn) { return validFilename(fn); }
-bool ready() { return sdReady && logFile; }
-bool isLogging() { return loggingEnabled && logFile; }
+
+bool isValidLogPath(const char* path) {
+  if (!path) return false;
+  static const char* const dirs[] = { LOG_RAW_DIR "/", LOG_STATS_DIR "/" };
+  for (const char* dir : dirs) {
+    size_t n = strlen(dir);
+    if (strncasecmp(path, dir, n) == 0) return validFilename(path + n);
+  }
+  return validFilename(path);
+}
+
+bool ready() { return sdReady && streams[RAW_STREAM].target != NO_SLOT; }
+bool isLogging() { return loggingEnabled && ready(); }
+bool isLogEnabled() { return loggingEnabled; }
+bool isCardLost() { return loggingEnabled && cardLost; }
+
+static void resetWriter() {
+  freeCount = 0;
+  for (uint8_t i = 0; i < SD_WRITE_BUFFERS; ++i) freeList[freeCount++] = (uint8_t)(SD_WRITE_BUFFERS - 1 - i);
+  queueHead = 0;
+  queued = 0;
+  for (LogStream &st : streams) {
+    st.target = NO_SLOT;
+    st.next = NO_SLOT;
+    st.fill = NO_SLOT;
+  }
+}
+
+static void releaseBuffer(uint8_t idx) { freeList[freeCount++] = idx; }
+
+static bool openFillBuffer(LogStream &st) {
+  if (!freeCount) return false;
+  uint8_t idx = freeList[--freeCount];
+  SectorBuffer &b = buffers[idx];
+  b.target = st.target;
+  b.pos = targets[st.target].dataEnd;
+  b.len = 0;
+  b.limit = (uint16_t)(SD_SECTOR_BYTES - b.pos % SD_SECTOR_BYTES);
+  b.rowEnd = false;
+  st.fill = idx;
+  return true;
+}
+
+static void queueFillBuffer(LogStream &st) {
+  SectorBuffer &b = buffers[st.fill];
+  if (b.len < b.limit) wstats.partial_writes++;
+  writeQueue[(queueHead + queued) % SD_WRITE_BUFFERS] = st.fill;
+  queued++;
+  if (queued > sdHealth.max_queued) sdHealth.max_queued = queued;
+  targets[b.target].pending++;
+  st.fill = NO_SLOT;
+}
+
+// Queues what the stream has buffered, or returns an empty buffer to the pool.
+static void flushFillBuffer(LogStream &st) {
+  if (st.fill == NO_SLOT) return;
+  if (buffers[st.fill].len) {
+    queueFillBuffer(st);
+  } else {
+    releaseBuffer(st.fill);
+    st.fill = NO_SLOT;
+  }
+}
+
+// Bytes the stream can buffer before it has to wait for the card.
+static size_t streamRoom(uint8_t stream) {
+  const LogStream &st = streams[stream];
+  if (st.target == NO_SLOT) return 0;
+  size_t room = (size_t)freeCount * SD_SECTOR_BYTES;
+  if (st.fill != NO_SLOT) room += buffers[st.fill].limit - buffers[st.fill].len;
+  else if (room) room -= targets[st.target].dataEnd % SD_SECTOR_BYTES;
+  return room;
+}
+
+// Appends a whole row or nothing: a row that does not fit the free buffer
+// space is dropped (and counted) rather than split around a gap.
+static bool appendBytes(uint8_t stream, const uint8_t *data, size_t n) {
+  LogStream &st = streams[stream];
+  if (st.target == NO_SLOT) return false;
+  LogTarget &t = targets[st.target];
+  if (n > streamRoom(stream)) {
+    wstats.dropped_rows++;
+    return false;
+  }
+  while (n) {
+    if (st.fill == NO_SLOT) openFillBuffer(st);
+    lastFilled = st.fill;
+    SectorBuffer &b = buffers[st.fill];
+    if (b.len == 0) st.fillStartMs = millis();
+    size_t take = b.limit - b.len;
+    if (take > n) take = n;
+    if (n >= 2 && take + 1 >= n) prevFilled = st.fill;
+    memcpy(b.data + b.len, data, take);
+    b.len += (uint16_t)take;
+    t.dataEnd += take;
+    data += take;
+    n -= take;
+    if (b.len == b.limit) queueFillBuffer(st);
+  }
+  return true;
+}
+
+// Writes `n` bytes at file offset `pos`, seeking only when the card position
+// is elsewhere (after pad sectors or a recovery scan). Timed as `op`; a
+// failure is counted as a seek error or an `op` error.
+static size_t writeAt(LogTarget &t, uint32_t pos, const uint8_t *data, size_t n, SdOp op) {
+  OpTimer timer(op);
+  if (t.cardPos != pos && !t.file.seek(pos)) {
+    t.cardPos = UINT32_MAX;
+    countError(SdError::Seek);
+    if (failStreak < UINT8_MAX) failStreak++;
+    return 0;
+  }
+  size_t w = t.file.write(data, n);
+  timer.bytes = (uint32_t)w;
+  t.cardPos = pos + w;
+  if (t.cardPos > t.reservedEnd) t.reservedEnd = t.cardPos;
+  if (w != n) {
+    countError(op == SdOp::Reserve ? SdError::Reserve : SdError::Write);
+    if (failStreak < UINT8_MAX) failStreak++;
+  } else {
+    failStreak = 0;
+  }
+  return w;
+}
+
+// Takes the oldest buffer off the queue and returns it to the pool.
+static void popQueued() {
+  uint8_t idx = writeQueue[queueHead];
+  targets[buffers[idx].target].pending--;
+  queueHead = (uint8_t)((queueHead + 1) % SD_WRITE_BUFFERS);
+  queued--;
+  releaseBuffer(idx);
+}
+
+// The raw rows buffered but not yet on the card are lost with the buffers:
+// they join the gap.
+static void gapBuffered() {
+  if (bufferedSwing != writtenSwing) addGap(writtenSwing + 1, bufferedSwing);
+  writtenSwing = bufferedSwing;
+}
+
+// Writes the oldest queued buffer. Returns false if nothing was queued or the
+// write failed; a failed buffer stays at the head of the queue, so nothing
+// after it reaches the card first and writtenSwing stays the last row that
+// did. The card is then treated as lost (SD_FAIL_LIMIT).
+static bool writeQueued() {
+  if (!queued) return false;
+  SectorBuffer &b = buffers[writeQueue[queueHead]];
+  uint32_t t0 = micros();
+  size_t w = writeAt(targets[b.target], b.pos, b.data, b.len, SdOp::Write);
+  uint32_t dt = micros() - t0;
+  if (dt > wstats.max_write_us) wstats.max_write_us = dt;
+  if (w != b.len) return false;
+  if (b.rowEnd) writtenSwing = b.swingId;
+  if (b.len == SD_SECTOR_BYTES) wstats.sectors++;
+  popQueued();
+  return true;
+}
+
+// Blocking: writes everything buffered and syncs. Used when files are closed.
+// If the card fails meanwhile, what is left is dropped and gapped.
+static void drainWriter() {
+  for (LogStream &st : streams) flushFillBuffer(st);
+  while (writeQueued()) {}
+  if (queued) {
+    gapBuffered();
+    while (queued) popQueued();
+  }
+  for (LogTarget &t : targets) {
+    if (!t.used) continue;
+    {
+      OpTimer timer(SdOp::Sync);
+      t.file.flush();
+    }
+    t.syncPending = false;
+    wstats.syncs++;
+  }
+}
+
+static uint32_t reserveAhead(const LogTarget &t) {
+  return t.reservedEnd > t.dataEnd ? t.reservedEnd - t.dataEnd : 0;
+}
+
+// Extends the file by one pad sector. Only called with a buffer free, which
+// holds the pad.
+static bool reserveSector(LogTarget &t) {
+  SectorBuffer &pad = buffers[freeList[freeCount - 1]];
+  uint16_t n = (uint16_t)(SD_SECTOR_BYTES - t.reservedEnd % SD_SECTOR_BYTES);
+  memset(pad.data, t.padByte, n);
+  uint32_t t0 = micros();
+  size_t w = writeAt(t, t.reservedEnd, pad.data, n, SdOp::Reserve);
+  uint32_t dt = micros() - t0;
+  if (dt > wstats.max_reserve_us) wstats.max_reserve_us = dt;
+  if (w != n) return false;
+  wstats.reserve_sectors++;
+  return true;
+}
+
+// Torn-tail recovery. Writes reach the card in order, so a power cut can only
+// damage the end of the data: a row cut short (which the pad behind it then
+// ends with a newline), or a binary record or marker cut short. The data is
+// cut back to its last complete line or record and the torn bytes are padded
+// over, so the file stays parseable whatever happens next.
+
+// The end of the last valid header or sync marker starting in [from, end),
+// or UINT32_MAX if there is none.
+static uint32_t lastMarkerEnd(File &f, uint32_t from, uint32_t end) {
+  uint8_t chunk[64 + 3];
+  uint32_t hi = end;   // marker starts below hi still to check
+  while (hi > from) {
+    uint32_t lo = hi - from > 64 ? hi - 64 : from;
+    uint32_t n = (hi + 3 <= end ? hi + 3 : end) - lo;
+    if (!f.seek(lo) || f.read(chunk, n) != (int)n) return UINT32_MAX;
+    for (uint32_t i = hi - lo; i-- > 0;) {
+      if (i + 4 > n) continue;
+      uint32_t magic;
+      memcpy(&magic, chunk + i, sizeof(magic));
+      uint32_t at = lo + i;
+      if (magic == BINLOG_FILE_MAGIC && at + sizeof(BinLogFileHeader) <= end) {
+        BinLogFileHeader h;
+        if (f.seek(at) && f.read(&h, sizeof(h)) == (int)sizeof(h) && binLogHeaderValid(h)) {
+          return at + h.header_bytes;
+        }
+      } else if (magic == BINLOG_SYNC_MAGIC && at + sizeof(BinLogSync) <= end) {
+        BinLogSync sync;
+        if (f.seek(at) && f.read(&sync, sizeof(sync)) == (int)sizeof(sync) && binLogSyncValid(sync)) {
+          return at + sizeof(BinLogSync);
+        }
+      }
+    }
+    hi = lo;
+  }
+  return UINT32_MAX;
+}
+
+// Whole records after the last marker; a magic number where a record should
+// start is a marker cut short.
+static uint32_t completeBinaryLength(File &f, uint32_t end) {
+  const uint32_t window = BINLOG_SYNC_INTERVAL * sizeof(BinSwingRecordV1) +
+                          sizeof(BinLogFileHeader) + sizeof(BinLogSync);
+  uint32_t pos = lastMarkerEnd(f, end > window ? end - window : 0, end);
+  if (pos == UINT32_MAX) return end;   // nothing to measure from; the resume header resyncs readers
+  while (pos + sizeof(BinSwingRecordV1) <= end) {
+    uint32_t magic;
+    if (!f.seek(pos) || f.read(&magic, sizeof(magic)) != (int)sizeof(magic)) break;
+    if (magic == BINLOG_FILE_MAGIC || magic == BINLOG_SYNC_MAGIC) break;
+    pos += sizeof(BinSwingRecordV1);
+  }
+  return pos;
+}
+
+static bool fullLastField(const char *p, const char *e) {
+  size_t n = (size_t)(e - p);
+  if (n >= 3 && (strncmp(e - 3, "nan", 3) == 0 || strncmp(e - 3, "inf", 3) == 0)) return true;
+  // %.2f: digits '.' two digits
+  return n >= 4 && e[-3] == '.' && isdigit((unsigned char)e[-1]) &&
+         isdigit((unsigned char)e[-2]) && isdigit((unsigned char)e[-4]);
+}
+
+// A line ending in "\r\n" (header, marker) is whole. A row ("\n") is whole if
+// it has as many commas as the file's column line and its last field, printed
+// with %.2f, is complete; an empty last field (a missing stats reading) cannot
+// be told from a cut one and is dropped.
+static uint32_t completeCsvLength(File &f, uint32_t end) {
+  char buf[256];
+  if (!f.seek(0)) return end;
+  int n = f.read(buf, sizeof(buf));
+  int commas = -1;
+  for (int i = 0, lineCommas = 0; i < n; ++i) {
+    if (buf[i] == ',') lineCommas++;
+    if (buf[i] == '\n') {
+      if (lineCommas) { commas = lineCommas; break; }
+      lineCommas = 0;
+    }
+  }
+  if (commas < 0) return end;   // no column line yet
+
+  uint32_t from = end > sizeof(buf) ? end - sizeof(buf) : 0;
+  n = (int)(end - from);
+  if (!f.seek(from) || f.read(buf, n) != n) return end;
+  bool ended = buf[n - 1] == '\n';
+  if (ended && n >= 2 && buf[n - 2] == '\r') return end;
+  int last = ended ? n - 1 : n;
+  int start = last;
+  while (start > 0 && buf[start - 1] != '\n') start--;
+  if (start == 0 && from > 0) return end;   // longer than any row; leave it
+  int lineCommas = 0;
+  const char *lastField = buf + start;
+  for (int i = start; i < last; ++i) {
+    if (buf[i] == ',') {
+      lineCommas++;
+      lastField = buf + i + 1;
+    }
+  }
+  if (ended && lineCommas == commas && fullLastField(lastField, buf + last)) return end;
+  return from + (uint32_t)start;
+}
+
+// Overwrites [from, to) with pad.
+static void padOver(LogTarget &t, uint32_t from, uint32_t to) {
+  uint8_t pad[64];
+  memset(pad, t.padByte, sizeof(pad));
+  while (from < to) {
+    uint32_t n = to - from < sizeof(pad) ? to - from : sizeof(pad);
+    if (writeAt(t, from, pad, n, SdOp::Reserve) != n) return;
+    from += n;
+  }
+}
+
+// Opens (creating if needed) a log file. The recovery scan: a file that was
+// not closed cleanly, or closed with its pad, is appended to right after its
+// last complete row or record.
+static uint8_t openTarget(const char* path, bool appendFlag, bool binary) {
+  uint8_t slot = NO_SLOT;
+  for (uint8_t i = 0; i < SD_LOG_TARGETS; ++i) {
+    if (!targets[i].used) { slot = i; break; }
+  }
+  if (slot == NO_SLOT) return NO_SLOT;
+  if (!appendFlag) {
+    OpTimer timer(SdOp::Dir);
+    SD.remove(path);
+  }
+  File f;
+  {
+    OpTimer timer(SdOp::Open);
+    // Not FILE_WRITE: its O_APPEND would send every write past the pad.
+    f = SD.open(path, O_READ | O_WRITE | O_CREAT);
+  }
+  if (!f) {
+    countError(SdError::Open);
+    return NO_SLOT;
+  }
+  LogTarget &t = targets[slot];
+  t.file = f;
+  strncpy(t.path, path, LOG_PATH_LEN - 1);
+  t.path[LOG_PATH_LEN - 1] = 0;
+  t.reservedEnd = (uint32_t)t.file.size();
+  t.cardPos = UINT32_MAX;   // unknown until the first seek
+  t.pending = 0;
+  t.padByte = binary ? BINLOG_PAD_BYTE : '\n';
+  uint32_t complete = 0;
+  {
+    OpTimer timer(SdOp::Scan);
+    t.dataEnd = dataLength(t.file, binary);
+    if (t.dataEnd) {
+      complete = binary ? completeBinaryLength(t.file, t.dataEnd)
+                        : completeCsvLength(t.file, t.dataEnd);
+    }
+  }
+  if (t.dataEnd) {
+    if (complete < t.dataEnd) {
+      padOver(t, complete, t.dataEnd);
+      wstats.torn_bytes += t.dataEnd - complete;
+      t.dataEnd = complete;
+    }
+    t.cardPos = UINT32_MAX;
+  }
+  t.used = true;
+  t.retiring = false;
+  t.syncPending = false;
+  t.reserving = false;
+  // The first cluster is allocated here, where a stall is expected, rather
+  // than by the first row write.
+  if (freeCount && reserveAhead(t) == 0) reserveSector(t);
+  return slot;
+}
+
+// Closes a file; a pre-opened part that never received data is removed.
+static void closeTarget(uint8_t slot, bool removeIfEmpty) {
+  LogTarget &t = targets[slot];
+  if (!t.used) return;
+  {
+    OpTimer timer(SdOp::Close);
+    t.file.close();
+  }
+  t.file = File();
+  t.used = false;
+  if (removeIfEmpty && t.dataEnd == 0) {
+    OpTimer timer(SdOp::Dir);
+    SD.remove(t.path);
+  }
+}
+
+// Blocking: drains the writer and closes every file.
+static void closeAllTargets() {
+  drainWriter();
+  if (sdReady) LogIndex::flush();
+  for (LogStream &st : streams) {
+    if (st.next != NO_SLOT) closeTarget(st.next, true);
+  }
+  for (uint8_t i = 0; i < SD_LOG_TARGETS; ++i) closeTarget(i, false);
+  resetWriter();
+}
+
+static bool mountCard() {
+  bool mounted;
+  {
+    OpTimer timer(SdOp::Mount);
+    mounted = SD.begin(SD_CS_PIN);
+  }
+  if (!mounted) recordSdError(SdError::Mount);
+  lastMountMs = millis();
+  return mounted;
+}
 
 static void resetFallbackClock() {
   fallbackDayStartMs = millis();
@@ -110,44 +661,193 @@ static void buildDailyFilename(char* out, size_t len, time_t epochNow, int32_t d
   snprintf(out, len, "day%04ld.csv", (long)(dayIndex % 10000L));
 }
 
+// Binary logs get a .bin extension so a CSV of the same base name is never
+// appended to with records (and vice versa). `binary` is the format of the
+// file being named: setLogFormat() only applies from the next open, so a
+// rotation passes the latched one.
+static void applyFormatExtension(char* name, size_t len, bool binary) {
+  const char* ext = binary ? "bin" : "csv";
+  char* dot = strrchr(name, '.');
+  if (dot) {
+    if (strcmp(dot + 1, "csv") != 0 && strcmp(dot + 1, "bin") != 0) return;
+    *dot = 0;
+  }
+  size_t used = strlen(name);
+  if (used + 4 < len) snprintf(name + used, len - used, ".%s", ext);
+  else if (dot) *dot = '.';
+}
+
+
+// Size-rotation parts: LOG_RAW_DIR/rNNNpMMM.csv (8.3 names; SD.h has no long
+// file names), paired with LOG_STATS_DIR/rNNNpMMM.csv.
+static void buildPartFilename(char* out, size_t len, uint16_t run, uint16_t part) {
+  snprintf(out, len, "%s/r%03up%03u.csv", LOG_RAW_DIR, (unsigned)(run % 1000), (unsigned)(part % 1000));
+}
+
+static bool parsePartName(const char* name, uint16_t &run, uint16_t &part) {
+  if (!name || strlen(name) < 8) return false;
+  if ((name[0] != 'r' && name[0] != 'R') || (name[4] != 'p' && name[4] != 'P')) return false;
+  for (uint8_t i : {1, 2, 3, 5, 6, 7}) {
+    if (!isdigit(name[i])) return false;
+  }
+  run = (uint16_t)((name[1] - '0') * 100 + (name[2] - '0') * 10 + (name[3] - '0'));
+  part = (uint16_t)((name[5] - '0') * 100 + (name[6] - '0') * 10 + (name[7] - '0'));
+  return true;
+}
+
+// Latest run and its latest part in LOG_RAW_DIR. Walks the directory, so it
+// is only used when logging starts.
+static bool findLatestPart(uint16_t &run, uint16_t &part) {
+  OpTimer timer(SdOp::Dir);
+  File dir = SD.open(LOG_RAW_DIR);
+  if (!dir) return false;
+  bool found = false;
+  File entry = dir.openNextFile();
+  while (entry) {
+    uint16_t r, p;
+    if (!entry.isDirectory() && parsePartName(entry.name(), r, p) &&
+        (!found || r > run || (r == run && p > part))) {
+      run = r;
+      part = p;
+      found = true;
+    }
+    File next = dir.openNextFile();
+    entry.close();
+    entry = next;
+  }
+  dir.close();
+  return found;
+}
+
+// The stats file pairs with the raw one: same base name under LOG_STATS_DIR.
+static void buildStatsPath(char* out, size_t len, const char* rawPath) {
+  const char* base = strrchr(rawPath, '/');
+  base = base ? base + 1 : rawPath;
+  snprintf(out, len, "%s/%s", LOG_STATS_DIR, base);
+  char* dot = strrchr(out, '.');
+  if (dot && strcmp(dot, ".bin") == 0) strcpy(dot, ".csv");
+}
+
+static void appendSync() {
+  BinLogSync sync;
+  syncSeq = syncSeq >= BINLOG_SEQ_MAX ? 1 : (uint16_t)(syncSeq + 1);
+  binLogInitSync(sync, nextSwingId, blockRecords, blockCrc, syncSeq);
+  appendBytes(RAW_STREAM, (const uint8_t*)&sync, sizeof(sync));
+  blockCrc = 0;
+  blockRecords = 0;
+}
+
+static void closeBlock() {
+  if (binaryFile && blockRecords) appendSync();
+}
+
+// Swing id of the next record to be logged: the oldest spilled one, if any.
+static uint32_t nextLogSwing() {
+  return spillCount ? spill[spillHead].swing_id : NanoComm::currentSwingId() + 1;
+}
+
+static void writeBinaryHeader(uint8_t resumeReason = RESET_UNKNOWN) {
+  BinLogFileHeader h;
+  binLogInitHeader(h, (uint8_t)NanoComm::getDataUnits(), NANO_TICK_HZ, (uint32_t)currentEpoch(),
+                   nextLogSwing(), FIRMWARE_ID, resumeReason);
+  appendBytes(RAW_STREAM, (const uint8_t*)&h, sizeof(h));
+  blockCrc = 0;
+  blockRecords = 0;
+  syncSeq = 0;
+}
+
+static void writeCsvLine(uint8_t stream, const char *line) {
+  appendBytes(stream, (const uint8_t*)line, strlen(line));
+  appendBytes(stream, (const uint8_t*)"\r\n", 2);
+}
+
+static void openStatsFile(const char* rawPath, bool appendFlag) {
+  if (!statsHeader) return;
+  char path[LOG_PATH_LEN];
+  buildStatsPath(path, sizeof(path), rawPath);
+  {
+    OpTimer timer(SdOp::Dir);
+    SD.mkdir(LOG_STATS_DIR);
+  }
+  uint8_t slot = openTarget(path, appendFlag, false);
+  if (slot == NO_SLOT) {
+    Display::scrollLog(F("stats open fail"));
+    return;
+  }
+  streams[STATS_STREAM].target = slot;
+  if (!appendFlag || targets[slot].dataEnd == 0) writeCsvLine(STATS_STREAM, statsHeader);
+}
+
 static bool openLogFile(const char* fname, bool appendFlag) {
-  if (fname && validFilename(fname)) {
-    strncpy(currentFile, fname, LOG_FILENAME_LEN - 1);
-    currentFile[LOG_FILENAME_LEN - 1] = 0;
+  if (fname && isValidLogPath(fname)) {
+    strncpy(currentFile, fname, LOG_PATH_LEN - 1);
+    currentFile[LOG_PATH_LEN - 1] = 0;
   }
+  applyFormatExtension(currentFile, sizeof(currentFile), logFormat == LogFormat::Binary);
   if (!sdReady) {
-    loggingEnabled = false;
-    if (logFile) { logFile.close(); }
-    logFile = File();
+    // No card yet: swings spill and service() keeps trying to mount one.
+    closeAllTargets();
+    loggingEnabled = true;
+    cardLost = true;
+    restartOnMount = true;
     Display::scrollLog(F("SD not ready"));
     return false;
   }
-  if (logFile) { logFile.close(); }
-  if (!appendFlag) SD.remove(currentFile);
-  logFile = SD.open(currentFile, FILE_WRITE);
-  if (!logFile) {
+  if (ready()) closeBlock();
+  closeAllTargets();
+  binaryFile = logFormat == LogFormat::Binary;
+  blockRecords = 0;
+  indexRows = 0;
+  if (strchr(currentFile, '/')) {
+    OpTimer timer(SdOp::Dir);
+    SD.mkdir(LOG_RAW_DIR);
+  }
+  if (!appendFlag) LogIndex::remove(currentFile);
+  uint8_t slot = openTarget(currentFile, appendFlag, binaryFile);
+  if (slot == NO_SLOT) {
     Display::scrollLog(F("open fail"));
     loggingEnabled = false;
-    logFile = File();
     return false;
   }
+  streams[RAW_STREAM].target = slot;
   loggingEnabled = true;
-  if (!appendFlag || logFile.size() == 0) {
-    logFile.println(NanoComm::getCSVHeader());
-    logFile.flush();
+  writtenSwing = bufferedSwing = nextLogSwing() - 1;
+  // A binary file gets a header on every open: it doubles as the resync
+  // point after a record torn by a reset. Resuming a CSV file adds a marker
+  // line instead; both carry the reason.
+  bool resume = targets[slot].dataEnd > 0;
+  if (binaryFile) {
+    writeBinaryHeader(resume ? openReason : (uint8_t)RESET_UNKNOWN);
+  } else if (resume) {
+    char line[96];
+    rawLogResumeLine(line, sizeof(line), openReason, (uint32_t)currentEpoch(), nextLogSwing());
+    writeCsvLine(RAW_STREAM, line);
+  } else {
+    writeHeader(NanoComm::getCSVHeader());
   }
-  writesSinceFlush = 0;
-  lastFlushMs = millis();
+  openReason = RESET_RESTART;
+  openStatsFile(currentFile, appendFlag);
   return true;
 }
 
 void begin() {
-  if (logFile) { logFile.close(); }
-  if (!SD.begin(SD_CS_PIN)) {
+  // Files left open by an earlier begin() are dropped unflushed, as a reset would.
+  for (LogTarget &t : targets) {
+    if (t.used) t.file.close();
+    t.file = File();
+    t.used = false;
+  }
+  resetWriter();
+  spillCount = 0;
+  gapPending = false;
+  cardLost = false;
+  restartOnMount = false;
+  failStreak = 0;
+  openReason = readResetReason();
+  if (!mountCard()) {
     Display::scrollLog(F("SD init failed"));
     sdReady = false;
     loggingEnabled = false;
-    logFile = File();
     return;
   }
   sdReady = true;
@@ -155,11 +855,10 @@ void begin() {
   appendMode = LOG_APPEND_DEFAULT;
   strncpy(baseFile, LOG_FILENAME, LOG_FILENAME_LEN - 1);
   baseFile[LOG_FILENAME_LEN - 1] = 0;
-  strncpy(currentFile, baseFile, LOG_FILENAME_LEN - 1);
-  currentFile[LOG_FILENAME_LEN - 1] = 0;
+  strncpy(currentFile, baseFile, LOG_PATH_LEN - 1);
+  currentFile[LOG_PATH_LEN - 1] = 0;
   resetFallbackClock();
   attemptNtpSync();
-  if (logFile) { logFile.close(); }
 }
 
 void setFilename(const char *fname) {
@@ -171,11 +870,21 @@ void setFilename(const char *fname) {
 
 void setAppendMode(bool append) { appendMode = append; }
 void setLogMode(LogMode mode) { logMode = mode; }
+void setLogFormat(LogFormat format) { logFormat = format; }
+void setRotateSizeMB(uint8_t mb) { rotateBytes = (uint32_t)(mb ? mb : LOG_ROTATE_MB_DEFAULT) << 20; }
+void setStatsHeader(const char *hdr) { statsHeader = hdr; }
 
 const char* getFilename() { return baseFile; }
 const char* getActiveFilename() { return currentFile; }
 bool getAppendMode() { return appendMode; }
 LogMode getLogMode() { return logMode; }
+LogFormat getLogFormat() { return logFormat; }
+uint8_t getRotateSizeMB() { return (uint8_t)(rotateBytes >> 20); }
+
+LogMode logModeFor(bool daily, bool sizeRotate) {
+  if (sizeRotate) return LogMode::Size;
+  return daily ? LogMode::Daily : LogMode::Continuous;
+}
 
 bool startLogging(const char* fname, bool append) {
   setLogMode(LogMode::Continuous);
@@ -187,7 +896,7 @@ bool startLogging(const char* fname, bool append) {
 
 bool startLogging(LogMode mode, bool forceNewFile) {
   logMode = mode;
-  char target[LOG_FILENAME_LEN];
+  char target[LOG_PATH_LEN];
   bool appendFlag = appendMode;
 
   if (logMode == LogMode::Daily) {
@@ -199,6 +908,19 @@ bool startLogging(LogMode mode, bool forceNewFile) {
       appendFlag = false;
     }
     activeDayIndex = dayIndex;
+  } else if (logMode == LogMode::Size) {
+    // Append resumes the latest part; otherwise a new run starts at part 1.
+    uint16_t run = 0, part = 0;
+    bool found = sdReady && findLatestPart(run, part);
+    if (!found || forceNewFile || !appendFlag) {
+      run = (uint16_t)(found ? run % 999 + 1 : 1);
+      part = 1;
+      appendFlag = false;
+    }
+    runNumber = run;
+    partNumber = part;
+    buildPartFilename(target, sizeof(target), runNumber, partNumber);
+    activeDayIndex = -1;
   } else {
     strncpy(target, baseFile, sizeof(target) - 1);
     target[sizeof(target) - 1] = 0;
@@ -215,19 +937,160 @@ bool restartLogging(bool forceNewFile) {
 }
 
 void stopLogging() {
-  if (logFile) {
-    logFile.flush();
-    logFile.close();
+  if (ready()) {
+    SdTimer timer;
+    // The spill backlog goes to the file first, a buffer load at a time.
+    for (uint8_t i = 0; spillCount && i < SD_SPILL_RECORDS; ++i) {
+      drainSpill(SD_SPILL_RECORDS);
+      drainWriter();
+    }
+    closeBlock();
+    closeAllTargets();
+  }
+  // What could not be written is a gap, logged when logging starts again.
+  if (spillCount) {
+    addGap(spill[spillHead].swing_id,
+           spill[(spillHead + spillCount - 1) % SD_SPILL_RECORDS].swing_id);
+    spillCount = 0;
   }
   loggingEnabled = false;
+  cardLost = false;
+  restartOnMount = false;
 }
 
 void writeHeader(const char *hdr) {
   if (!ready()) return;
-  logFile.println(hdr);
-  logFile.flush();
+  SdTimer timer;
+  if (binaryFile) {
+    closeBlock();
+    writeBinaryHeader();
+    return;
+  }
+  writeCsvLine(RAW_STREAM, hdr);
+}
+
+void logStatsRow(const char *row, size_t len) {
+  if (!isLogging()) return;
+  SdTimer timer;
+  appendBytes(STATS_STREAM, (const uint8_t*)row, len);
+}
+
+// Raw path of the file logging moves to next, opened ahead by service(): the
+// next part in Size mode, tomorrow's file in Daily mode. False in Continuous,
+// and while a day change waits for checkRollover().
+static bool nextRawPath(char* path, size_t len) {
+  if (logMode == LogMode::Size) {
+    buildPartFilename(path, len, runNumber, (uint16_t)(partNumber + 1));
+  } else if (logMode == LogMode::Daily) {
+    time_t epochNow = currentEpoch();
+    int32_t today = computeDayIndex(epochNow);
+    if (today != activeDayIndex) return false;
+    int32_t day = today + 1;
+    buildDailyFilename(path, len, timeIsValid(epochNow) ? (time_t)day * 86400 : epochNow, day);
+  } else {
+    return false;
+  }
+  applyFormatExtension(path, len, binaryFile);
+  return true;
 }
 
+// Opens the next file for one stream that lacks it, or closes one that no
+// longer matches (the clock was set since it was opened). One SD.open (the
+// directory search) per call; the new file is then padded by the reserve.
+static bool prepareNext() {
+  char rawPath[LOG_PATH_LEN];
+  if (!nextRawPath(rawPath, sizeof(rawPath))) return false;
+  for (uint8_t s = 0; s < STREAM_COUNT; ++s) {
+    LogStream &st = streams[s];
+    if (st.target == NO_SLOT) continue;
+    char path[LOG_PATH_LEN];
+    if (s == STATS_STREAM) {
+      buildStatsPath(path, sizeof(path), rawPath);
+    } else {
+      strncpy(path, rawPath, sizeof(path));
+    }
+    if (st.next != NO_SLOT) {
+      if (strcmp(targets[st.next].path, path) == 0) continue;
+      closeTarget(st.next, true);
+      st.next = NO_SLOT;
+      return true;
+    }
+    // Append, not truncate: a file left over from a reset is only pad, and
+    // anything more is never overwritten.
+    st.next = openTarget(path, true, s == RAW_STREAM && binaryFile);   // a failure is counted there
+    return true;
+  }
+  return false;
+}
+
+// Sector buffers that `bytes` appended at file offset `dataEnd` fill.
+static uint8_t buffersFor(uint32_t dataEnd, size_t bytes) {
+  if (!bytes) return 0;
+  return (uint8_t)((dataEnd % SD_SECTOR_BYTES + bytes + SD_SECTOR_BYTES - 1) / SD_SECTOR_BYTES);
+}
+
+// Whether the free buffers hold everything a switch appends: the old raw
+// file's closing sync marker and each new file's header. appendBytes() drops
+// what does not fit, so the switch waits for the card instead.
+static bool switchFits() {
+  const LogStream &raw = streams[RAW_STREAM];
+  uint8_t need = 0;
+  if (binaryFile && blockRecords) {
+    size_t sync = sizeof(BinLogSync);
+    if (raw.fill == NO_SLOT) {
+      need += buffersFor(targets[raw.target].dataEnd, sync);
+    } else {
+      size_t room = buffers[raw.fill].limit - buffers[raw.fill].len;
+      if (sync > room) need += buffersFor(0, sync - room);
+    }
+  }
+  const LogTarget &nextRaw = targets[raw.next];
+  size_t header = binaryFile ? sizeof(BinLogFileHeader)
+                : nextRaw.dataEnd ? 0 : strlen(NanoComm::getCSVHeader()) + 2;
+  need += buffersFor(nextRaw.dataEnd, header);
+  const LogStream &stats = streams[STATS_STREAM];
+  if (stats.target != NO_SLOT && targets[stats.next].dataEnd == 0) {
+    need += buffersFor(0, strlen(statsHeader) + 2);
+  }
+  return need <= freeCount;
+}
+
+// Switches both streams to their pre-opened next file with no card I/O: the
+// old files' last buffers are queued and written by service() like any
+// other, and the files close once those are on the card. False, with nothing
+// switched, while a next file is not open yet, the previous switch is still
+// closing, or the buffers lack room for its markers.
+static bool switchToNext() {
+  for (const LogTarget &t : targets) {
+    if (t.used && t.retiring) return false;
+  }
+  for (const LogStream &st : streams) {
+    if (st.target != NO_SLOT && st.next == NO_SLOT) return false;
+  }
+  if (!switchFits()) return false;
+  closeBlock();
+  for (LogStream &st : streams) {
+    if (st.target == NO_SLOT) continue;
+    flushFillBuffer(st);
+    targets[st.target].retiring = true;
+    st.target = st.next;
+    st.next = NO_SLOT;
+  }
+  wstats.rotations++;
+  indexRows = 0;
+  const LogTarget &raw = targets[streams[RAW_STREAM].target];
+  strncpy(currentFile, raw.path, LOG_PATH_LEN - 1);
+  currentFile[LOG_PATH_LEN - 1] = 0;
+  if (binaryFile || raw.dataEnd == 0) writeHeader(NanoComm::getCSVHeader());
+  if (streams[STATS_STREAM].target != NO_SLOT && targets[streams[STATS_STREAM].target].dataEnd == 0) {
+    writeCsvLine(STATS_STREAM, statsHeader);
+  }
+  return true;
+}
+
+// Daily rollover. Tomorrow's file is opened ahead, so the switch at midnight
+// costs no card I/O; the blocking restart is left for a day that was not
+// foreseen (the clock was set since, or the open failed).
 static void checkRollover() {
   if (!isLogging()) return;
   if (logMode != LogMode::Daily) return;
@@ -237,47 +1100,342 @@ static void checkRollover() {
     activeDayIndex = dayIndex;
     return;
   }
-  if (dayIndex != activeDayIndex) {
-    restartLogging(true);
+  if (dayIndex == activeDayIndex) return;
+  char path[LOG_PATH_LEN];
+  buildDailyFilename(path, sizeof(path), epochNow, dayIndex);
+  applyFormatExtension(path, sizeof(path), binaryFile);
+  uint8_t next = streams[RAW_STREAM].next;
+  if (next != NO_SLOT && strcmp(targets[next].path, path) == 0) {
+    if (switchToNext()) activeDayIndex = dayIndex;   // else retried on the next call
+    return;
+  }
+  restartLogging(true);
+}
+
+// Size rotation, to the part opened ahead; past rotateBytes until it is.
+static void checkSizeRotation() {
+  if (logMode != LogMode::Size) return;
+  if (targets[streams[RAW_STREAM].target].dataEnd < rotateBytes) return;
+  if (switchToNext()) partNumber++;
+}
+
+static void addGap(uint32_t first, uint32_t last) {
+  if (last < first) return;
+  wstats.dropped_rows += last - first + 1;
+  if (!gapPending) {
+    gapFirst = first;
+    gapLast = last;
+    gapPending = true;
+    return;
+  }
+  if (first < gapFirst) gapFirst = first;
+  if (last > gapLast) gapLast = last;
+}
+
+static void spillRecord(const BinSwingRecordV1 &rec) {
+  if (spillCount == SD_SPILL_RECORDS) {   // full: drop the oldest
+    addGap(spill[spillHead].swing_id, spill[spillHead].swing_id);
+    spillHead = (uint8_t)((spillHead + 1) % SD_SPILL_RECORDS);
+    spillCount--;
   }
+  spill[(spillHead + spillCount) % SD_SPILL_RECORDS] = rec;
+  spillCount++;
+  wstats.spilled++;
+  if (spillCount > wstats.max_spill) wstats.max_spill = spillCount;
+}
+
+// Bytes of the pending gap marker (its CSV line is formatted into `line`),
+// or 0 if there is none.
+static size_t gapBytes(char *line, size_t len) {
+  if (!gapPending) return 0;
+  if (binaryFile) return sizeof(BinLogSync);
+  int n = rawLogGapLine(line, len, gapFirst, gapLast);
+  return n > 0 ? (size_t)n + 2 : 0;
 }
 
+// The marker only goes in together with the record after it, so a gap that
+// grows meanwhile is still logged once.
+static void writeGap(const char *line) {
+  if (binaryFile) {
+    nextSwingId = gapFirst;
+    appendSync();
+  } else {
+    writeCsvLine(RAW_STREAM, line);
+  }
+  gapPending = false;
+  wstats.gaps++;
+}
+
+// The raw row just appended is on the card once the buffer it ends in is.
+// A CSV row's newline is also the pad byte, so if only the newline went on
+// to a new sector and pad is already on the card behind the row's other
+// bytes, the recovery scan keeps the row without that sector: it is on the
+// card with the buffer before.
+static void markRowEnd(uint32_t swingId) {
+  uint8_t idx = lastFilled;
+  if (!binaryFile && prevFilled != lastFilled) {
+    const SectorBuffer &prev = buffers[prevFilled];
+    if (targets[prev.target].reservedEnd > prev.pos + prev.len) idx = prevFilled;
+  }
+  SectorBuffer &b = buffers[idx];
+  b.rowEnd = true;
+  b.swingId = swingId;
+  bufferedSwing = swingId;
+}
+
+// Buffers one swing, as a CSV row or a binary record. False, with nothing
+// buffered, when it does not fit; the caller spills it.
+static bool writeRecord(const BinSwingRecordV1 &rec) {
+  checkSizeRotation();
+  char gapLine[80];
+  size_t gap = gapBytes(gapLine, sizeof(gapLine));
+  const LogTarget &raw = targets[streams[RAW_STREAM].target];
+  if (binaryFile) {
+    // A block's last record only goes in with room for its sync marker.
+    uint16_t records = gap ? 0 : blockRecords;   // the gap marker closes the block
+    size_t need = gap + sizeof(rec) + (records + 1 >= BINLOG_SYNC_INTERVAL ? sizeof(BinLogSync) : 0);
+    if (streamRoom(RAW_STREAM) < need) return false;
+    if (gap) writeGap(gapLine);
+    uint32_t rowStart = raw.dataEnd;
+    appendBytes(RAW_STREAM, (const uint8_t*)&rec, sizeof(rec));
+    markRowEnd(rec.swing_id);
+    if (!blockRecords) LogIndex::add(raw.path, true, rec.swing_id, rowStart);   // block start
+    blockCrc = binLogCrc16(&rec, sizeof(rec), blockCrc);
+    nextSwingId = rec.swing_id + 1;
+    if (++blockRecords >= BINLOG_SYNC_INTERVAL) appendSync();
+    return true;
+  }
+
+  static char csvBuf[256];
+  PendulumSample s;
+  binLogUnpack(rec, s);   // the same row as before packing (binlog2csv relies on it)
+  int len = rawLogCsvRow(csvBuf, sizeof(csvBuf), s);
+  if (len <= 0 || len >= (int)sizeof(csvBuf)) {
+    static const char truncated[] = "TRUNCATED_LINE\r\n";
+    if (gap) writeGap(gapLine);
+    appendBytes(RAW_STREAM, (const uint8_t*)truncated, sizeof(truncated) - 1);
+    return true;
+  }
+  if (streamRoom(RAW_STREAM) < gap + (size_t)len) return false;
+  if (gap) writeGap(gapLine);
+  uint32_t rowStart = raw.dataEnd;
+  appendBytes(RAW_STREAM, (const uint8_t*)csvBuf, (size_t)len);
+  markRowEnd(rec.swing_id);
+  if (!indexRows) LogIndex::add(raw.path, false, rec.swing_id, rowStart);
+  if (++indexRows >= LOG_INDEX_INTERVAL) indexRows = 0;
+  return true;
+}
+
+// Moves up to `maxRows` spilled swings, oldest first, into the buffers.
+static void drainSpill(uint8_t maxRows) {
+  while (spillCount && maxRows-- && isLogging()) {
+    if (!writeRecord(spill[spillHead])) return;
+    spillHead = (uint8_t)((spillHead + 1) % SD_SPILL_RECORDS);
+    spillCount--;
+  }
+}
+
+// Never waits for the card: a swing the writer cannot take now, or one
+// behind others already waiting, goes to the spill queue.
 void logSample(const PendulumSample &s) {
-  if (!isLogging()) return;
+  if (!loggingEnabled) return;
+  SdTimer timer;
   checkRollover();
-  if (!isLogging()) return;
+  if (!loggingEnabled) return;
+  BinSwingRecordV1 rec;
+  binLogPack(rec, NanoComm::currentSwingId(), s);
+  if (spillCount || !isLogging() || !writeRecord(rec)) spillRecord(rec);
+}
 
-  static char csvBuf[256];
-  int len = snprintf(csvBuf, sizeof(csvBuf),
-    "%lu,%lu,%lu,%lu,%ld,%ld,%u,%u,%.2f,%.2f,%.2f\n",
-    (unsigned long)s.tick,
-    (unsigned long)s.tock,
-    (unsigned long)s.tick_block,
-    (unsigned long)s.tock_block,
-
-    (long)s.corr_inst_ppm,
-    (long)s.corr_blend_ppm,
-    (unsigned int)s.gps_status,
-    (unsigned int)s.dropped_events,
-    s.temperature_C,
-    s.humidity_pct,
-    s.pressure_hPa);
-  if (len > 0 && len < (int)sizeof(csvBuf)) {
-    logFile.write((const uint8_t*)csvBuf, len);
+// The card stopped taking writes (removed, or failing). Its files are
+// dropped with whatever is buffered, the raw rows in those buffers join the
+// gap, and logging waits for a remount while swings spill. Rows written but
+// not synced stay readable: they overwrite pad the file already holds.
+static void loseCard() {
+  gapBuffered();
+  for (LogTarget &t : targets) {
+    if (t.used) t.file.close();
+    t.file = File();
+    t.used = false;
+  }
+  resetWriter();
+  LogIndex::discard();
+  blockRecords = 0;
+  sdReady = false;
+  cardLost = true;
+  failStreak = 0;
+  lastMountMs = millis();
+  Display::scrollLog(F("SD lost"));
+}
+
+// One mount attempt per SD_REMOUNT_INTERVAL_MS. The file is reopened for
+// append (the recovery scan finds its end), or logging starts afresh if it
+// never had a card.
+static void tryRemount() {
+  if (millis() - lastMountMs < SD_REMOUNT_INTERVAL_MS) return;
+  SD.end();
+  if (!mountCard()) return;
+  sdReady = true;
+  cardLost = false;
+  wstats.remounts++;
+  Display::scrollLog(F("SD mounted"));
+  if (restartOnMount) {
+    restartOnMount = false;
+    startLogging(logMode, false);
   } else {
-    logFile.println(F("TRUNCATED_LINE"));
+    openReason = RESET_REMOUNT;
+    openLogFile(currentFile, true);
   }
-  writesSinceFlush++;
-  unsigned long now = millis();
-  bool doFlush = (writesSinceFlush >= FLUSH_EVERY_N) || ((now - lastFlushMs) >= FLUSH_EVERY_MS);
-  if (doFlush) {
-    logFile.flush();
-    writesSinceFlush = 0;
-    lastFlushMs = now;
+}
+
+// One bounded slice of card work, in priority order: queued sectors while
+// under the time budget; an age-limited partial buffer; closing a rotated-out
+// file; a pending sync; a batch of index entries; pre-opening the next file;
+// pad sectors while a reserve is being topped up.
+static void serviceWriter() {
+  if (!isLogging()) return;
+  if (failStreak >= SD_FAIL_LIMIT) {
+    loseCard();
+    return;
+  }
+  uint32_t t0 = micros();
+  if (queued) {
+    while (writeQueued() && (uint32_t)(micros() - t0) < SD_SERVICE_BUDGET_US) {}
+    return;
+  }
+  for (uint8_t s = 0; s < STREAM_COUNT; ++s) {
+    LogStream &st = streams[s];
+    if (st.fill == NO_SLOT || !buffers[st.fill].len) continue;
+    uint32_t maxAge = s == STATS_STREAM ? SD_STATS_MAX_BUFFER_AGE_MS : SD_MAX_BUFFER_AGE_MS;
+    if (millis() - st.fillStartMs < maxAge) continue;
+    targets[st.target].syncPending = true;
+    queueFillBuffer(st);
+    writeQueued();
+    return;
+  }
+  for (uint8_t i = 0; i < SD_LOG_TARGETS; ++i) {
+    if (targets[i].used && targets[i].retiring && !targets[i].pending) {
+      closeTarget(i, false);   // the close is the sync
+      wstats.syncs++;
+      return;
+    }
+  }
+  for (LogTarget &t : targets) {
+    if (t.used && t.syncPending) {
+      OpTimer timer(SdOp::Sync);
+      t.file.flush();
+      wstats.syncs++;
+      t.syncPending = false;
+      return;
+    }
+  }
+  if (LogIndex::service()) return;
+  if (prepareNext()) return;
+  if (!freeCount) return;   // the pad needs a spare buffer
+  for (LogTarget &t : targets) {
+    if (!t.used || t.retiring) continue;
+    if (!t.reserving && reserveAhead(t) < SD_RESERVE_LOW_BYTES) t.reserving = true;
+    if (!t.reserving) continue;
+    while (t.reserving && (uint32_t)(micros() - t0) < SD_SERVICE_BUDGET_US) {
+      if (!reserveSector(t) || reserveAhead(t) >= SD_RESERVE_AHEAD_BYTES) {
+        t.reserving = false;
+        t.syncPending = true;   // commit the new clusters' FAT entries
+      }
+    }
+    return;
+  }
+}
+
+void beginLoop() {
+  if (loopSdUs > wstats.max_loop_us) wstats.max_loop_us = loopSdUs;
+  wstats.last_loop_us = loopSdUs;
+  loopSdUs = 0;
+}
+
+WriterStats writerStats() {
+  WriterStats out = wstats;
+  out.queued = queued;
+  out.spill = spillCount;
+  uint16_t bytes = 0;
+  for (uint8_t i = 0; i < queued; ++i) {
+    bytes += buffers[writeQueue[(queueHead + i) % SD_WRITE_BUFFERS]].len;
+  }
+  for (const LogStream &st : streams) {
+    if (st.fill != NO_SLOT) bytes += buffers[st.fill].len;
+  }
+  out.buffered_bytes = bytes;
+  uint8_t raw = streams[RAW_STREAM].target;
+  out.reserved_bytes = raw != NO_SLOT ? reserveAhead(targets[raw]) : 0;
+  out.part = logMode == LogMode::Size ? partNumber : 0;
+  return out;
+}
+
+uint32_t dataLength(File &f, bool binary) {
+  const uint8_t pad = binary ? BINLOG_PAD_BYTE : '\n';
+  const uint32_t size = (uint32_t)f.size();
+  uint32_t end = size;
+  uint8_t chunk[64];
+  while (end) {
+    uint32_t n = end < sizeof(chunk) ? end : sizeof(chunk);
+    if (!f.seek(end - n) || f.read(chunk, n) != (int)n) break;
+    uint32_t i = n;
+    while (i && chunk[i - 1] == pad) i--;
+    end -= n - i;
+    if (i) break;
   }
+  // The CSV pad is also the row terminator: keep the last row's own newline
+  // (or end a torn row with one).
+  if (!binary && end && end < size) end++;
+  return end;
+}
+
+
+void resetWriterStats() {
+  wstats = WriterStats();
+}
+
+const SdHealth &health() { return sdHealth; }
+
+void resetHealth() { sdHealth = SdHealth(); }
+
+void startHealthPeriod() {
+  for (uint32_t &m : sdHealth.period_max_us) m = 0;
+}
+
+void recordSdOp(SdOp op, uint32_t us, uint32_t bytes) {
+  uint8_t i = (uint8_t)op;
+  if (i >= SD_OP_COUNT) return;
+  uint8_t b = us ? (uint8_t)(31 - __builtin_clz(us)) : 0;
+  if (b >= SD_LATENCY_BUCKETS) b = SD_LATENCY_BUCKETS - 1;
+  sdHealth.latency[i][b]++;
+  if (us > sdHealth.max_us[i]) sdHealth.max_us[i] = us;
+  if (us > sdHealth.period_max_us[i]) sdHealth.period_max_us[i] = us;
+  sdHealth.bytes_written += bytes;
+}
+
+void recordSdError(SdError e) {
+  if ((uint8_t)e < SD_ERROR_COUNT) sdHealth.errors[(uint8_t)e]++;
+}
+
+const char *sdOpName(SdOp op) {
+  static const char *const names[SD_OP_COUNT] = {
+    "write", "reserve", "sync", "open", "close", "dir", "scan", "mount"
+  };
+  return (uint8_t)op < SD_OP_COUNT ? names[(uint8_t)op] : "?";
+}
+
+const char *sdErrorName(SdError e) {
+  static const char *const names[SD_ERROR_COUNT] = {
+    "write", "seek", "open", "reserve", "index", "mount"
+  };
+  return (uint8_t)e < SD_ERROR_COUNT ? names[(uint8_t)e] : "?";
 }
 
 void service() {
+  SdTimer timer;
+  if (isCardLost()) tryRemount();
+  else drainSpill(SD_SPILL_DRAIN_ROWS);
+  serviceWriter();
   unsigned long now = millis();
   if (!hasTimeSync() || (now - ntpSyncMs) > NTP_RESYNC_MS) {
     attemptNtpSync();
@@ -5,7 +5,51 @@
 #include "PendulumProtocol.h"
 
 namespace SDLogger {
-  enum class LogMode : uint8_t { Continuous = 0, Daily = 1 };
+  struct WriterStats {
+    uint32_t max_loop_us;     // most time one loop() iteration spent in SD code
+    uint32_t last_loop_us;
+    uint32_t max_write_us;    // slowest single buffer write
+    uint32_t sectors;         // whole-sector writes
+    uint32_t partial_writes;  // buffers written early by the SD_MAX_BUFFER_AGE_MS limit
+    uint32_t syncs;
+    uint32_t dropped_rows;    // rows lost: spill overflow, buffered when the card went, stats rows with no room
+    uint32_t write_errors;
+    uint32_t max_reserve_us;  // slowest pad-sector write (where allocation stalls land)
+    uint32_t reserve_sectors;
+    uint32_t reserved_bytes;  // pad ahead of the raw file's data
+    uint32_t rotations;       // size-rotation part switches
+    uint32_t torn_bytes;      // cut from file tails by the recovery scan at open
+    uint32_t spilled;         // swings that went through the spill queue
+    uint32_t gaps;            // gap markers logged
+    uint32_t remounts;        // card lost and mounted again
+    uint16_t part;            // current part number (size rotation), else 0
+    uint16_t buffered_bytes;
+    uint8_t  queued;
+    uint8_t  spill;           // swings waiting in the spill queue
+    uint8_t  max_spill;
+  };
+
+  // Health telemetry: every card operation the logger (and LogIndex) makes,
+  // timed into a log2 histogram per type (SD_LATENCY_BUCKETS, bucket 0 also
+  // takes < 1 us). Dir is mkdir, remove and the part-directory walk; Scan the
+  // reads that find a file's data end and torn tail at open.
+  enum class SdOp : uint8_t { Write = 0, Reserve, Sync, Open, Close, Dir, Scan, Mount, Count };
+  enum class SdError : uint8_t { Write = 0, Seek, Open, Reserve, Index, Mount, Count };
+  constexpr uint8_t SD_OP_COUNT = (uint8_t)SdOp::Count;
+  constexpr uint8_t SD_ERROR_COUNT = (uint8_t)SdError::Count;
+
+  struct SdHealth {
+    uint32_t latency[SD_OP_COUNT][SD_LATENCY_BUCKETS];
+    uint32_t max_us[SD_OP_COUNT];
+    uint32_t period_max_us[SD_OP_COUNT];   // since the last startHealthPeriod()
+    uint32_t errors[SD_ERROR_COUNT];
+    uint32_t bytes_written;                // rows, markers, pad and index entries
+    uint8_t  max_queued;                   // deepest write queue seen
+  };
+
+  // Size: LOG_RAW_DIR/rNNNpMMM.csv parts, rolled at the rotate size.
+  enum class LogMode : uint8_t { Continuous = 0, Daily = 1, Size = 2 };
+  enum class LogFormat : uint8_t { Csv = 0, Binary = 1 };   // Binary: BinLog.h
 
   void begin();
   void service();
@@ -18,13 +62,20 @@ namespace SDLogger {
   void setFilename(const char* fname);
   void setAppendMode(bool append);
   void setLogMode(LogMode mode);
+  void setLogFormat(LogFormat format);   // takes effect when the next file opens
+  void setRotateSizeMB(uint8_t mb);      // size rotation threshold; 0 = default
 
   const char* getFilename();           // configured base filename (continuous)
   const char* getActiveFilename();     // currently open file path
   bool getAppendMode();
   LogMode getLogMode();
+  LogFormat getLogFormat();
+  uint8_t getRotateSizeMB();
+  LogMode logModeFor(bool daily, bool sizeRotate);   // from the stored tunables
 
-  bool isLogging();
+  bool isLogging();         // logging and the card is there
+  bool isLogEnabled();      // logging was started; swings spill while the card is gone
+  bool isCardLost();        // logging, card gone: remount attempts from service()
   bool ready();
 
   bool hasTimeSync();
@@ -32,7 +83,30 @@ namespace SDLogger {
   unsigned long secondsSinceLastSync();
 
   bool isValidFilename(const char* fn);
+  bool isValidLogPath(const char* path);   // a filename, or one under LOG_RAW_DIR / LOG_STATS_DIR
+
+  // Bytes of log data in `f`, i.e. its size less the reserve-ahead pad.
+  uint32_t dataLength(File &f, bool binary);
 
   void writeHeader(const char *hdr);
   void logSample(const PendulumSample &s);
+
+  // Stats log: a CSV written beside the raw log (LOG_STATS_DIR, same base
+  // name) through the same buffers, and rolled with it. No stats file is
+  // opened until a header is set; the string must outlive logging.
+  void setStatsHeader(const char *hdr);
+  void logStatsRow(const char *row, size_t len);   // whole line, "\n" included
+
+  // Call once at the top of loop(): closes the per-iteration SD timing.
+  void beginLoop();
+  WriterStats writerStats();
+  void resetWriterStats();
+
+  const SdHealth &health();
+  void resetHealth();
+  void startHealthPeriod();              // the stats log, after each row
+  void recordSdOp(SdOp op, uint32_t us, uint32_t bytes = 0);
+  void recordSdError(SdError e);
+  const char *sdOpName(SdOp op);
+  const char *sdErrorName(SdError e);
 }
@@ -0,0 +1,263 @@
+#include "Spectrum.h"
+#include "Display.h"
+#include "NanoComm.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if ENABLE_PSD
+
+namespace Spectrum {
+
+// Buffers are sized for PSD_SEGMENT_MAX; the segment length n in use is set
+// at runtime by AnalysisTunables::psdSegmentLen.
+static constexpr uint16_t MAX_N = PSD_SEGMENT_MAX;
+
+static uint8_t log2u(uint16_t v) { return v > 1 ? 1 + log2u(v >> 1) : 0; }
+
+enum class Stage : uint8_t { Idle, Butterfly, Accumulate };
+
+static constexpr float TWO_PI_F = 6.28318530718f;
+
+// sinTable[i] = sin(2*pi*i/MAX_N) in Q15 for i in [0, 3*MAX_N/4];
+// cos(i) = sin(i + MAX_N/4) for i in [0, MAX_N/2]. A segment of n points
+// steps through it with stride MAX_N/n.
+static int16_t  sinTable[MAX_N / 2 + MAX_N / 4 + 1];
+static float    inputRing[MAX_N];
+static int16_t  re[MAX_N];
+static int16_t  im[MAX_N];
+static float    psdAvg[MAX_N / 2 + 1];
+
+static uint16_t n = PSD_SEGMENT_LEN;
+static uint16_t half = PSD_SEGMENT_LEN / 2;
+static uint16_t stride = PSD_SEGMENT_MAX / PSD_SEGMENT_LEN;
+static uint8_t  stages = 0;
+static uint16_t requested = 0;      // last psdSegmentLen seen
+
+static uint16_t inHead = 0;
+static uint32_t inCount = 0;
+static uint16_t sinceSegment = 0;
+static bool     segmentDue = false;
+static Stage    stage = Stage::Idle;
+static uint8_t  stageIdx = 0;
+static float    segScale = 1.0f;
+static uint32_t segments = 0;
+static uint32_t skipped = 0;
+static double   tau0 = 0.0;
+static uint16_t lastDropped = 0;
+static bool     haveSample = false;
+
+// Table lookups take an index in MAX_N units.
+static inline int16_t q15Sin(uint16_t i) { return sinTable[i]; }
+static inline int16_t q15Cos(uint16_t i) { return sinTable[i + MAX_N / 4]; }
+
+// Hann weight; cos is even about n/2 so only the first half of the table is used.
+static inline float hann(uint16_t i) {
+  uint16_t j = i <= half ? i : (uint16_t)(n - i);
+  return 0.5f - 0.5f * (float)q15Cos((uint16_t)(j * stride)) / 32767.0f;
+}
+
+static uint16_t bitReverse(uint16_t v) {
+  uint16_t r = 0;
+  for (uint8_t b = 0; b < stages; ++b) {
+    r = (uint16_t)((r << 1) | (v & 1u));
+    v >>= 1;
+  }
+  return r;
+}
+
+// The largest power of two in [PSD_SEGMENT_MIN, PSD_SEGMENT_MAX] not above
+// psdSegmentLen. A new length restarts the average.
+static void configure() {
+  uint16_t want = AnalysisTunables::psdSegmentLen;
+  if (want == requested && stages) return;
+  requested = want;
+  uint16_t len = PSD_SEGMENT_MIN;
+  while (len < PSD_SEGMENT_MAX && (uint32_t)len * 2u <= want) len = (uint16_t)(len * 2u);
+  if (len != want) {
+    char msg[40];
+    snprintf(msg, sizeof(msg), "Clamping psdSegmentLen to %u", (unsigned int)len);
+    Display::scrollLog(msg);
+  }
+  if (len == n && stages) return;
+  n = len;
+  half = (uint16_t)(len / 2);
+  stride = (uint16_t)(MAX_N / len);
+  stages = log2u(len);
+  reset();
+}
+
+void begin() {
+  for (uint16_t i = 0; i <= MAX_N / 2 + MAX_N / 4; ++i) {
+    sinTable[i] = (int16_t)lroundf(32767.0f * sinf(TWO_PI_F * (float)i / (float)MAX_N));
+  }
+  configure();
+  reset();
+}
+
+void reset() {
+  inHead = 0;
+  inCount = 0;
+  sinceSegment = 0;
+  segmentDue = false;
+  stage = Stage::Idle;
+  segments = 0;
+  skipped = 0;
+  tau0 = 0.0;
+  haveSample = false;
+  memset(psdAvg, 0, sizeof(psdAvg));
+}
+
+void update(const PendulumSample &sample) {
+  configure();
+  uint32_t ticks = sample.tick + sample.tock + sample.tick_block + sample.tock_block;
+  if (ticks == 0) return;
+
+  // A missing swing breaks the uniform sampling the FFT assumes.
+  if (haveSample && sample.dropped_events != lastDropped) {
+    inHead = 0;
+    inCount = 0;
+    sinceSegment = 0;
+    segmentDue = false;
+  }
+  lastDropped = sample.dropped_events;
+  haveSample = true;
+
+  double period_s = NanoComm::ticksToSeconds(ticks, sample.corr_blend_ppm);
+  if (tau0 <= 0.0) tau0 = period_s;
+  inputRing[inHead] = (float)((period_s - tau0) * 1e6);
+  inHead = (uint16_t)((inHead + 1) % n);
+  if (inCount < n) inCount++;
+  if (++sinceSegment >= half && inCount >= n) {
+    sinceSegment = 0;
+    if (segmentDue || stage != Stage::Idle) skipped++;
+    else segmentDue = true;
+  }
+}
+
+// Detrend (segment mean), apply the Hann window, scale to Q15 using the
+// segment's peak (block floating point) and store in bit-reversed order.
+static bool loadSegment() {
+  double mean = 0.0;
+  for (uint16_t i = 0; i < n; ++i) mean += inputRing[i];
+  mean /= (double)n;
+
+  float peak = 0.0f;
+  for (uint16_t i = 0; i < n; ++i) {
+    float v = (float)(inputRing[(inHead + i) % n] - mean);
+    float w = hann(i);
+    float a = fabsf(v * w);
+    if (a > peak) peak = a;
+  }
+  if (peak <= 0.0f) return false;
+  segScale = 16383.0f / peak;
+
+  for (uint16_t i = 0; i < n; ++i) {
+    float v = (float)(inputRing[(inHead + i) % n] - mean);
+    float w = hann(i);
+    uint16_t r = bitReverse(i);
+    re[r] = (int16_t)lroundf(v * w * segScale);
+    im[r] = 0;
+  }
+  return true;
+}
+
+// One radix-2 decimation-in-time stage, scaled by 1/2 to stay in Q15.
+static void butterflyStage(uint8_t s) {
+  uint16_t len = (uint16_t)(2u << s);
+  uint16_t halfLen = len >> 1;
+  uint16_t twStep = MAX_N / len;
+  for (uint16_t base = 0; base < n; base += len) {
+    for (uint16_t j = 0; j < halfLen; ++j) {
+      uint16_t a = base + j;
+      uint16_t b = a + halfLen;
+      int32_t wr = q15Cos(j * twStep);
+      int32_t wi = -q15Sin(j * twStep);
+      int32_t tr = (wr * re[b] - wi * im[b]) >> 15;
+      int32_t ti = (wr * im[b] + wi * re[b]) >> 15;
+      int32_t ar = re[a];
+      int32_t ai = im[a];
+      re[a] = (int16_t)((ar + tr) >> 1);
+      im[a] = (int16_t)((ai + ti) >> 1);
+      re[b] = (int16_t)((ar - tr) >> 1);
+      im[b] = (int16_t)((ai - ti) >> 1);
+    }
+  }
+}
+
+// Fold |X|^2 into the running Welch average as a one-sided PSD in us^2/Hz:
+// P = c * |X|^2 * tau0 / sum(w^2), with sum(w^2) = 3n/8 for Hann and c = 2
+// except at DC and Nyquist. The FFT's 1/n stage scaling is undone here.
+static void accumulate() {
+  float unscale = (float)n / segScale;
+  float norm = unscale * unscale * (float)tau0 / (3.0f * (float)n / 8.0f);
+  segments++;
+  float inv = 1.0f / (float)segments;
+  for (uint16_t k = 0; k <= half; ++k) {
+    float p = ((float)re[k] * (float)re[k] + (float)im[k] * (float)im[k]) * norm;
+    if (k != 0 && k != half) p *= 2.0f;
+    psdAvg[k] += (p - psdAvg[k]) * inv;
+  }
+}
+
+void service() {
+  switch (stage) {
+    case Stage::Idle:
+      if (!segmentDue) return;
+      segmentDue = false;
+      if (loadSegment()) {
+        stage = Stage::Butterfly;
+        stageIdx = 0;
+      }
+      return;
+    case Stage::Butterfly:
+      butterflyStage(stageIdx);
+      if (++stageIdx >= stages) stage = Stage::Accumulate;
+      return;
+    case Stage::Accumulate:
+      accumulate();
+      stage = Stage::Idle;
+      return;
+  }
+}
+
+uint16_t segmentLength() { return n; }
+uint32_t segmentsAveraged() { return segments; }
+uint32_t segmentsSkipped() { return skipped; }
+float tau0Seconds() { return (float)tau0; }
+
+float binHz() {
+  return tau0 > 0.0 ? (float)(1.0 / (tau0 * (double)n)) : 0.0f;
+}
+
+float psd(uint16_t bin) {
+  return bin <= half ? psdAvg[bin] : 0.0f;
+}
+
+uint8_t peaks(SpectrumPeak *out, uint8_t maxPeaks) {
+  uint8_t found = 0;
+  if (!out || !maxPeaks || !segments) return 0;
+  float hzPerBin = binHz();
+  for (uint16_t k = 1; k < half; ++k) {
+    float p = psdAvg[k];
+    if (!(p > psdAvg[k - 1] && p >= psdAvg[k + 1])) continue;
+    // Insertion into the descending top-N list.
+    uint8_t pos = found;
+    while (pos > 0 && out[pos - 1].psd < p) {
+      if (pos < maxPeaks) out[pos] = out[pos - 1];
+      pos--;
+    }
+    if (pos >= maxPeaks) continue;
+    out[pos].bin = k;
+    out[pos].hz = hzPerBin * (float)k;
+    out[pos].period_swings = (float)n / (float)k;
+    out[pos].psd = p;
+    if (found < maxPeaks) found++;
+  }
+  return found;
+}
+
+} // namespace Spectrum
+
+#endif // ENABLE_PSD
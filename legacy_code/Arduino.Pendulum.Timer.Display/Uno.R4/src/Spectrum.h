@@ -0,0 +1,38 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// Spectrum.h
+// Welch power spectral density of the swing-period residual series.
+//
+// Residuals (period minus a reference, in us) are collected per swing; every
+// PSD_SEGMENT_LEN/2 swings a Hann-windowed segment is transformed with a Q15
+// radix-2 FFT and averaged into the running spectrum (50% overlap). The FFT
+// runs from service() one stage per call so ingest never waits on it.
+// -----------------------------------------------------------------------------
+
+#include "Config.h"
+#include "PendulumProtocol.h"
+
+struct SpectrumPeak {
+  uint16_t bin;
+  float    hz;
+  float    period_swings;  // 1 / (cycles per swing)
+  float    psd;            // us^2/Hz
+};
+
+namespace Spectrum {
+  void begin();
+  void reset();
+  void update(const PendulumSample &sample);
+  void service();
+
+  uint16_t segmentLength();
+  uint32_t segmentsAveraged();
+  uint32_t segmentsSkipped();   // segments dropped because the FFT was still busy
+  float    tau0Seconds();       // reference swing period (sample interval)
+  float    binHz();
+  float    psd(uint16_t bin);   // averaged one-sided PSD, us^2/Hz; bin 0..N/2
+
+  // Strongest local maxima (DC excluded), highest first. Returns the count.
+  uint8_t  peaks(SpectrumPeak *out, uint8_t maxPeaks);
+}
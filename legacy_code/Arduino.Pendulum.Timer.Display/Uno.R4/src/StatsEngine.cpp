@@ -1,10 +1,15 @@
 #include "StatsEngine.h"
 #include "Display.h"
+#include "Cusum.h"
+#include "MedianOfMeans.h"
+#include "OrderStats.h"
+#include "RunningMoments.h"
 
 #ifdef abs
 #undef abs
 #endif
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
@@ -13,8 +18,6 @@ namespace StatsEngine {
 
 static constexpr float NANO_TICK_FREQ_F = 16000000.0f;
 
-static float stddev(double sum, double sumSq, uint16_t count);
-
 static float unitsPerMinute(int32_t corr_blend_ppm) {
   switch (NanoComm::getDataUnits()) {
     case DataUnits::RawCycles: {
@@ -27,105 +30,97 @@ static float unitsPerMinute(int32_t corr_blend_ppm) {
   }
 }
 
-static constexpr uint16_t MAX_WINDOW = DEFAULT_STATS_WINDOW;
+// BPM enters the exact moments as an integer in units of 1e-7 BPM, well below
+// what the OLED or /stats.json show. A garbage period can give an absurd BPM;
+// it is clamped to the range RunningMoments accepts, the same way on add and
+// remove.
+static constexpr double BPM_FIXED_SCALE = 1e7;
+
+static inline int64_t bpmFixed(float bpm) {
+  double v = (double)bpm * BPM_FIXED_SCALE;
+  if (!(v > -4.0e9)) v = -4.0e9;   // also catches NaN
+  if (v > 4.0e9) v = 4.0e9;
+  return (int64_t)llround(v);
+}
 
 struct WindowSums {
-  uint64_t sumPeriod = 0;
-  uint64_t sumPeriodUs = 0;
-  double   sumSqPeriodUs = 0.0;
-  double   sumBpm = 0.0;
-  double   sumSqBpm = 0.0;
-  int64_t  sumDeltaBeat = 0;
-  int64_t  sumDeltaBlock = 0;
-  double   sumSqDeltaBeat = 0.0;
-  double   sumSqDeltaBlock = 0.0;
-  uint64_t sumBlockJump = 0;
-  double   sumSqBlockJump = 0.0;
-  uint16_t blockJumpCount = 0;
+  RunningMoments periodUs;
+  RunningMoments bpm;
+  RunningMoments deltaBeat;
+  RunningMoments deltaBlock;
+  RunningMoments blockJump;
 
   void reset() {
-    sumPeriod = 0;
-    sumPeriodUs = 0;
-    sumSqPeriodUs = 0.0;
-    sumBpm = 0.0;
-    sumSqBpm = 0.0;
-    sumDeltaBeat = 0;
-    sumDeltaBlock = 0;
-    sumSqDeltaBeat = 0.0;
-    sumSqDeltaBlock = 0.0;
-    sumBlockJump = 0;
-    sumSqBlockJump = 0.0;
-    blockJumpCount = 0;
-  }
-
-  void addSample(uint32_t period_units, uint32_t period_us, float bpm_now,
-                 int32_t dBeat_units, int32_t dBlock_units,
-                 uint32_t blockJumpMag, bool countBlockJump) {
-    sumPeriod     += period_units;
-    sumPeriodUs   += period_us;
-    sumSqPeriodUs += (double)period_us * (double)period_us;
-    sumBpm        += (double)bpm_now;
-    sumSqBpm      += (double)bpm_now * (double)bpm_now;
-    sumDeltaBeat  += dBeat_units;
-    sumDeltaBlock += dBlock_units;
-    sumSqDeltaBeat  += (double)dBeat_units  * (double)dBeat_units;
-    sumSqDeltaBlock += (double)dBlock_units * (double)dBlock_units;
-    if (countBlockJump) {
-      sumBlockJump    += (uint64_t)blockJumpMag;
-      sumSqBlockJump  += (double)blockJumpMag * (double)blockJumpMag;
-      blockJumpCount++;
-    }
+    periodUs.reset();
+    bpm.reset();
+    deltaBeat.reset();
+    deltaBlock.reset();
+    blockJump.reset();
   }
 
-  void removeSample(uint32_t period_units, uint32_t period_us, double bpm,
-                    int32_t dBeat_units, int32_t dBlock_units,
-                    uint32_t blockJumpMag, bool hadPrevBlock) {
-    sumPeriod      -= period_units;
-    sumPeriodUs    -= period_us;
-    sumSqPeriodUs  -= (double)period_us * (double)period_us;
-    sumBpm         -= bpm;
-    sumSqBpm       -= bpm * bpm;
-    sumDeltaBeat   -= dBeat_units;
-    sumDeltaBlock  -= dBlock_units;
-    sumSqDeltaBeat  -= (double)dBeat_units  * (double)dBeat_units;
-    sumSqDeltaBlock -= (double)dBlock_units * (double)dBlock_units;
-    if (hadPrevBlock && blockJumpCount) {
-      sumBlockJump   -= (uint64_t)blockJumpMag;
-      sumSqBlockJump -= (double)blockJumpMag * (double)blockJumpMag;
-      blockJumpCount--;
-    }
+  void addSample(uint32_t period_us, float bpm_now,
+                 int32_t dBeat_units, int32_t dBlock_units) {
+    periodUs.add(period_us);
+    bpm.add(bpmFixed(bpm_now));
+    deltaBeat.add(dBeat_units);
+    deltaBlock.add(dBlock_units);
   }
 
-  void removeOrphanedHead(uint32_t blockJumpMag) {
-    if (blockJumpCount) {
-      sumBlockJump   -= (uint64_t)blockJumpMag;
-      sumSqBlockJump -= (double)blockJumpMag * (double)blockJumpMag;
-      blockJumpCount--;
-    }
+  void removeSample(uint32_t period_us, float bpm_old,
+                    int32_t dBeat_units, int32_t dBlock_units) {
+    periodUs.remove(period_us);
+    bpm.remove(bpmFixed(bpm_old));
+    deltaBeat.remove(dBeat_units);
+    deltaBlock.remove(dBlock_units);
+  }
+
+  // Block jumps are pairwise, so they are tracked apart from the samples: the
+  // oldest sample in a window never carries one.
+  void addJump(uint32_t blockJumpMag) {
+    blockJump.add(blockJumpMag);
+  }
+
+  void removeJump(uint32_t blockJumpMag) {
+    if (blockJump.n) blockJump.remove(blockJumpMag);
+  }
+
+  // Whole blocks of the long window.
+  void add(const WindowSums &o) {
+    periodUs.add(o.periodUs);
+    bpm.add(o.bpm);
+    deltaBeat.add(o.deltaBeat);
+    deltaBlock.add(o.deltaBlock);
+    blockJump.add(o.blockJump);
+  }
+
+  void remove(const WindowSums &o) {
+    periodUs.remove(o.periodUs);
+    bpm.remove(o.bpm);
+    deltaBeat.remove(o.deltaBeat);
+    deltaBlock.remove(o.deltaBlock);
+    blockJump.remove(o.blockJump);
   }
 
   RollingStats finalize(uint16_t count, uint32_t period_us,
                         float bpm_now, int32_t dBeat_units,
-                        int32_t dBlock_units, uint32_t blockJumpMag) const {
+                        int32_t dBlock_units) const {
     RollingStats result = {0};
     if (count) {
-      double c = (double)count;
-      result.avg_bpm           = (float)(sumBpm / c);
-      result.avg_delta_beat    = (float)((double)sumDeltaBeat  / c);
-      result.avg_delta_block   = (float)((double)sumDeltaBlock / c);
-      if (blockJumpCount) {
-        double jumpCount = (double)blockJumpCount;
-        result.avg_block_jump    = (float)((double)sumBlockJump / jumpCount);
-        result.stddev_block_jump = stddev((double)sumBlockJump, sumSqBlockJump, blockJumpCount);
+      result.avg_bpm           = (float)(bpm.mean() / BPM_FIXED_SCALE);
+      result.avg_delta_beat    = (float)deltaBeat.mean();
+      result.avg_delta_block   = (float)deltaBlock.mean();
+      if (blockJump.n) {
+        result.avg_block_jump    = (float)blockJump.mean();
+        result.stddev_block_jump = blockJump.stddev();
       } else {
         result.avg_block_jump    = 0.0f;
         result.stddev_block_jump = 0.0f;
       }
-      result.avg_period_us     = (float)((double)sumPeriodUs / c);
-      result.stddev_bpm        = stddev(sumBpm, sumSqBpm, count);
-      result.stddev_delta_beat = stddev((double)sumDeltaBeat, sumSqDeltaBeat, count);
-      result.stddev_delta_block= stddev((double)sumDeltaBlock, sumSqDeltaBlock, count);
-      result.stddev_period_us  = stddev((double)sumPeriodUs, sumSqPeriodUs, count);
+      result.avg_period_us     = (float)periodUs.mean();
+      result.stddev_bpm        = (float)(sqrt(bpm.variance()) / BPM_FIXED_SCALE);
+      result.stddev_delta_beat = deltaBeat.stddev();
+      result.stddev_delta_block= deltaBlock.stddev();
+      result.stddev_period_us  = periodUs.stddev();
     } else {
       result.avg_bpm           = bpm_now;
       result.avg_delta_beat    = (float)dBeat_units;
@@ -146,57 +141,445 @@ struct WindowSums {
   }
 };
 
-struct WindowState {
-  RollingSample samples[MAX_WINDOW];
+// Per-sample contributions are stored already derived (struct-of-arrays), so
+// eviction only subtracts what was added and never repeats the tick->unit
+// conversions. This keeps a large time-based eviction after a pause cheap.
+//
+// One ring holds the recent history, addressed by an absolute swing sequence
+// number (slot = seq % STATS_RING_CAPACITY). The short window is only a tail
+// cursor plus its sums, so it can be resized at runtime: shrinking evicts from
+// the tail, growing re-adds older samples still in the ring.
+struct SampleRing {
+  uint32_t period_us[STATS_RING_CAPACITY];
+  int32_t  dBeat[STATS_RING_CAPACITY];
+  int32_t  dBlock[STATS_RING_CAPACITY];
+  float    bpm[STATS_RING_CAPACITY];
+  uint32_t timestamp_ms[STATS_RING_CAPACITY];
+};
+
+struct OrderTrees {
+  OrderStatTree<STATS_SHORT_WINDOW_MAX> period;   // period_us by seq % max
+  OrderStatTree<STATS_SHORT_WINDOW_MAX> beat;     // dBeat units by seq % max
+};
+
+struct StatsWindow {
   WindowSums sums;
+  OrderTrees *order = nullptr;
   RollingStats stats = {0};
-  uint16_t capacity = 0;
-  uint16_t index = 0;
-  uint16_t tail = 0;
+  uint32_t tailSeq = 0;
   uint16_t count = 0;
+  uint16_t size = 0;             // clamped target size
+  uint16_t requested = 0;        // last requested size, for clamp logging
+  bool     timeLimited = false;  // also evict by rollingWindowMs
 };
 
-static WindowState window;
-static uint16_t lastClampedRequest = 0;
-static uint16_t lastRequestedWindow = 0;
+#if ENABLE_LONG_WINDOW
+// The long window outlives the ring, so it is kept in blocks (see Config.h).
+// `sums` covers the finished blocks in the window plus `part`, the block in
+// progress, so the mean and stddev follow every swing. Sketch points sit in
+// the trees under block slot * STATS_LONG_SKETCH + j. Block jumps are counted
+// between swings of the same block only.
+typedef OrderStatTree<(uint16_t)STATS_LONG_BLOCKS * STATS_LONG_SKETCH> SketchTree;
+
+struct LongWindow {
+  WindowSums blocks[STATS_LONG_BLOCKS];
+  uint32_t   firstSeq[STATS_LONG_BLOCKS];
+  SketchTree period;              // period_us
+  SketchTree beat;                // dBeat units
+  WindowSums sums;
+  WindowSums part;
+  RollingStats stats = {0};
+  uint32_t   partSeq = 0;         // first sample of the block in progress
+  uint16_t   partCount = 0;
+  uint16_t   requested = 0;       // last requested size, for clamp logging
+  uint8_t    head = 0;            // slot the next finished block goes to
+  uint8_t    held = 0;            // finished blocks in the window
+  uint8_t    size = 0;            // window size in blocks, 0 when off
+};
+#endif
+
+static SampleRing ring;
+static OrderTrees shortOrder;
+static StatsWindow shortWindow;
+#if ENABLE_LONG_WINDOW
+static LongWindow longWindow;
+#endif
+static MedianOfMeans<MOM_MAX_BLOCKS> momPeriod;
+static MedianOfMeans<MOM_MAX_BLOCKS> momBeat;
+static MedianOfMeans<MOM_MAX_BLOCKS> momBpm;
+static RobustStats robustStats = {0};
+static CusumDetector periodCusum;
+static CusumDetector beatCusum;
+static bool cusumConfigured = false;
+static ChangeEvent changeLog[CHANGE_EVENT_LOG];
+static uint8_t  changeHead = 0;
+static uint8_t  changeCount = 0;
+static uint32_t changeTotal = 0;
+static uint32_t headSeq = 0;    // sequence number of the next sample
+static uint32_t floorSeq = 0;   // oldest sequence still valid after a reset
+
+static inline uint16_t ringSlot(uint32_t seq) {
+  return (uint16_t)(seq % STATS_RING_CAPACITY);
+}
+
+static inline uint32_t jumpAt(uint32_t seq) {
+  return (uint32_t)std::abs(ring.dBlock[ringSlot(seq)]);
+}
+
+static uint32_t oldestSeq() {
+  uint32_t oldest = headSeq > STATS_RING_CAPACITY ? headSeq - STATS_RING_CAPACITY : 0;
+  return oldest > floorSeq ? oldest : floorSeq;
+}
+
+static void addToWindow(StatsWindow &w, uint32_t seq) {
+  uint16_t s = ringSlot(seq);
+  w.sums.addSample(ring.period_us[s], ring.bpm[s], ring.dBeat[s], ring.dBlock[s]);
+  if (w.order) {
+    uint16_t key = (uint16_t)(seq % STATS_SHORT_WINDOW_MAX);
+    w.order->period.insert(key, (int32_t)ring.period_us[s]);
+    w.order->beat.insert(key, ring.dBeat[s]);
+  }
+}
+
+static void removeFromWindow(StatsWindow &w, uint32_t seq) {
+  uint16_t s = ringSlot(seq);
+  w.sums.removeSample(ring.period_us[s], ring.bpm[s], ring.dBeat[s], ring.dBlock[s]);
+  if (w.order) {
+    uint16_t key = (uint16_t)(seq % STATS_SHORT_WINDOW_MAX);
+    w.order->period.erase(key);
+    w.order->beat.erase(key);
+  }
+}
+
+static void pushHead(StatsWindow &w, uint32_t seq) {
+  if (w.count) w.sums.addJump(jumpAt(seq));
+  else w.tailSeq = seq;
+  addToWindow(w, seq);
+  w.count++;
+}
+
+static void evictOldest(StatsWindow &w) {
+  removeFromWindow(w, w.tailSeq);
+  w.tailSeq++;
+  w.count--;
+  if (w.count) w.sums.removeJump(jumpAt(w.tailSeq));
+}
+
+static void extendTail(StatsWindow &w) {
+  uint32_t seq = w.tailSeq - 1;
+  if (w.count) w.sums.addJump(jumpAt(w.tailSeq));
+  addToWindow(w, seq);
+  w.tailSeq = seq;
+  w.count++;
+}
+
+static void clearWindow(StatsWindow &w) {
+  w.tailSeq = headSeq;
+  w.count = 0;
+  w.stats = {0};
+  w.sums.reset();
+  if (w.order) {
+    w.order->period.clear();
+    w.order->beat.clear();
+  }
+}
+
+static bool tooOld(const StatsWindow &w, uint32_t seq, unsigned long now) {
+  return w.timeLimited && (now - ring.timestamp_ms[ringSlot(seq)]) > UnoTunables::rollingWindowMs;
+}
+
+static void refreshStats(StatsWindow &w) {
+  if (headSeq == floorSeq) {
+    w.stats = {0};
+    return;
+  }
+  uint16_t s = ringSlot(headSeq - 1);
+  w.stats = w.sums.finalize(w.count, ring.period_us[s], ring.bpm[s], ring.dBeat[s], ring.dBlock[s]);
+  if (w.order) {
+    w.stats.median_period_us = w.order->period.median();
+    w.stats.mad_period_us    = w.order->period.mad();
+    w.stats.median_delta_beat= w.order->beat.median();
+    w.stats.mad_delta_beat   = w.order->beat.mad();
+  }
+}
+
+static void applySize(StatsWindow &w, uint16_t requested, uint16_t limit,
+                      const __FlashStringHelper *clampMsg) {
+  uint16_t desired = requested > limit ? limit : requested;
+  if (requested > limit && requested != w.requested) {
+    Display::scrollLog(clampMsg);
+  }
+  w.requested = requested;
+  if (desired == w.size) return;
+  w.size = desired;
+
+  while (w.count > desired) {
+    evictOldest(w);
+  }
+  unsigned long now = millis();
+  uint32_t oldest = oldestSeq();
+  if (!w.count && headSeq > oldest && desired) {
+    pushHead(w, headSeq - 1);
+  }
+  while (w.count && w.count < desired && w.tailSeq > oldest && !tooOld(w, w.tailSeq - 1, now)) {
+    extendTail(w);
+  }
+  refreshStats(w);
+}
+
+#if ENABLE_LONG_WINDOW
+static inline uint8_t longOldest(const LongWindow &lw) {
+  return (uint8_t)((lw.head + STATS_LONG_BLOCKS - lw.held) % STATS_LONG_BLOCKS);
+}
+
+// The values at ranks (2j + 1) n / (2 * STATS_LONG_SKETCH) of n ring samples
+// from `seq` on, each standing for an equal share of the block. Sorted in a
+// copy, O(n log n) once per block.
+static int32_t sketchScratch[STATS_LONG_BLOCK_LEN];
+
+static void sketchBlock(uint32_t seq, uint16_t n, bool beat, int32_t out[STATS_LONG_SKETCH]) {
+  for (uint16_t i = 0; i < n; ++i) {
+    uint16_t si = ringSlot(seq + i);
+    sketchScratch[i] = beat ? ring.dBeat[si] : (int32_t)ring.period_us[si];
+  }
+  std::sort(sketchScratch, sketchScratch + n);
+  for (uint8_t k = 0; k < STATS_LONG_SKETCH; ++k) {
+    uint32_t rank = ((uint32_t)(2 * k + 1) * n) / (2 * STATS_LONG_SKETCH);
+    out[k] = sketchScratch[rank];
+  }
+}
+
+static void finishLongBlock(LongWindow &lw) {
+  uint8_t b = lw.head;
+  int32_t periodPts[STATS_LONG_SKETCH];
+  int32_t beatPts[STATS_LONG_SKETCH];
+  sketchBlock(lw.partSeq, lw.partCount, false, periodPts);
+  sketchBlock(lw.partSeq, lw.partCount, true, beatPts);
+  for (uint8_t k = 0; k < STATS_LONG_SKETCH; ++k) {
+    uint16_t key = (uint16_t)(b * STATS_LONG_SKETCH + k);
+    lw.period.insert(key, periodPts[k]);
+    lw.beat.insert(key, beatPts[k]);
+  }
+  lw.blocks[b] = lw.part;
+  lw.firstSeq[b] = lw.partSeq;
+  lw.head = (uint8_t)((b + 1) % STATS_LONG_BLOCKS);
+  lw.held++;
+  lw.part.reset();
+  lw.partCount = 0;
+}
+
+static void evictLongBlock(LongWindow &lw) {
+  uint8_t b = longOldest(lw);
+  lw.sums.remove(lw.blocks[b]);
+  for (uint8_t k = 0; k < STATS_LONG_SKETCH; ++k) {
+    uint16_t key = (uint16_t)(b * STATS_LONG_SKETCH + k);
+    lw.period.erase(key);
+    lw.beat.erase(key);
+  }
+  lw.held--;
+}
+
+static void pushLong(LongWindow &lw, uint32_t seq) {
+  if (!lw.partCount) {
+    while (lw.held && lw.held >= lw.size) {
+      evictLongBlock(lw);
+    }
+    lw.partSeq = seq;
+  } else {
+    uint32_t jump = jumpAt(seq);
+    lw.part.addJump(jump);
+    lw.sums.addJump(jump);
+  }
+  uint16_t s = ringSlot(seq);
+  lw.part.addSample(ring.period_us[s], ring.bpm[s], ring.dBeat[s], ring.dBlock[s]);
+  lw.sums.addSample(ring.period_us[s], ring.bpm[s], ring.dBeat[s], ring.dBlock[s]);
+  if (++lw.partCount == STATS_LONG_BLOCK_LEN) finishLongBlock(lw);
+}
+
+// Drops every finished block that starts before floorSeq and the older
+// samples of the block in progress (still in the ring).
+static void trimLong(LongWindow &lw) {
+  while (lw.held && lw.firstSeq[longOldest(lw)] < floorSeq) {
+    evictLongBlock(lw);
+  }
+  while (lw.partCount && lw.partSeq < floorSeq) {
+    uint16_t s = ringSlot(lw.partSeq);
+    lw.part.removeSample(ring.period_us[s], ring.bpm[s], ring.dBeat[s], ring.dBlock[s]);
+    lw.sums.removeSample(ring.period_us[s], ring.bpm[s], ring.dBeat[s], ring.dBlock[s]);
+    lw.partSeq++;
+    lw.partCount--;
+    if (lw.partCount) {
+      uint32_t jump = jumpAt(lw.partSeq);
+      lw.part.removeJump(jump);
+      lw.sums.removeJump(jump);
+    }
+  }
+}
+
+static void clearLong(LongWindow &lw) {
+  lw.period.clear();
+  lw.beat.clear();
+  lw.sums.reset();
+  lw.part.reset();
+  lw.stats = {0};
+  lw.partCount = 0;
+  lw.head = 0;
+  lw.held = 0;
+}
+
+static void refreshLong(LongWindow &lw) {
+  if (headSeq == floorSeq) {
+    lw.stats = {0};
+    return;
+  }
+  uint16_t s = ringSlot(headSeq - 1);
+  lw.stats = lw.sums.finalize(lw.sums.periodUs.n, ring.period_us[s], ring.bpm[s], ring.dBeat[s],
+                              ring.dBlock[s]);
+  lw.stats.median_period_us = lw.period.median();
+  lw.stats.mad_period_us    = lw.period.mad();
+  lw.stats.median_delta_beat= lw.beat.median();
+  lw.stats.mad_delta_beat   = lw.beat.mad();
+}
+
+// Whole blocks, at least two so there is always a finished one to sketch
+// from. Growing waits for new blocks; shrinking drops the oldest.
+static void applyLongSize(LongWindow &lw, uint16_t requested) {
+  const uint16_t limit = (uint16_t)STATS_LONG_BLOCKS * STATS_LONG_BLOCK_LEN;
+  if (requested > limit && requested != lw.requested) {
+    Display::scrollLog(F("Clamping statsLongWindow to 4096"));
+  }
+  lw.requested = requested;
+  uint16_t blocks = 0;
+  if (requested) {
+    blocks = (uint16_t)((requested + STATS_LONG_BLOCK_LEN - 1) / STATS_LONG_BLOCK_LEN);
+    if (blocks < 2) blocks = 2;
+    if (blocks > STATS_LONG_BLOCKS) blocks = STATS_LONG_BLOCKS;
+  }
+  if (blocks == lw.size) return;
+  lw.size = (uint8_t)blocks;
+  if (!blocks) {
+    clearLong(lw);
+    return;
+  }
+  while (lw.held && lw.held + (lw.partCount ? 1 : 0) > lw.size) {
+    evictLongBlock(lw);
+  }
+  refreshLong(lw);
+}
+#endif
+
+static void resetRobust() {
+  momPeriod.reset();
+  momBeat.reset();
+  momBpm.reset();
+  robustStats = {0};
+}
+
+static void configureRobust() {
+  uint8_t k = AnalysisTunables::momBlockLen;
+  uint8_t m = AnalysisTunables::momBlocks;
+  if (k == momPeriod.blockLen() && m == momPeriod.blockCount()) return;
+  momPeriod.configure(k, m);
+  momBeat.configure(k, m);
+  momBpm.configure(k, m);
+  robustStats = {0};
+}
+
+static void updateRobust(uint32_t period_us, float bpm_now, int32_t dBeat_units) {
+  momBeat.add((double)dBeat_units);
+  momBpm.add((double)bpm_now);
+  if (momPeriod.add((double)period_us)) {
+    robustStats.period_us  = momPeriod.median();
+    robustStats.delta_beat = momBeat.median();
+    robustStats.bpm        = momBpm.median();
+    robustStats.blocks     = momPeriod.blocks();
+    robustStats.ready      = momPeriod.ready();
+  }
+  robustStats.residual_us = robustStats.blocks ? (float)period_us - robustStats.period_us : 0.0f;
+}
+
+void resize() {
+  configureRobust();
+  shortWindow.order = &shortOrder;
+  shortWindow.timeLimited = true;
+  applySize(shortWindow, UnoTunables::statsWindowSize, STATS_SHORT_WINDOW_MAX,
+            F("Clamping statsWindowSize to 288"));
+#if ENABLE_LONG_WINDOW
+  applyLongSize(longWindow, AnalysisTunables::statsLongWindow);
+#endif
+}
 
 static uint32_t adjustedTicksToMicros(uint32_t ticks, int32_t corr_ppm) {
   uint64_t adjusted = ((uint64_t)ticks * (CORR_PPM_SCALE + (int64_t)corr_ppm)) / CORR_PPM_SCALE;
   return (uint32_t)((adjusted * 1000000ULL) / 16000000ULL);
 }
 
-static float stddev(double sum, double sumSq, uint16_t count) {
-  if (count == 0) return 0.0f;
-  double mean = sum / (double)count;
-  double variance = (sumSq / (double)count) - (mean * mean);
-  if (variance < 0.0) variance = 0.0;
-  return (float)std::sqrt(variance);
+// Start a new segment at `changeSeq`: older samples leave every window and
+// cannot be re-added by a resize, newer ones stay.
+static void segmentAt(uint32_t changeSeq) {
+  if (changeSeq > floorSeq) floorSeq = changeSeq;
+  StatsWindow &w = shortWindow;
+  while (w.count && w.tailSeq < floorSeq) {
+    evictOldest(w);
+  }
+  if (!w.count) w.tailSeq = headSeq;
+#if ENABLE_LONG_WINDOW
+  trimLong(longWindow);
+#endif
+  resetRobust();
+  periodCusum.reset();
+  beatCusum.reset();
 }
 
-void reset() {
-  uint16_t requestedWindow = UnoTunables::statsWindowSize;
-  lastRequestedWindow = requestedWindow;
-  window.capacity = requestedWindow;
-  if (window.capacity > MAX_WINDOW) {
-    if (requestedWindow != lastClampedRequest) {
-      Display::scrollLog(F("Clamping statsWindowSize to 288"));
-      lastClampedRequest = requestedWindow;
-    }
-    window.capacity = MAX_WINDOW;
+static void logChange(ChangeSeries series, int8_t dir, uint32_t age, float shift, float sigma) {
+  ChangeEvent &ev = changeLog[changeHead];
+  ev.swing_id = NanoComm::currentSwingId();
+  ev.change_swing_id = ev.swing_id - (age ? age - 1 : 0);
+  ev.ms = millis();
+  ev.shift = shift;
+  ev.sigma = sigma;
+  ev.series = series;
+  ev.direction = dir;
+  changeHead = (uint8_t)((changeHead + 1) % CHANGE_EVENT_LOG);
+  if (changeCount < CHANGE_EVENT_LOG) changeCount++;
+  changeTotal++;
+  if (series == CHANGE_BEAT) Display::scrollLog(F("Change point: beat"));
+  else Display::scrollLog(F("Change point: period"));
+}
+
+// Feeds the newest sample (sequence `seq`, already in the ring) to the
+// detectors and segments the windows if either fires.
+static void detectChange(uint32_t seq, uint32_t period_us, int32_t dBeat_units) {
+  if (!cusumConfigured) {
+    periodCusum.configure(CUSUM_K, CUSUM_H, CUSUM_WARMUP, 1.0f);
+    beatCusum.configure(CUSUM_K, CUSUM_H, CUSUM_WARMUP, 1.0f);
+    cusumConfigured = true;
   }
-  window.index = 0;
-  window.tail = 0;
-  window.count = 0;
-  window.stats = {0};
-  window.sums.reset();
+  int8_t dirP = periodCusum.add((double)period_us);
+  int8_t dirB = beatCusum.add((double)dBeat_units);
+  if (!dirP && !dirB) return;
+  const CusumDetector &d = dirP ? periodCusum : beatCusum;
+  uint32_t age = d.changeAge();
+  if (age > seq - floorSeq + 1) age = seq - floorSeq + 1;
+  logChange(dirP ? CHANGE_PERIOD : CHANGE_BEAT, dirP ? dirP : dirB, age, d.shift(), d.sigma());
+  segmentAt(seq + 1 - age);
+}
+
+// Drops the history of every window (the ring contents become unreachable).
+void reset() {
+  floorSeq = headSeq;
+  clearWindow(shortWindow);
+#if ENABLE_LONG_WINDOW
+  clearLong(longWindow);
+#endif
+  resetRobust();
+  periodCusum.reset();
+  beatCusum.reset();
+  resize();
 }
 
 void update() {
-  uint16_t requestedWindow = UnoTunables::statsWindowSize;
-  uint16_t desiredCapacity = requestedWindow > MAX_WINDOW ? MAX_WINDOW : requestedWindow;
-  if (window.capacity != desiredCapacity || requestedWindow != lastRequestedWindow) {
-    reset();
-  }
+  resize();
   unsigned long now = millis();
   PendulumSample sample;
   memcpy(&sample, &NanoComm::currentSample, sizeof(sample));
@@ -216,85 +599,126 @@ void update() {
   int32_t dBeat_units       = (int32_t)tick_units       - (int32_t)tock_units;
   int32_t dBlock_units      = (int32_t)tick_block_units - (int32_t)tock_block_units;
 
-  uint16_t cap = window.capacity;
-  bool hasPrevSample = window.count > 0;
-  uint32_t blockJumpMag = (uint32_t)std::abs(dBlock_units);
-  if (hasPrevSample && UnoTunables::blockJumpUs > 0) {
-    int32_t blockJump = 0;
-    switch (NanoComm::getDataUnits()) {
-      case DataUnits::RawCycles:
-        blockJump = (int32_t)(((uint64_t)UnoTunables::blockJumpUs * 16ULL * (CORR_PPM_SCALE + sample.corr_blend_ppm)) / CORR_PPM_SCALE);
-        break;
-      case DataUnits::AdjustedMs:
-        blockJump = UnoTunables::blockJumpUs / 1000;
-        if (blockJump == 0 && UnoTunables::blockJumpUs > 0) blockJump = 1; // avoid zero-threshold resets
-        break;
-      case DataUnits::AdjustedNs: blockJump = UnoTunables::blockJumpUs * 1000; break;
-      case DataUnits::AdjustedUs: default: blockJump = UnoTunables::blockJumpUs; break;
-    }
-    if (blockJumpMag > (uint32_t)blockJump) {
-      reset();
-      hasPrevSample = false;
-      blockJumpMag = 0;
-    }
+  // Make room in the short window before the slot holding the oldest ring
+  // entry is overwritten; it is at most STATS_RING_CAPACITY long.
+  StatsWindow &w = shortWindow;
+  while (w.count && w.count >= w.size) {
+    evictOldest(w);
   }
 
-  RollingSample &slot = window.samples[window.index];
-  slot.tick       = sample.tick;
-  slot.tock       = sample.tock;
-  slot.tick_block = sample.tick_block;
-  slot.tock_block = sample.tock_block;
-  slot.corr_blend_ppm = sample.corr_blend_ppm;
-  slot.timestamp_ms  = now;
-  slot.block_jump_mag = blockJumpMag;
-  slot.has_prev_block = hasPrevSample;
-
-  window.index = (window.index + 1) % cap;
-
-  window.sums.addSample(period_units, period_us, bpm_now, dBeat_units, dBlock_units, blockJumpMag, hasPrevSample);
-  if (window.count < cap) window.count++;
-
-  while (window.count && (now - window.samples[window.tail].timestamp_ms) > UnoTunables::rollingWindowMs) {
-    const RollingSample &old = window.samples[window.tail];
-    uint32_t oldTick = NanoComm::ticksToUnits(old.tick, old.corr_blend_ppm);
-    uint32_t oldTock = NanoComm::ticksToUnits(old.tock, old.corr_blend_ppm);
-    uint32_t oldPeriod = oldTick + oldTock;
-    int32_t  oldDBeat  = (int32_t)oldTick - (int32_t)oldTock;
-    uint32_t oldTickBlk = NanoComm::ticksToUnits(old.tick_block, old.corr_blend_ppm);
-    uint32_t oldTockBlk = NanoComm::ticksToUnits(old.tock_block, old.corr_blend_ppm);
-    int32_t  oldDBlk   = (int32_t)oldTickBlk - (int32_t)oldTockBlk;
-    oldPeriod      += oldTickBlk + oldTockBlk;
-    uint32_t oldPeriodUs = adjustedTicksToMicros(old.tick, old.corr_blend_ppm) +
-                           adjustedTicksToMicros(old.tock, old.corr_blend_ppm) +
-                           adjustedTicksToMicros(old.tick_block, old.corr_blend_ppm) +
-                           adjustedTicksToMicros(old.tock_block, old.corr_blend_ppm);
-    float oldBpm = unitsPerMinute(old.corr_blend_ppm) / (float)oldPeriod;
-    window.sums.removeSample(oldPeriod, oldPeriodUs, (double)oldBpm, oldDBeat, oldDBlk, old.block_jump_mag, old.has_prev_block);
-    window.tail = (window.tail + 1) % cap;
-    window.count--;
-    if (window.count) {
-      RollingSample &newHead = window.samples[window.tail];
-      if (newHead.has_prev_block) {
-        window.sums.removeOrphanedHead(newHead.block_jump_mag);
-        newHead.has_prev_block = false;
-        newHead.block_jump_mag = 0;
-      }
+  uint16_t slot = ringSlot(headSeq);
+  ring.period_us[slot]    = period_us;
+  ring.dBeat[slot]        = dBeat_units;
+  ring.dBlock[slot]       = dBlock_units;
+  ring.bpm[slot]          = bpm_now;
+  ring.timestamp_ms[slot] = now;
+  uint32_t seq = headSeq++;
+  detectChange(seq, period_us, dBeat_units);
+  updateRobust(period_us, bpm_now, dBeat_units);
+
+  if (w.size) {
+    pushHead(w, seq);
+    while (w.count && tooOld(w, w.tailSeq, now)) {
+      evictOldest(w);
     }
+    refreshStats(w);
   }
-
-  window.stats = window.sums.finalize(window.count, period_us, bpm_now, dBeat_units, dBlock_units, blockJumpMag);
+#if ENABLE_LONG_WINDOW
+  if (longWindow.size) {
+    pushLong(longWindow, seq);
+    refreshLong(longWindow);
+  }
+#endif
 }
 
 const RollingStats &get() {
-  return window.stats;
+  return shortWindow.stats;
+}
+
+const RollingStats &get(uint8_t window) {
+#if ENABLE_LONG_WINDOW
+  if (window == STATS_WINDOW_LONG) return longWindow.stats;
+#else
+  static const RollingStats none = {0};
+  if (window == STATS_WINDOW_LONG) return none;
+#endif
+  return shortWindow.stats;
+}
+
+uint8_t changeEventCount() {
+  return changeCount;
+}
+
+bool changeEvent(uint8_t i, ChangeEvent &out) {
+  if (i >= changeCount) return false;
+  out = changeLog[(uint8_t)((changeHead + CHANGE_EVENT_LOG - 1 - i) % CHANGE_EVENT_LOG)];
+  return true;
+}
+
+uint32_t changeEventsTotal() {
+  return changeTotal;
+}
+
+const CusumDetector &detector(ChangeSeries series) {
+  return series == CHANGE_BEAT ? beatCusum : periodCusum;
+}
+
+const RobustStats &robust() {
+  return robustStats;
+}
+
+float periodQuantileUs(float q) {
+  return shortOrder.period.quantile(q);
+}
+
+float deltaBeatQuantile(float q) {
+  return shortOrder.beat.quantile(q);
+}
+
+float periodQuantileUs(uint8_t window, float q) {
+#if ENABLE_LONG_WINDOW
+  if (window == STATS_WINDOW_LONG) return longWindow.period.quantile(q);
+#else
+  if (window == STATS_WINDOW_LONG) return 0.0f;
+#endif
+  return periodQuantileUs(q);
+}
+
+float deltaBeatQuantile(uint8_t window, float q) {
+#if ENABLE_LONG_WINDOW
+  if (window == STATS_WINDOW_LONG) return longWindow.beat.quantile(q);
+#else
+  if (window == STATS_WINDOW_LONG) return 0.0f;
+#endif
+  return deltaBeatQuantile(q);
 }
 
 uint16_t windowCount() {
-  return window.count;
+  return shortWindow.count;
 }
 
 uint16_t windowCapacityLimit() {
-  return window.capacity;
+  return shortWindow.size;
+}
+
+uint16_t windowCount(uint8_t window) {
+  switch (window) {
+    case STATS_WINDOW_SHORT: return shortWindow.count;
+#if ENABLE_LONG_WINDOW
+    case STATS_WINDOW_LONG:  return longWindow.sums.periodUs.n;
+#endif
+    default:                 return 0;
+  }
+}
+
+uint16_t windowCapacityLimit(uint8_t window) {
+  switch (window) {
+    case STATS_WINDOW_SHORT: return shortWindow.size;
+#if ENABLE_LONG_WINDOW
+    case STATS_WINDOW_LONG:  return (uint16_t)longWindow.size * STATS_LONG_BLOCK_LEN;
+#endif
+    default:                 return 0;
+  }
 }
 
 } // namespace StatsEngine
@@ -4,17 +4,6 @@
 #include "NanoComm.h"
 #include "PendulumProtocol.h"
 
-struct RollingSample {
-  uint32_t tick;        // raw ticks
-  uint32_t tock;        // raw ticks
-  uint32_t tick_block;  // raw ticks
-  uint32_t tock_block;  // raw ticks
-  uint32_t timestamp_ms;
-  int32_t  corr_blend_ppm; // blended correction for this sample
-  uint32_t block_jump_mag;
-  bool     has_prev_block;
-};
-
 struct RollingStats {
   float bpm;
   float delta_beat;
@@ -29,12 +18,69 @@ struct RollingStats {
   float stddev_delta_block;
   float stddev_block_jump;
   float stddev_period_us;
+  float median_period_us;
+  float mad_period_us;
+  float median_delta_beat;
+  float mad_delta_beat;
+};
+
+// Median of the last momBlocks block means of momBlockLen swings each. Robust
+// against the odd impulsive swing; used for the OLED headline BPM once ready.
+struct RobustStats {
+  float   bpm;
+  float   period_us;
+  float   delta_beat;
+  float   residual_us;    // latest period minus period_us
+  uint8_t blocks;         // completed blocks held (== momBlocks when ready)
+  bool    ready;
+};
+
+enum ChangeSeries : uint8_t {
+  CHANGE_PERIOD = 0,       // CUSUM on period_us
+  CHANGE_BEAT,             // CUSUM on beat error
+};
+
+struct ChangeEvent {
+  uint32_t swing_id;         // swing at which the change was detected
+  uint32_t change_swing_id;  // estimated first swing after the change
+  uint32_t ms;
+  float    shift;            // estimated step (period us / beat units)
+  float    sigma;            // segment sigma before the change
+  uint8_t  series;           // ChangeSeries
+  int8_t   direction;        // +1 up, -1 down
 };
 
+class CusumDetector;
+
 namespace StatsEngine {
+  // The short window (statsWindowSize, also bounded by rollingWindowMs) is a
+  // cursor over the shared sample ring and feeds the OLED and /stats; the
+  // long window (statsLongWindow, kept in blocks) is for stability trends.
+  constexpr uint8_t STATS_WINDOW_SHORT = 0;
+  constexpr uint8_t STATS_WINDOW_LONG  = 1;
+  constexpr uint8_t STATS_WINDOW_COUNT = 2;
+
   void reset();
+  // Re-reads the window size tunables; keeps history that is still in the ring.
+  void resize();
   void update();
   const RollingStats &get();
+  const RollingStats &get(uint8_t window);
+  const RobustStats &robust();
+  // Interpolated quantile (q in [0,1]) over the current window.
+  float periodQuantileUs(float q);
+  float deltaBeatQuantile(float q);
+  // Same over either window; the long window's come from its block sketches
+  // and are approximate (see Config.h).
+  float periodQuantileUs(uint8_t window, float q);
+  float deltaBeatQuantile(uint8_t window, float q);
   uint16_t windowCount();
   uint16_t windowCapacityLimit();
+  // Change points, newest first (i = 0). Total counts every event since boot.
+  uint8_t  changeEventCount();
+  bool     changeEvent(uint8_t i, ChangeEvent &out);
+  uint32_t changeEventsTotal();
+  const CusumDetector &detector(ChangeSeries series);   // CHANGE_PERIOD or CHANGE_BEAT
+  uint16_t windowCount(uint8_t window);
+  uint16_t windowCapacityLimit(uint8_t window);
 }
@@ -0,0 +1,176 @@
+#include "StatsLog.h"
+#include "NanoComm.h"
+#include "SDLogger.h"
+#include "StatsEngine.h"
+#include "WiFiConfig.h"
+
+#include <stdio.h>
+
+namespace StatsLog {
+
+static const char HEADER[] =
+  "stats_schema_version=2\r\n"
+  "uptime_ms,swing_id_last,pps_id_last,window_swings,window_ms,gps_state,pps_cycles_last_good,"
+  "period_mean_s,period_mad_s,period_std_s,count_locked,count_acquiring,count_holdover,"
+  "count_bad_jitter,count_no_pps,flags_or,sd_bytes,sd_write_max_us,sd_sync_max_us,sd_errors,"
+  "sd_backlog_bytes,temp_c,rh_pct,press_hpa";
+
+// Since the previous row
+static uint16_t gpsCounts[BAD_JITTER + 1];
+static uint16_t flagsOr = 0;
+static uint16_t swings = 0;
+
+static uint16_t lastDropped = 0;
+static bool     haveSample = false;
+static uint32_t lastDroppedRows = 0;
+static uint32_t lastSdBytes = 0;
+static uint32_t lastSdErrors = 0;
+static unsigned long lastRowMs = 0;
+
+static PendulumSample lastSample;
+static StatsRecordV1 record;
+static uint32_t rows = 0;
+
+void begin() {
+  SDLogger::setStatsHeader(HEADER);
+  lastRowMs = millis();
+}
+
+void update(const PendulumSample &sample) {
+  if (haveSample && sample.dropped_events != lastDropped) flagsOr |= STATS_FLAG_DROPPED;
+  lastDropped = sample.dropped_events;
+  haveSample = true;
+  if ((uint8_t)sample.gps_status <= BAD_JITTER) {
+    uint16_t &c = gpsCounts[sample.gps_status];
+    if (c < UINT16_MAX) c++;
+  }
+  if (swings < UINT16_MAX) swings++;
+  lastSample = sample;
+}
+
+// Growth of a counter since `last`; a counter reset by /sd.json counts from 0.
+static uint32_t since(uint32_t now, uint32_t &last) {
+  uint32_t d = now >= last ? now - last : now;
+  last = now;
+  return d;
+}
+
+// SD health since the previous row; starts the next health period.
+static void sdHealth(StatsRecordV1 &r) {
+  const SDLogger::SdHealth &h = SDLogger::health();
+  uint32_t errors = 0;
+  for (uint32_t e : h.errors) errors += e;
+  r.sd_bytes = since(h.bytes_written, lastSdBytes);
+  r.sd_errors = since(errors, lastSdErrors);
+  const uint32_t *m = h.period_max_us;
+  uint32_t write = m[(uint8_t)SDLogger::SdOp::Write], pad = m[(uint8_t)SDLogger::SdOp::Reserve];
+  uint32_t sync = m[(uint8_t)SDLogger::SdOp::Sync], close = m[(uint8_t)SDLogger::SdOp::Close];
+  r.sd_write_max_us = write > pad ? write : pad;
+  r.sd_sync_max_us = sync > close ? sync : close;
+  r.sd_backlog_bytes = SDLogger::writerStats().buffered_bytes;
+  SDLogger::startHealthPeriod();
+}
+
+// Host-side state, sampled when the row is built (after sdHealth()).
+static uint16_t hostFlags(const StatsRecordV1 &r) {
+  uint16_t f = 0;
+  if (!SDLogger::hasTimeSync()) f |= STATS_FLAG_TIME_INVALID;
+  uint32_t droppedRows = SDLogger::writerStats().dropped_rows;
+  if (r.sd_errors || droppedRows != lastDroppedRows) f |= STATS_FLAG_SD_ERROR;
+  lastDroppedRows = droppedRows;
+  if (!WiFiConfig::isApMode() && WiFi.status() != WL_CONNECTED) f |= STATS_FLAG_WIFI_DOWN;
+  return f;
+}
+
+static void snapshot(StatsRecordV1 &r) {
+  const RollingStats &rs = StatsEngine::get();
+  uint16_t n = StatsEngine::windowCount();
+  r.uptime_ms = millis();
+  r.swing_id_last = NanoComm::currentSwingId();
+  r.pps_id_last = 0;
+  r.window_swings = n;
+  r.gps_state = (uint8_t)lastSample.gps_status;
+  r.pps_cycles_last_good = 0;
+  if (n) {
+    r.window_ms = (uint32_t)(n * (double)rs.avg_period_us / 1000.0 + 0.5);
+    r.period_mean_s = rs.avg_period_us * 1e-6;
+    r.period_mad_s = rs.mad_period_us * 1e-6;
+    r.period_std_s = rs.stddev_period_us * 1e-6;
+  } else {
+    r.window_ms = 0;
+    r.period_mean_s = r.period_mad_s = r.period_std_s = 0.0;
+  }
+  r.count_no_pps = gpsCounts[NO_PPS];
+  r.count_acquiring = gpsCounts[ACQUIRING];
+  r.count_locked = gpsCounts[LOCKED];
+  r.count_holdover = gpsCounts[HOLDOVER];
+  r.count_bad_jitter = gpsCounts[BAD_JITTER];
+  sdHealth(r);
+  r.flags_or = flagsOr | hostFlags(r);
+  r.temp_c = lastSample.temperature_C;
+  r.rh_pct = lastSample.humidity_pct;
+  r.press_hpa = lastSample.pressure_hPa;
+}
+
+// ",value"; a missing reading prints "nan", as in the raw row, so the last
+// field of a whole row is never empty.
+static int envField(char *out, size_t len, float v) {
+  return snprintf(out, len, ",%.2f", v);
+}
+
+int formatRow(char *out, size_t len, const StatsRecordV1 &r) {
+  int n = snprintf(out, len,
+    "%lu,%lu,%lu,%lu,%lu,%u,%lu,%.9f,%.9f,%.9f,%u,%u,%u,%u,%u,%u,%lu,%lu,%lu,%lu,%u",
+    (unsigned long)r.uptime_ms,
+    (unsigned long)r.swing_id_last,
+    (unsigned long)r.pps_id_last,
+    (unsigned long)r.window_swings,
+    (unsigned long)r.window_ms,
+    (unsigned int)r.gps_state,
+    (unsigned long)r.pps_cycles_last_good,
+    r.period_mean_s,
+    r.period_mad_s,
+    r.period_std_s,
+    (unsigned int)r.count_locked,
+    (unsigned int)r.count_acquiring,
+    (unsigned int)r.count_holdover,
+    (unsigned int)r.count_bad_jitter,
+    (unsigned int)r.count_no_pps,
+    (unsigned int)r.flags_or,
+    (unsigned long)r.sd_bytes,
+    (unsigned long)r.sd_write_max_us,
+    (unsigned long)r.sd_sync_max_us,
+    (unsigned long)r.sd_errors,
+    (unsigned int)r.sd_backlog_bytes);
+  const float env[3] = { r.temp_c, r.rh_pct, r.press_hpa };
+  for (float v : env) {
+    if (n < 0 || (size_t)n >= len) return n;
+    n += envField(out + n, len - n, v);
+  }
+  if (n >= 0 && (size_t)n < len) n += snprintf(out + n, len - n, "\n");
+  return n;
+}
+
+void service() {
+  unsigned long now = millis();
+  if (now - lastRowMs < STATS_LOG_PERIOD_MS) return;
+  lastRowMs = now;
+  if (!swings) return;
+  snapshot(record);
+  if (SDLogger::isLogging()) {
+    char line[STATS_LOG_LINE_MAX];
+    int n = formatRow(line, sizeof(line), record);
+    if (n > 0 && (size_t)n < sizeof(line)) {
+      SDLogger::logStatsRow(line, (size_t)n);
+      rows++;
+    }
+  }
+  for (uint16_t &c : gpsCounts) c = 0;
+  flagsOr = 0;
+  swings = 0;
+}
+
+const StatsRecordV1 &last() { return record; }
+uint32_t rowsWritten() { return rows; }
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// StatsLog.h
+// Periodic StatsRecordV1 snapshots for the stats log (docs/core0/storage.md).
+//
+// Every STATS_LOG_PERIOD_MS a record is built from the rolling stats and
+// written as one CSV row through SDLogger::logStatsRow(), i.e. into the same
+// sector buffers as the raw log; it reaches the card with them and adds no
+// flush of its own. Nothing is written while no swing arrived in the period.
+//
+// Window fields describe the StatsEngine short window the period stats come
+// from (window_ms = swings x mean period). The gps_state counts and flags_or
+// cover the swings since the previous row. The UNO sees neither pps_id nor the
+// PPS scale, so those columns are 0. The SD health columns cover the card
+// operations since the previous row (SDLogger::health()); the backlog is what
+// sat in the write buffers when the row was built. The env tail is the last
+// sample's readings, "nan" when a sensor is missing; it stays last because
+// the recovery scan at open recognises a whole row by its %.2f (or nan)
+// last field, and an empty one could be a torn row. The SD columns came in
+// with stats_schema_version=2; v1 rows go from flags_or to the env tail.
+// -----------------------------------------------------------------------------
+
+#include "Config.h"
+#include "PendulumProtocol.h"
+
+// Record flag bits (docs/shared/interfaces.md appendix)
+constexpr uint16_t STATS_FLAG_DROPPED      = 1u << 0;   // Nano dropped events
+constexpr uint16_t STATS_FLAG_TIME_INVALID = 1u << 6;   // no NTP time yet
+constexpr uint16_t STATS_FLAG_SD_ERROR     = 1u << 7;   // write error or rows dropped
+constexpr uint16_t STATS_FLAG_WIFI_DOWN    = 1u << 8;   // STA not connected
+
+struct StatsRecordV1 {
+  uint32_t uptime_ms;
+  uint32_t swing_id_last;
+  uint32_t pps_id_last;            // 0: not available on the UNO
+  uint32_t window_swings;
+  uint32_t window_ms;
+  uint8_t  gps_state;              // GpsStatus of the last swing
+  uint32_t pps_cycles_last_good;   // 0: not available on the UNO
+  double   period_mean_s;
+  double   period_mad_s;
+  double   period_std_s;
+  uint16_t count_locked;
+  uint16_t count_acquiring;
+  uint16_t count_holdover;
+  uint16_t count_bad_jitter;
+  uint16_t count_no_pps;
+  uint16_t flags_or;
+  // SD health, since the previous row
+  uint32_t sd_bytes;               // bytes written to the card
+  uint32_t sd_write_max_us;        // slowest data or pad write
+  uint32_t sd_sync_max_us;         // slowest sync or close
+  uint32_t sd_errors;              // all SdError types
+  uint16_t sd_backlog_bytes;       // buffered, not yet on the card
+  // Env tail
+  float    temp_c;
+  float    rh_pct;
+  float    press_hpa;
+};
+
+namespace StatsLog {
+  void begin();                               // registers the stats header with SDLogger
+  void update(const PendulumSample &sample);  // once per swing, after StatsEngine::update()
+  void service();                             // from loop(); writes a row when due
+
+  const StatsRecordV1 &last();                // most recent snapshot
+  uint32_t rowsWritten();
+  int formatRow(char *out, size_t len, const StatsRecordV1 &r);   // CSV row, "\n" included
+}
@@ -0,0 +1,232 @@
+#include "SwingCodec.h"
+#include "BinLog.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+enum Field : uint8_t {
+  FIELD_SWING_ID = 0,
+  FIELD_TICK,
+  FIELD_TOCK,
+  FIELD_TICK_BLOCK,
+  FIELD_TOCK_BLOCK,
+  FIELD_CORR_INST,
+  FIELD_CORR_BLEND,
+  FIELD_GPS_STATUS,
+  FIELD_DROPPED,
+  FIELD_TEMP_X100,
+  FIELD_RH_X100,
+  FIELD_PRESS_X100,
+};
+static_assert(FIELD_PRESS_X100 + 1 == SWING_CODEC_FIELD_COUNT, "field table out of sync");
+
+inline uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1u);
+}
+
+inline size_t putVarint(uint8_t *out, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80u) {
+    out[n++] = (uint8_t)(v | 0x80u);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+// Returns bytes read, 0 if the buffer ends mid-varint, or SIZE_MAX if the
+// varint is longer than a uint32 allows.
+inline size_t getVarint(const uint8_t *in, size_t len, uint32_t &v) {
+  v = 0;
+  for (size_t i = 0; i < 5; ++i) {
+    if (i >= len) return 0;
+    uint8_t b = in[i];
+    v |= (uint32_t)(b & 0x7Fu) << (7 * i);
+    if (!(b & 0x80u)) return i + 1;
+  }
+  return SIZE_MAX;
+}
+
+inline int32_t envToX100(float v) {
+  if (isnan(v)) return SWING_CODEC_ENV_MISSING;
+  return (int32_t)lroundf(v * 100.0f);
+}
+
+inline float envFromX100(int32_t v) {
+  if (v == SWING_CODEC_ENV_MISSING) return NAN;
+  return (float)v / 100.0f;
+}
+
+void pack(uint32_t swing_id, const PendulumSample &s, uint32_t *f) {
+  f[FIELD_SWING_ID]   = swing_id;
+  f[FIELD_TICK]       = s.tick;
+  f[FIELD_TOCK]       = s.tock;
+  f[FIELD_TICK_BLOCK] = s.tick_block;
+  f[FIELD_TOCK_BLOCK] = s.tock_block;
+  f[FIELD_CORR_INST]  = (uint32_t)s.corr_inst_ppm;
+  f[FIELD_CORR_BLEND] = (uint32_t)s.corr_blend_ppm;
+  f[FIELD_GPS_STATUS] = (uint32_t)s.gps_status;
+  f[FIELD_DROPPED]    = s.dropped_events;
+  f[FIELD_TEMP_X100]  = (uint32_t)envToX100(s.temperature_C);
+  f[FIELD_RH_X100]    = (uint32_t)envToX100(s.humidity_pct);
+  f[FIELD_PRESS_X100] = (uint32_t)envToX100(s.pressure_hPa);
+}
+
+void unpack(const uint32_t *f, uint32_t &swing_id, PendulumSample &s) {
+  swing_id         = f[FIELD_SWING_ID];
+  s.tick           = f[FIELD_TICK];
+  s.tock           = f[FIELD_TOCK];
+  s.tick_block     = f[FIELD_TICK_BLOCK];
+  s.tock_block     = f[FIELD_TOCK_BLOCK];
+  s.corr_inst_ppm  = (int32_t)f[FIELD_CORR_INST];
+  s.corr_blend_ppm = (int32_t)f[FIELD_CORR_BLEND];
+  s.gps_status     = (GpsStatus)f[FIELD_GPS_STATUS];
+  s.dropped_events = (uint16_t)f[FIELD_DROPPED];
+  s.temperature_C  = envFromX100((int32_t)f[FIELD_TEMP_X100]);
+  s.humidity_pct   = envFromX100((int32_t)f[FIELD_RH_X100]);
+  s.pressure_hPa   = envFromX100((int32_t)f[FIELD_PRESS_X100]);
+}
+
+// swing_id is predicted to advance by one; every other field is predicted to
+// repeat. Deltas use wrap-safe unsigned subtraction reinterpreted as signed.
+inline uint32_t predict(const uint32_t *prev, uint8_t field) {
+  return field == FIELD_SWING_ID ? prev[field] + 1u : prev[field];
+}
+
+} // namespace
+
+SwingEncoder::SwingEncoder(uint16_t keyframeInterval)
+    : keyframeInterval_(keyframeInterval ? keyframeInterval : 1) {
+  reset();
+}
+
+void SwingEncoder::reset() {
+  memset(fields_, 0, sizeof(fields_));
+  sinceKeyframe_ = 0;
+  crc_ = 0;
+  havePrev_ = false;
+}
+
+size_t SwingEncoder::encode(uint32_t swing_id, const PendulumSample &s, uint8_t *out, size_t outLen) {
+  if (!out || outLen < SWING_CODEC_MAX_RECORD) return 0;
+
+  uint32_t cur[SWING_CODEC_FIELD_COUNT];
+  pack(swing_id, s, cur);
+
+  size_t n = 0;
+  if (!havePrev_ || sinceKeyframe_ >= keyframeInterval_) {
+    out[n++] = SWING_CODEC_TAG_KEY;
+    for (uint8_t i = 0; i < SWING_CODEC_FIELD_COUNT; ++i) {
+      n += putVarint(out + n, zigzag((int32_t)cur[i]));
+    }
+    crc_ = binLogCrc16(out, n);
+    out[n++] = (uint8_t)crc_;
+    out[n++] = (uint8_t)(crc_ >> 8);
+    sinceKeyframe_ = 1;
+  } else {
+    uint16_t mask = 0;
+    for (uint8_t i = 0; i < SWING_CODEC_FIELD_COUNT; ++i) {
+      if (cur[i] != predict(fields_, i)) mask |= (uint16_t)(1u << i);
+    }
+    out[n++] = SWING_CODEC_TAG_DELTA;
+    n += putVarint(out + n, mask);
+    for (uint8_t i = 0; i < SWING_CODEC_FIELD_COUNT; ++i) {
+      if (mask & (1u << i)) {
+        n += putVarint(out + n, zigzag((int32_t)(cur[i] - predict(fields_, i))));
+      }
+    }
+    crc_ = binLogCrc16(out, n, crc_);
+    out[n++] = (uint8_t)crc_;
+    sinceKeyframe_++;
+  }
+
+  memcpy(fields_, cur, sizeof(fields_));
+  havePrev_ = true;
+  return n;
+}
+
+SwingDecoder::SwingDecoder() {
+  reset();
+}
+
+void SwingDecoder::reset() {
+  memset(fields_, 0, sizeof(fields_));
+  crc_ = 0;
+  synced_ = false;
+}
+
+SwingCodecResult SwingDecoder::decode(const uint8_t *in, size_t inLen, size_t &consumed,
+                                      uint32_t &swing_id, PendulumSample &s) {
+  consumed = 0;
+  if (!in || inLen == 0) return SwingCodecResult::NeedMore;
+
+  uint8_t tag = in[0];
+  if (tag != SWING_CODEC_TAG_KEY && (!synced_ || tag != SWING_CODEC_TAG_DELTA)) {
+    // Hunt for the next keyframe tag; anything before it is unusable.
+    size_t skip = 1;
+    while (skip < inLen && in[skip] != SWING_CODEC_TAG_KEY) skip++;
+    consumed = skip;
+    synced_ = false;
+    return SwingCodecResult::Skipped;
+  }
+
+  uint32_t cur[SWING_CODEC_FIELD_COUNT];
+  size_t n = 1;
+  uint32_t v = 0;
+
+  if (tag == SWING_CODEC_TAG_KEY) {
+    for (uint8_t i = 0; i < SWING_CODEC_FIELD_COUNT; ++i) {
+      size_t used = getVarint(in + n, inLen - n, v);
+      if (used == 0) return SwingCodecResult::NeedMore;
+      if (used == SIZE_MAX) { synced_ = false; consumed = 1; return SwingCodecResult::Corrupt; }
+      cur[i] = (uint32_t)unzigzag(v);
+      n += used;
+    }
+  } else {
+    size_t used = getVarint(in + n, inLen - n, v);
+    if (used == 0) return SwingCodecResult::NeedMore;
+    if (used == SIZE_MAX || v >= (1u << SWING_CODEC_FIELD_COUNT)) {
+      synced_ = false;
+      consumed = 1;
+      return SwingCodecResult::Corrupt;
+    }
+    n += used;
+    uint16_t mask = (uint16_t)v;
+    for (uint8_t i = 0; i < SWING_CODEC_FIELD_COUNT; ++i) {
+      cur[i] = predict(fields_, i);
+      if (!(mask & (1u << i))) continue;
+      used = getVarint(in + n, inLen - n, v);
+      if (used == 0) return SwingCodecResult::NeedMore;
+      if (used == SIZE_MAX) { synced_ = false; consumed = 1; return SwingCodecResult::Corrupt; }
+      cur[i] += (uint32_t)unzigzag(v);
+      n += used;
+    }
+  }
+
+  // The check: a keyframe's own CRC-16, or the chained CRC's low byte.
+  bool key = tag == SWING_CODEC_TAG_KEY;
+  size_t checkLen = key ? 2 : 1;
+  if (inLen - n < checkLen) return SwingCodecResult::NeedMore;
+  uint16_t crc = binLogCrc16(in, n, key ? 0 : crc_);
+  bool ok = key ? (in[n] == (uint8_t)crc && in[n + 1] == (uint8_t)(crc >> 8))
+                : in[n] == (uint8_t)crc;
+  if (!ok) {
+    synced_ = false;
+    consumed = 1;
+    return SwingCodecResult::Corrupt;
+  }
+  n += checkLen;
+
+  memcpy(fields_, cur, sizeof(fields_));
+  crc_ = crc;
+  synced_ = true;
+  unpack(cur, swing_id, s);
+  consumed = n;
+  return SwingCodecResult::Ok;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+// -----------------------------------------------------------------------------
+// SwingCodec.h
+// Compact delta/varint encoding of per-swing records.
+//
+// Consecutive samples are highly redundant (ids increment, half-periods move by
+// a few hundred ticks, status fields rarely change), so each record is written
+// as zig-zag varint deltas against the previous record plus a bitmask of the
+// fields that differ from the prediction. Every `keyframeInterval` records a
+// keyframe carries absolute values so a reader can join mid-stream or recover
+// after a corrupted record.
+//
+// Every record ends in a check: a keyframe in the CRC-16 of its own bytes, a
+// delta frame in the low byte of a CRC-16 chained over every record since the
+// keyframe. A damaged or missing delta is caught at the next record, and a
+// keyframe tag value met inside payload bytes while resyncing is rejected.
+//
+// A library only for now: neither the Nano link nor the SD logger writes it.
+// tools/swingcodec.cpp encodes/decodes files with it and holds its tests.
+// Kept free of Arduino dependencies so host tools can share the same code.
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include "PendulumProtocol.h"
+
+constexpr uint8_t  SWING_CODEC_TAG_KEY       = 0xA5;  // keyframe: all fields absolute
+constexpr uint8_t  SWING_CODEC_TAG_DELTA     = 0x5A;  // delta frame: mask + changed fields
+constexpr uint16_t SWING_CODEC_KEYFRAME_INTERVAL = 64;
+constexpr size_t   SWING_CODEC_FIELD_COUNT   = 12;
+constexpr size_t   SWING_CODEC_MAX_RECORD    = 1 + 2 + SWING_CODEC_FIELD_COUNT * 5 + 2;
+
+// Environmental values are carried as hundredths (same resolution as the CSV
+// "%.2f" columns); this sentinel round-trips NaN for a missing sensor.
+constexpr int32_t  SWING_CODEC_ENV_MISSING   = INT32_MIN;
+
+enum class SwingCodecResult : uint8_t {
+  Ok = 0,     // one record decoded
+  NeedMore,   // buffer ends mid-record; retry with more bytes
+  Skipped,    // bytes discarded while waiting for a keyframe
+  Corrupt,    // malformed record or failed check; decoder drops sync until the next keyframe
+};
+
+class SwingEncoder {
+public:
+  explicit SwingEncoder(uint16_t keyframeInterval = SWING_CODEC_KEYFRAME_INTERVAL);
+
+  // Force the next record to be a keyframe (e.g. after opening a new file).
+  void reset();
+
+  // Encode one record into `out`. Returns bytes written, or 0 if `outLen` is
+  // smaller than SWING_CODEC_MAX_RECORD.
+  size_t encode(uint32_t swing_id, const PendulumSample &s, uint8_t *out, size_t outLen);
+
+private:
+  uint32_t fields_[SWING_CODEC_FIELD_COUNT];
+  uint16_t keyframeInterval_;
+  uint16_t sinceKeyframe_;
+  uint16_t crc_;            // chained over the records since the keyframe
+  bool     havePrev_;
+};
+
+class SwingDecoder {
+public:
+  SwingDecoder();
+
+  void reset();
+  bool synced() const { return synced_; }
+
+  // Decode the record at the start of `in`. `consumed` reports how many bytes
+  // were used (or skipped) and is valid for every result except NeedMore.
+  SwingCodecResult decode(const uint8_t *in, size_t inLen, size_t &consumed,
+                          uint32_t &swing_id, PendulumSample &s);
+
+private:
+  uint32_t fields_[SWING_CODEC_FIELD_COUNT];
+  uint16_t crc_;
+  bool     synced_;
+};
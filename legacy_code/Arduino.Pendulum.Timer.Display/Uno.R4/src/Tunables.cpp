@@ -14,7 +14,6 @@ namespace UnoTunables {
 
   uint16_t statsWindowSize      = DEFAULT_STATS_WINDOW;
   uint32_t rollingWindowMs      = DEFAULT_ROLLING_MS;
-  int32_t  blockJumpUs          = DEFAULT_BLOCK_JUMP_US;
 
   uint16_t minEdgeSepTicks      = MIN_EDGE_SEP_TICKS;
 
@@ -27,4 +26,15 @@ namespace UnoTunables {
   bool     logEnabled           = LOG_ENABLED_DEFAULT;
   bool     logAppend            = LOG_APPEND_DEFAULT;
   char     logBaseName[LOG_FILENAME_LEN] = LOG_FILENAME;
+  uint8_t  logFormat            = LOG_FORMAT_DEFAULT;
+  bool     logSizeRotate        = LOG_SIZE_ROTATE_DEFAULT;
+  uint8_t  logRotateMB          = LOG_ROTATE_MB_DEFAULT;
+}
+
+namespace AnalysisTunables {
+  uint16_t statsLongWindow      = DEFAULT_STATS_LONG_WINDOW;
+  uint8_t  momBlockLen          = MOM_BLOCK_LEN_DEFAULT;
+  uint8_t  momBlocks            = MOM_BLOCKS_DEFAULT;
+  uint32_t nominalPeriodUs      = 0;
+  uint16_t psdSegmentLen        = PSD_SEGMENT_LEN;
 }
@@ -0,0 +1,375 @@
+// -----------------------------------------------------------------------------
+// adev_test.cpp
+// Host validation of the Allan-family cascade (Uno.R4/src/AdevCascade.*).
+//
+// Build:  g++ -O2 -std=c++17 -I../Uno.R4/src adev_test.cpp ../Uno.R4/src/AdevCascade.cpp -o adev_test
+// Usage:  adev_test [seed]
+//
+// Three parts, each printing its numbers; the exit code is non-zero if any
+// check fails.
+//  1. The 1000-point test data set of NIST SP 1065 (Riley, Handbook of
+//     Frequency Stability Analysis), generated by its LCG. A brute-force
+//     reference must reproduce the published ADEV, overlapping ADEV, MDEV,
+//     TDEV, HDEV and overlapping HDEV at tau = 1, 10, 100 to their 7 digits,
+//     and the cascade's tau0 point must match the published tau = 1 values.
+//  2. 2^20 inputs with a frequency offset, linear drift and white FM, held
+//     as exact integers scaled by 2^-40: every cascade level against the
+//     exact statistic at the same evaluation points (this covers the
+//     decimation and the periodic rebase).
+//  3. Kasdin-Walter power-law noise, S_y(f) ~ f^alpha for alpha = 2 (white
+//     PM) .. -2 (random-walk FM), averaged over realizations. ADEV, MDEV and
+//     HDEV slopes must match the power law, and the levels must match the
+//     published asymptotes: AVAR = 3 sigma_x^2/m^2 (white PM), h0/(2 tau)
+//     (white FM), 2 ln2 h-1 (flicker FM), (2 pi^2/3) h-2 tau (random-walk
+//     FM), and MVAR/AVAR = 1/m, 0.5, 0.67, 0.82 for white PM, white FM,
+//     flicker FM, random-walk FM. A linear drift added to random-walk FM must
+//     leave HDEV unchanged.
+// -----------------------------------------------------------------------------
+
+#include "AdevCascade.h"
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef long double ld;
+typedef __int128 i128;
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    failures++;
+    printf("  FAIL: %s\n", what);
+  }
+}
+
+double relDiff(double got, double want) {
+  return want != 0.0 ? fabs(got - want) / fabs(want) : fabs(got);
+}
+
+// ---- 1. NIST SP 1065 1000-point test suite ----------------------------------
+
+// Brute-force statistics of fractional frequency data y[0..N-1], phase
+// x[0] = 0, x[i+1] = x[i] + y[i]. `stride` 1 is the overlapping estimator,
+// stride m the original non-overlapping one.
+struct Reference {
+  std::vector<ld> x;
+
+  explicit Reference(const std::vector<ld> &y) : x(y.size() + 1, 0.0L) {
+    for (size_t i = 0; i < y.size(); ++i) x[i + 1] = x[i] + y[i];
+  }
+
+  ld adev(size_t m, size_t stride) const {
+    ld sum = 0;
+    size_t n = 0;
+    for (size_t i = 0; i + 2 * m < x.size(); i += stride, ++n) {
+      ld d = x[i + 2 * m] - 2 * x[i + m] + x[i];
+      sum += d * d;
+    }
+    return sqrtl(sum / (2.0L * m * m * n));
+  }
+
+  ld hdev(size_t m, size_t stride) const {
+    ld sum = 0;
+    size_t n = 0;
+    for (size_t i = 0; i + 3 * m < x.size(); i += stride, ++n) {
+      ld d = x[i + 3 * m] - 3 * x[i + 2 * m] + 3 * x[i + m] - x[i];
+      sum += d * d;
+    }
+    return sqrtl(sum / (6.0L * m * m * n));
+  }
+
+  ld mdev(size_t m) const {
+    ld sum = 0;
+    size_t n = 0;
+    for (size_t j = 0; j + 3 * m <= x.size(); ++j, ++n) {
+      ld s = 0;
+      for (size_t i = j; i < j + m; ++i) s += x[i + 2 * m] - 2 * x[i + m] + x[i];
+      sum += s * s;
+    }
+    return sqrtl(sum / (2.0L * m * m * m * m * n));
+  }
+
+  ld tdev(size_t m) const { return (ld)m * mdev(m) / sqrtl(3.0L); }
+};
+
+void nbs1000() {
+  printf("NIST SP 1065 1000-point data set\n");
+  std::vector<ld> y;
+  uint64_t n = 1234567890;
+  y.push_back((ld)n / 2147483647.0L);
+  while (y.size() < 1000) {
+    n = (16807 * n) % 2147483647ull;
+    y.push_back((ld)n / 2147483647.0L);
+  }
+  Reference ref(y);
+
+  // Published values at tau = 1, 10, 100.
+  static const size_t taus[3] = {1, 10, 100};
+  static const double published[6][3] = {
+    {2.922319e-01, 9.965736e-02, 3.897804e-02},   // ADEV
+    {2.922319e-01, 9.159953e-02, 3.241343e-02},   // overlapping ADEV
+    {2.922319e-01, 6.172376e-02, 2.170921e-02},   // MDEV
+    {1.687202e-01, 3.563623e-01, 1.253382e+00},   // TDEV
+    {2.943883e-01, 1.052754e-01, 3.910861e-02},   // HDEV
+    {2.943883e-01, 9.581083e-02, 3.237638e-02},   // overlapping HDEV
+  };
+  static const char *names[6] = {"ADEV", "OADEV", "MDEV", "TDEV", "HDEV", "OHDEV"};
+  double worst = 0.0;
+  for (int t = 0; t < 3; ++t) {
+    size_t m = taus[t];
+    double got[6] = {(double)ref.adev(m, m), (double)ref.adev(m, 1), (double)ref.mdev(m),
+                     (double)ref.tdev(m), (double)ref.hdev(m, m), (double)ref.hdev(m, 1)};
+    for (int s = 0; s < 6; ++s) {
+      double e = relDiff(got[s], published[s][t]);
+      if (e > worst) worst = e;
+      if (e > 6e-7) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "reference %s tau=%zu %.6e", names[s], m, got[s]);
+        check(false, msg);
+      }
+    }
+  }
+  printf("  reference vs published (18 values): max rel diff %.1e\n", worst);
+
+  AdevCascade cascade;
+  for (ld v : y) cascade.add((double)v);
+  AdevPoint p;
+  cascade.point(0, 1.0f, p);
+  double got[4] = {p.adev, p.mdev, p.tdev_s, p.hdev};
+  double want[4] = {published[1][0], published[2][0], published[3][0], published[5][0]};
+  worst = 0.0;
+  for (int s = 0; s < 4; ++s) worst = fmax(worst, relDiff(got[s], want[s]));
+  printf("  cascade tau=1: ADEV %.6e MDEV %.6e TDEV %.6e HDEV %.6e, max rel diff %.1e\n",
+         got[0], got[1], got[2], got[3], worst);
+  check(worst < 1e-6, "cascade tau=1 vs published");
+}
+
+// ---- 2. Exact comparison at the cascade's evaluation points -----------------
+
+void exactLevels(uint32_t seed) {
+  const size_t N = 1u << 20;
+  const ld scale = ldexpl(1.0L, -40);
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<double> gauss(0.0, 1.0);
+  // Offset 2e-4, drift 1e-10 per input (2e-4 over the run), white FM 1e-6.
+  std::vector<i128> x(N + 1, 0), c(N + 1, 0);
+  AdevCascade cascade;
+  for (size_t i = 0; i < N; ++i) {
+    int64_t yi = (int64_t)llround(2e-4 * 0x1p40) + (int64_t)llround(1e-10 * 0x1p40 * (double)i) +
+                 (int64_t)llround(gauss(rng) * 1e-6 * 0x1p40);
+    cascade.add((double)yi * 0x1p-40);
+    x[i + 1] = x[i] + yi;
+    c[i + 1] = c[i] + x[i + 1];
+  }
+  // c[n] = x[1] + .. + x[n]; with x[0] = 0 it is also the inclusive sum.
+  printf("2^20 inputs, offset + drift + white FM, exact at the evaluation points\n");
+  double worst = 0.0;
+  for (uint8_t k = 0; k < ADEV_LEVELS; ++k) {
+    size_t m = (size_t)1 << k;
+    size_t stride = (size_t)1 << (k > ADEV_OVERLAP_SHIFT ? k - ADEV_OVERLAP_SHIFT : 0);
+    ld sumA = 0, sumH = 0, sumM = 0;
+    size_t nA = 0, nH = 0, nM = 0;
+    for (size_t n = stride; n <= N; n += stride) {
+      if (n >= 2 * m) {
+        ld d = (ld)(x[n] - 2 * x[n - m] + x[n - 2 * m]) * scale;
+        sumA += d * d;
+        nA++;
+      }
+      if (n >= 3 * m) {
+        ld d = (ld)(x[n] - 3 * x[n - m] + 3 * x[n - 2 * m] - x[n - 3 * m]) * scale;
+        sumH += d * d;
+        nH++;
+      }
+      if (n + 1 >= 3 * m) {   // first window x[0..3m-1], c before it is 0
+        i128 c3 = n >= 3 * m ? c[n - 3 * m] : 0;
+        ld s = (ld)(c[n] - 3 * c[n - m] + 3 * c[n - 2 * m] - c3) * scale;
+        sumM += s * s;
+        nM++;
+      }
+    }
+    ld mm = (ld)m;
+    double adev = (double)sqrtl(sumA / (2 * mm * mm * nA));
+    double hdev = (double)sqrtl(sumH / (6 * mm * mm * nH));
+    double mdev = (double)sqrtl(sumM / (2 * mm * mm * mm * mm * nM));
+    AdevPoint p;
+    cascade.point(k, 1.0f, p);
+    double e = fmax(relDiff(p.adev, adev), fmax(relDiff(p.hdev, hdev), relDiff(p.mdev, mdev)));
+    worst = fmax(worst, e);
+    printf("  m=%5zu  ADEV %.4e  HDEV %.4e  MDEV %.4e  rel diff %.1e\n", m, adev, hdev, mdev, e);
+    check(p.n == nA, "cascade ADEV count");
+  }
+  printf("  max rel diff %.1e\n", worst);
+  check(worst < 1e-6, "cascade vs exact");
+}
+
+// ---- 3. Power-law noise ------------------------------------------------------
+
+typedef std::complex<double> cd;
+
+void fft(std::vector<cd> &a, bool inverse) {
+  size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(a[i], a[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    double ang = 2 * M_PI / (double)len * (inverse ? 1 : -1);
+    cd wl(cos(ang), sin(ang));
+    for (size_t i = 0; i < n; i += len) {
+      cd w(1);
+      for (size_t j = 0; j < len / 2; ++j) {
+        cd u = a[i + j], v = a[i + j + len / 2] * w;
+        a[i + j] = u + v;
+        a[i + j + len / 2] = u - v;
+        w *= wl;
+      }
+    }
+  }
+  if (inverse)
+    for (cd &v : a) v /= (double)n;
+}
+
+// Kasdin & Walter (1992): unit white noise through the fractional
+// integrator with h_0 = 1, h_k = h_(k-1) (k - 1 - alpha/2) / k. Its spectrum
+// is 2 |2 sin(pi f)|^alpha, i.e. S_y = 2 f^alpha (2 pi)^alpha at low f
+// (tau0 = 1). alpha = 0 is white FM, -2 a random walk, 2 a differenced white
+// phase.
+std::vector<double> powerLaw(int alpha, size_t n, std::mt19937_64 &rng) {
+  std::normal_distribution<double> gauss(0.0, 1.0);
+  std::vector<cd> w(2 * n, 0.0), h(2 * n, 0.0);
+  h[0] = 1.0;
+  for (size_t k = 1; k < n; ++k) h[k] = h[k - 1] * ((double)k - 1.0 - alpha / 2.0) / (double)k;
+  for (size_t k = 0; k < n; ++k) w[k] = gauss(rng);
+  fft(w, false);
+  fft(h, false);
+  for (size_t k = 0; k < 2 * n; ++k) w[k] *= h[k];
+  fft(w, true);
+  std::vector<double> y(n);
+  for (size_t k = 0; k < n; ++k) y[k] = w[k].real();
+  return y;
+}
+
+struct Averages {
+  double avar[ADEV_LEVELS] = {0};
+  double hvar[ADEV_LEVELS] = {0};
+  double mvar[ADEV_LEVELS] = {0};
+};
+
+Averages average(int alpha, size_t n, int runs, double drift, std::mt19937_64 &rng) {
+  Averages a;
+  for (int r = 0; r < runs; ++r) {
+    std::vector<double> y = powerLaw(alpha, n, rng);
+    AdevCascade cascade;
+    for (size_t i = 0; i < n; ++i) cascade.add(y[i] + drift * (double)i);
+    for (uint8_t k = 0; k < ADEV_LEVELS; ++k) {
+      AdevPoint p;
+      if (!cascade.point(k, 1.0f, p)) continue;
+      a.avar[k] += (double)p.adev * p.adev / runs;
+      a.hvar[k] += (double)p.hdev * p.hdev / runs;
+      a.mvar[k] += (double)p.mdev * p.mdev / runs;
+    }
+  }
+  return a;
+}
+
+// Least-squares slope of log(dev) against log(tau) over levels lo..hi.
+double slope(const double *var, int lo, int hi) {
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  int n = 0;
+  for (int k = lo; k <= hi; ++k, ++n) {
+    double lx = k * log(2.0), ly = 0.5 * log(var[k]);
+    sx += lx;
+    sy += ly;
+    sxx += lx * lx;
+    sxy += lx * ly;
+  }
+  return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+void powerLawNoise(uint32_t seed) {
+  const size_t N = 1u << 16;
+  const int RUNS = 32;
+  const int LO = 4, HI = 9;   // m = 16 .. 512
+  std::mt19937_64 rng(seed);
+  printf("Power-law noise, %d runs of %zu inputs, m = %d..%d\n", RUNS, N, 1 << LO, 1 << HI);
+
+  struct Case {
+    int alpha;
+    const char *name;
+    double adevSlope, mdevSlope;
+    double mvarRatio;               // published MVAR/AVAR at large m, 0 if none
+  };
+  static const Case cases[] = {
+    {2, "white PM", -1.0, -1.5, 0.0},
+    {1, "flicker PM", -1.0, -1.0, 0.0},
+    {0, "white FM", -0.5, -0.5, 0.5},
+    {-1, "flicker FM", 0.0, 0.0, 0.67},
+    {-2, "random-walk FM", 0.5, 0.5, 0.82},
+  };
+  for (const Case &cs : cases) {
+    Averages a = average(cs.alpha, N, RUNS, 0.0, rng);
+    double sa = slope(a.avar, LO, HI), sm = slope(a.mvar, LO, HI), sh = slope(a.hvar, LO, HI);
+    // Flicker PM is tau^-1 only up to a log term.
+    double tol = cs.alpha == 1 ? 0.12 : 0.06;
+    printf("  %-15s slopes ADEV %+.3f MDEV %+.3f HDEV %+.3f (expect %+.1f %+.1f %+.1f)\n", cs.name,
+           sa, sm, sh, cs.adevSlope, cs.mdevSlope, cs.adevSlope);
+    check(fabs(sa - cs.adevSlope) < tol, "ADEV slope");
+    check(fabs(sm - cs.mdevSlope) < tol, "MDEV slope");
+    check(fabs(sh - cs.adevSlope) < tol, "HDEV slope");
+
+    // Levels against the published asymptotes, using the generator's h_alpha.
+    double worstLevel = 0.0, worstRatio = 0.0;
+    for (int k = LO; k <= HI; ++k) {
+      double m = (double)(1u << k);
+      double want = 0.0;
+      switch (cs.alpha) {
+        case 2: want = 3.0 / (m * m); break;                 // sigma_x = 1
+        case 0: want = 2.0 / (2.0 * m); break;               // h0 = 2
+        case -1: want = 2.0 * log(2.0) / M_PI; break;        // h-1 = 1/pi
+        case -2: want = 2.0 * M_PI * M_PI / 3.0 / (2.0 * M_PI * M_PI) * m; break;   // h-2 = 1/(2 pi^2)
+        default: break;
+      }
+      if (want > 0.0) worstLevel = fmax(worstLevel, relDiff(sqrt(a.avar[k]), sqrt(want)));
+      double ratioWant = cs.alpha == 2 ? 1.0 / m : cs.mvarRatio;
+      if (ratioWant > 0.0) worstRatio = fmax(worstRatio, relDiff(a.mvar[k] / a.avar[k], ratioWant));
+    }
+    if (cs.alpha != 1) {
+      printf("  %-15s ADEV vs published level: max rel diff %.3f; MVAR/AVAR: %.3f\n", "", worstLevel,
+             worstRatio);
+      check(worstLevel < 0.05, "ADEV level");
+      check(worstRatio < 0.05, "MVAR/AVAR ratio");
+    }
+  }
+
+  // HDEV removes a linear frequency drift; ADEV does not.
+  std::mt19937_64 a(seed + 1), b(seed + 1);
+  Averages plain = average(-2, N, 4, 0.0, a);
+  Averages drift = average(-2, N, 4, 0.1, b);
+  double worst = 0.0;
+  for (int k = 0; k < ADEV_LEVELS; ++k) worst = fmax(worst, relDiff(drift.hvar[k], plain.hvar[k]));
+  double adevGrowth = sqrt(drift.avar[HI] / plain.avar[HI]);
+  printf("  random-walk FM + drift: HDEV rel change %.1e, ADEV at m=%d x%.2f\n", worst, 1 << HI,
+         adevGrowth);
+  check(worst < 1e-4, "HDEV drift immunity");
+  check(adevGrowth > 1.5, "drift visible in ADEV");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t seed = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 1;
+  nbs1000();
+  exactLevels(seed);
+  powerLawNoise(seed);
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
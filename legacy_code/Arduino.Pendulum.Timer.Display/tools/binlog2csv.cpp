@@ -0,0 +1,346 @@
+// -----------------------------------------------------------------------------
+// binlog2csv.cpp
+// Converts UNO binary raw logs (Uno.R4/src/BinLog.h) to the raw CSV schema,
+// byte-identical to what the logger writes in CSV mode.
+//
+// Build:  g++ -O2 -std=c++17 -pthread -I../Uno.R4/src binlog2csv.cpp -o binlog2csv
+// Usage:  binlog2csv [-j threads] [-i] input.bin [output.csv]
+//           -j  worker threads (default: hardware concurrency)
+//           -i  prepend a swing_id column
+//
+// The file is split into one slice per thread at sync markers; each slice is
+// decoded independently and the outputs are written in order. A block whose
+// sync marker does not match (count or CRC) is dropped and counted; after
+// damage the decoder scans forward to the next valid marker. The final block
+// of a file that was not closed cleanly has no marker and is kept unverified.
+// Trailing BINLOG_PAD_BYTE (the logger's reserve-ahead) is not data. Headers
+// after the first become "# resume ..." lines, as in a CSV log; a record whose
+// swing id is past the preceding sync marker's next_swing_id (swings the
+// logger had to drop) gets a "# gap ..." line before it.
+// -----------------------------------------------------------------------------
+
+#include "BinLog.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct SliceResult {
+  std::string csv;
+  uint64_t rows = 0;
+  uint64_t blocks = 0;
+  uint64_t badBlocks = 0;
+  uint64_t droppedRows = 0;
+  uint64_t unverifiedRows = 0;
+  uint64_t headers = 0;
+  uint64_t resyncs = 0;
+  uint64_t gaps = 0;
+  uint64_t gapRows = 0;
+};
+
+struct Input {
+  const uint8_t *data;
+  size_t size;
+  bool swingIdColumn;
+};
+
+uint32_t readU32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+bool validHeaderAt(const Input &in, size_t pos, BinLogFileHeader *out = nullptr) {
+  if (pos + sizeof(BinLogFileHeader) > in.size) return false;
+  BinLogFileHeader h;
+  memcpy(&h, in.data + pos, sizeof(h));
+  if (!binLogHeaderValid(h) || h.record_bytes != sizeof(BinSwingRecordV1) ||
+      h.header_bytes < sizeof(BinLogFileHeader) || pos + h.header_bytes > in.size) {
+    return false;
+  }
+  if (out) *out = h;
+  return true;
+}
+
+bool validSyncAt(const Input &in, size_t pos, BinLogSync *out = nullptr) {
+  if (pos + sizeof(BinLogSync) > in.size) return false;
+  BinLogSync s;
+  memcpy(&s, in.data + pos, sizeof(s));
+  if (!binLogSyncValid(s)) return false;
+  if (out) *out = s;
+  return true;
+}
+
+bool validMarkerAt(const Input &in, size_t pos) {
+  return validHeaderAt(in, pos) || validSyncAt(in, pos);
+}
+
+size_t findMarker(const Input &in, size_t pos, size_t end) {
+  for (; pos + 4 <= end; ++pos) {
+    uint32_t m = readU32(in.data + pos);
+    if ((m == BINLOG_FILE_MAGIC || m == BINLOG_SYNC_MAGIC) && validMarkerAt(in, pos)) return pos;
+  }
+  return end;
+}
+
+// A header inside the next record means the record was torn by a reset.
+size_t headerInside(const Input &in, size_t pos, size_t len) {
+  size_t stop = std::min(in.size, pos + len);
+  for (size_t p = pos + 1; p < stop && p + 4 <= in.size; ++p) {
+    if (readU32(in.data + p) == BINLOG_FILE_MAGIC && validHeaderAt(in, p)) return p;
+  }
+  return 0;
+}
+
+void appendHeaderLine(std::string &out, const BinLogFileHeader &h, bool swingIdColumn) {
+  char line[256];
+  rawLogCsvHeader(line, sizeof(line), (DataUnits)h.data_units);
+  if (swingIdColumn) out += "swing_id,";
+  out += line;
+  out += "\r\n";   // the logger writes the header with println()
+}
+
+// A header after the first resumes the file: the logger's CSV marker line.
+void appendResumeLine(std::string &out, const BinLogFileHeader &h) {
+  char line[96];
+  rawLogResumeLine(line, sizeof(line), h.reset_reason, h.created_epoch, h.first_swing_id);
+  out += line;
+  out += "\r\n";
+}
+
+void appendRow(std::string &out, const BinSwingRecordV1 &r, bool swingIdColumn) {
+  char line[192];
+  PendulumSample s;
+  binLogUnpack(r, s);
+  if (swingIdColumn) {
+    FastFormat::Appender a(line, sizeof(line));
+    a.appendU32(r.swing_id);
+    a.append(',');
+    out.append(line, (size_t)a.finish());
+  }
+  int n = rawLogCsvRow(line, sizeof(line), s);
+  if (n > 0) out.append(line, (size_t)std::min<size_t>((size_t)n, sizeof(line) - 1));
+}
+
+// Decodes [begin, end). `begin` is a marker (or 0); a sync marker at `end`
+// still belongs to this slice's last block and is used to verify it.
+void decodeSlice(const Input &in, size_t begin, size_t end, uint16_t syncInterval,
+                 SliceResult &res) {
+  std::string pending;
+  uint16_t blockRecords = 0;
+  uint16_t blockCrc = 0;
+  bool synced = begin == 0 ? validHeaderAt(in, 0) : true;
+  size_t pos = begin;
+  bool haveNext = false;     // next_swing_id of the marker just passed
+  uint32_t nextSwing = 0;
+
+  auto commit = [&]() {
+    res.csv += pending;
+    res.rows += blockRecords;
+    pending.clear();
+    blockRecords = 0;
+    blockCrc = 0;
+  };
+  auto discard = [&]() {
+    if (blockRecords) {
+      res.badBlocks++;
+      res.droppedRows += blockRecords;
+    }
+    pending.clear();
+    blockRecords = 0;
+    blockCrc = 0;
+  };
+  auto closeWithSync = [&](const BinLogSync &s) {
+    if (s.records == blockRecords && s.block_crc16 == blockCrc) {
+      if (blockRecords) res.blocks++;
+      commit();
+    } else {
+      discard();
+    }
+  };
+
+  while (pos < end) {
+    if (!synced) {
+      discard();
+      pos = findMarker(in, pos, end);
+      if (pos >= end) break;
+      res.resyncs++;
+      synced = true;
+      // The block before the damage cannot be verified; skip the marker's check.
+      BinLogSync s;
+      if (validSyncAt(in, pos, &s)) {
+        haveNext = true;
+        nextSwing = s.next_swing_id;
+        pos += sizeof(BinLogSync);
+        continue;
+      }
+    }
+    BinLogFileHeader h;
+    BinLogSync s;
+    if (validHeaderAt(in, pos, &h)) {
+      // An unterminated block before a header was cut off by a reopen.
+      res.unverifiedRows += blockRecords;
+      commit();
+      if (pos == 0) appendHeaderLine(pending, h, in.swingIdColumn);
+      else appendResumeLine(pending, h);
+      res.csv += pending;
+      pending.clear();
+      res.headers++;
+      haveNext = false;
+      syncInterval = h.sync_interval;
+      pos += h.header_bytes;
+      continue;
+    }
+    if (validSyncAt(in, pos, &s)) {
+      closeWithSync(s);
+      haveNext = true;
+      nextSwing = s.next_swing_id;
+      pos += sizeof(BinLogSync);
+      continue;
+    }
+    if (blockRecords >= syncInterval) {   // expected a marker here
+      synced = false;
+      continue;
+    }
+    if (pos + sizeof(BinSwingRecordV1) > in.size) break;   // torn tail
+    size_t torn = headerInside(in, pos, sizeof(BinSwingRecordV1));
+    if (torn) {
+      pos = torn;
+      continue;
+    }
+    BinSwingRecordV1 r;
+    memcpy(&r, in.data + pos, sizeof(r));
+    if (haveNext && !blockRecords && r.swing_id > nextSwing) {
+      char line[96];
+      rawLogGapLine(line, sizeof(line), nextSwing, r.swing_id - 1);
+      res.csv += line;
+      res.csv += "\r\n";
+      res.gaps++;
+      res.gapRows += r.swing_id - nextSwing;
+    }
+    haveNext = false;
+    appendRow(pending, r, in.swingIdColumn);
+    blockCrc = binLogCrc16(&r, sizeof(r), blockCrc);
+    blockRecords++;
+    pos += sizeof(BinSwingRecordV1);
+  }
+
+  if (!blockRecords) return;
+  BinLogSync s;
+  if (synced && pos == end && end < in.size && validSyncAt(in, end, &s)) {
+    closeWithSync(s);
+  } else if (end >= in.size) {
+    res.unverifiedRows += blockRecords;
+    commit();
+  } else {
+    discard();
+  }
+}
+
+int usage() {
+  fprintf(stderr, "usage: binlog2csv [-j threads] [-i] input.bin [output.csv]\n");
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  bool swingIdColumn = false;
+  const char *inPath = nullptr;
+  const char *outPath = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threads = (unsigned)std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "-i") == 0) {
+      swingIdColumn = true;
+    } else if (!inPath) {
+      inPath = argv[i];
+    } else if (!outPath) {
+      outPath = argv[i];
+    } else {
+      return usage();
+    }
+  }
+  if (!inPath) return usage();
+
+  FILE *f = fopen(inPath, "rb");
+  if (!f) {
+    perror(inPath);
+    return 1;
+  }
+  std::vector<uint8_t> buf;
+  uint8_t chunk[1 << 16];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buf.insert(buf.end(), chunk, chunk + n);
+  fclose(f);
+
+  size_t size = buf.size();
+  while (size && buf[size - 1] == BINLOG_PAD_BYTE) --size;   // no record or marker ends in pad
+  Input in{buf.data(), size, swingIdColumn};
+  BinLogFileHeader first;
+  if (!validHeaderAt(in, 0, &first)) {
+    fprintf(stderr, "%s: no valid binary log header at offset 0 (schema %u expected)\n",
+            inPath, (unsigned)BINLOG_SCHEMA_VERSION);
+    return 1;
+  }
+  if (first.schema_version != BINLOG_SCHEMA_VERSION) {
+    fprintf(stderr, "%s: unsupported schema %u\n", inPath, (unsigned)first.schema_version);
+    return 1;
+  }
+
+  // Slice boundaries at the first valid marker after each nominal split.
+  const size_t minSlice = 1 << 20;
+  threads = (unsigned)std::min<size_t>(threads, std::max<size_t>(1, in.size / minSlice));
+  std::vector<size_t> bounds{0};
+  for (unsigned t = 1; t < threads; ++t) {
+    size_t b = findMarker(in, std::max(bounds.back() + 1, in.size * t / threads), in.size);
+    if (b >= in.size) break;
+    bounds.push_back(b);
+  }
+  bounds.push_back(in.size);
+
+  std::vector<SliceResult> results(bounds.size() - 1);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+    workers.emplace_back(decodeSlice, std::cref(in), bounds[i], bounds[i + 1],
+                         (uint16_t)first.sync_interval, std::ref(results[i]));
+  }
+  for (auto &w : workers) w.join();
+
+  FILE *out = outPath ? fopen(outPath, "wb") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 1;
+  }
+  SliceResult total;
+  for (const SliceResult &r : results) {
+    fwrite(r.csv.data(), 1, r.csv.size(), out);
+    total.rows += r.rows;
+    total.blocks += r.blocks;
+    total.badBlocks += r.badBlocks;
+    total.droppedRows += r.droppedRows;
+    total.unverifiedRows += r.unverifiedRows;
+    total.headers += r.headers;
+    total.resyncs += r.resyncs;
+    total.gaps += r.gaps;
+    total.gapRows += r.gapRows;
+  }
+  if (outPath) fclose(out);
+
+  fprintf(stderr,
+          "%s: firmware \"%.*s\", %lu rows (%lu unverified), %lu blocks ok, %lu bad "
+          "(%lu rows dropped), %lu headers, %lu resyncs, %lu gaps (%lu swings), %zu threads\n",
+          inPath, (int)BINLOG_FIRMWARE_LEN, first.firmware, (unsigned long)total.rows,
+          (unsigned long)total.unverifiedRows, (unsigned long)total.blocks,
+          (unsigned long)total.badBlocks, (unsigned long)total.droppedRows,
+          (unsigned long)total.headers, (unsigned long)total.resyncs, (unsigned long)total.gaps,
+          (unsigned long)total.gapRows, results.size());
+  return total.badBlocks ? 3 : 0;
+}
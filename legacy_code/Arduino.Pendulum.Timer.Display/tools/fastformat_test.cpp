@@ -0,0 +1,244 @@
+// -----------------------------------------------------------------------------
+// fastformat_test.cpp
+// Host test and benchmark of the printf-free row formatting
+// (Uno.R4/src/FastFormat.h) against the snprintf calls it replaced.
+//
+// Build:  g++ -O2 -std=c++17 -I../Uno.R4/src fastformat_test.cpp -o fastformat_test
+// Usage:  fastformat_test [stride]      (default 1: every float in range)
+//
+// The output must match glibc's snprintf byte for byte, return value
+// included:
+//  - "%.2f" for every float with 2^-27 <= |f| < 2^23, both signs (below that
+//    everything prints 0.00), and for every 61st bit pattern elsewhere:
+//    subnormals, the snprintf fallback from 2^23 up, inf and nan. A stride
+//    above 1 checks every stride-th float in range instead (quicker).
+//  - "%lu" and "%ld" for every integer below 2^24 with both signs, the
+//    powers of ten +-2, the 32-bit limits and 20M random values.
+//  - The UNO's raw CSV row (rawLogCsvRow) for 2M random samples, each into
+//    a buffer of random size 0..139, for the truncation contract.
+//  - The Nano's sample line, formatted the way SerialParser::sendSample()
+//    does, for 2M random samples and every DataUnits tag. The Nano keeps its
+//    own copy of FastFormat.h; the two must stay the same.
+// Then each row is timed both ways over 2M samples of realistic values.
+// The exit code is non-zero on any mismatch.
+// -----------------------------------------------------------------------------
+
+#include "BinLog.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+long failures = 0;
+
+void report(const char *what, const char *want, const char *got) {
+  if (failures++ < 10) printf("  %s: snprintf \"%s\", FastFormat \"%s\"\n", what, want, got);
+}
+
+void checkFloat(float f) {
+  char want[64], got[64];
+  int n = snprintf(want, sizeof(want), "%.2f", (double)f);
+  FastFormat::Appender a(got, sizeof(got));
+  a.appendFixed2(f);
+  if (a.finish() != n || strcmp(want, got) != 0) report("%.2f", want, got);
+}
+
+void checkU32(uint32_t v) {
+  char want[16], got[16];
+  snprintf(want, sizeof(want), "%lu", (unsigned long)v);
+  FastFormat::Appender a(got, sizeof(got));
+  a.appendU32(v);
+  a.finish();
+  if (strcmp(want, got) != 0) report("%lu", want, got);
+}
+
+void checkI32(int32_t v) {
+  char want[16], got[16];
+  snprintf(want, sizeof(want), "%ld", (long)v);
+  FastFormat::Appender a(got, sizeof(got));
+  a.appendI32(v);
+  a.finish();
+  if (strcmp(want, got) != 0) report("%ld", want, got);
+}
+
+int unoRowSnprintf(char *out, size_t len, const PendulumSample &s) {
+  return snprintf(out, len, "%lu,%lu,%lu,%lu,%ld,%ld,%u,%u,%.2f,%.2f,%.2f\n",
+                  (unsigned long)s.tick, (unsigned long)s.tock,
+                  (unsigned long)s.tick_block, (unsigned long)s.tock_block,
+                  (long)s.corr_inst_ppm, (long)s.corr_blend_ppm,
+                  (unsigned)s.gps_status, (unsigned)s.dropped_events,
+                  (double)s.temperature_C, (double)s.humidity_pct, (double)s.pressure_hPa);
+}
+
+// The Nano's DataUnits tags (Nano.Every/src/PendulumProtocol.h).
+const char *const NANO_TAGS[] = {"16Mhz", "nSec", "uSec", "mSec", "DAT"};
+
+int nanoLineSnprintf(char *out, size_t len, const char *tag, const PendulumSample &s) {
+  return snprintf(out, len, "%s,%lu,%lu,%lu,%lu,%ld,%ld,%u,%u\n", tag,
+                  (unsigned long)s.tick, (unsigned long)s.tock,
+                  (unsigned long)s.tick_block, (unsigned long)s.tock_block,
+                  (long)s.corr_inst_ppm, (long)s.corr_blend_ppm,
+                  (unsigned)s.gps_status, (unsigned)s.dropped_events);
+}
+
+// Mirrors SerialParser::sendSample() on the Nano.
+int nanoLine(char *out, size_t len, const char *tag, const PendulumSample &s) {
+  FastFormat::Appender a(out, len);
+  a.append(tag, strlen(tag));
+  a.append(',');
+  a.appendU32(s.tick);
+  a.append(',');
+  a.appendU32(s.tock);
+  a.append(',');
+  a.appendU32(s.tick_block);
+  a.append(',');
+  a.appendU32(s.tock_block);
+  a.append(',');
+  a.appendI32(s.corr_inst_ppm);
+  a.append(',');
+  a.appendI32(s.corr_blend_ppm);
+  a.append(',');
+  a.appendU32((uint32_t)s.gps_status);
+  a.append(',');
+  a.appendU32(s.dropped_events);
+  a.append('\n');
+  return a.finish();
+}
+
+PendulumSample randomSample(std::mt19937 &rng, bool nanPressure) {
+  PendulumSample s;
+  s.tick = rng();
+  s.tock = rng();
+  s.tick_block = rng() >> (rng() % 32);
+  s.tock_block = rng();
+  s.corr_inst_ppm = (int32_t)rng();
+  s.corr_blend_ppm = (int32_t)rng() >> (rng() % 31);
+  s.gps_status = (GpsStatus)(rng() % 4);
+  s.dropped_events = (uint16_t)rng();
+  uint32_t bits = rng();
+  memcpy(&s.temperature_C, &bits, sizeof(bits));
+  s.humidity_pct = (rng() % 10000) / 100.0f;
+  s.pressure_hPa = nanPressure ? NAN : 900 + (rng() % 20000) / 100.0f;
+  return s;
+}
+
+// Both buffers start as the same filler, so bytes past the terminator count too.
+void checkRows(const char *what, int (*ref)(char *, size_t, const PendulumSample &),
+               int (*fast)(char *, size_t, const PendulumSample &), std::mt19937 &rng) {
+  for (int k = 0; k < 2000000; ++k) {
+    PendulumSample s = randomSample(rng, k & 1);
+    size_t len = rng() % 140;
+    char want[256], got[256];
+    memset(want, 'x', sizeof(want));
+    memset(got, 'x', sizeof(got));
+    int nw = ref(want, len, s);
+    int ng = fast(got, len, s);
+    if (nw != ng || memcmp(want, got, sizeof(want)) != 0) {
+      want[sizeof(want) - 1] = got[sizeof(got) - 1] = 0;
+      report(what, want, got);
+    }
+  }
+}
+
+const char *nanoTag = NANO_TAGS[0];
+int nanoRef(char *out, size_t len, const PendulumSample &s) { return nanoLineSnprintf(out, len, nanoTag, s); }
+int nanoFast(char *out, size_t len, const PendulumSample &s) { return nanoLine(out, len, nanoTag, s); }
+
+template <typename F>
+double nsPerRow(const std::vector<PendulumSample> &v, int n, size_t &sink, F f) {
+  char buf[256];
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; ++i) sink += (size_t)f(buf, sizeof(buf), v[i & 4095]);
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t stride = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 1;
+  if (!stride) stride = 1;
+
+  uint64_t floats = 0;
+  for (uint64_t i = 0; i <= 0xFFFFFFFFull; ++i) {
+    uint32_t bits = (uint32_t)i;
+    uint32_t exp = (bits >> 23) & 0xFF;
+    bool inRange = exp >= 127 - 27 && exp < 127 + 23;
+    if (inRange ? i % stride : i % 61) continue;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    checkFloat(f);
+    floats++;
+  }
+  printf("%%.2f: %llu floats, %ld mismatches\n", (unsigned long long)floats, failures);
+
+  long before = failures;
+  for (uint32_t i = 0; i < (1u << 24); ++i) {
+    checkU32(i);
+    checkI32((int32_t)i);
+    checkI32(-(int32_t)i);
+  }
+  for (uint32_t p = 1;; p *= 10) {
+    for (int d = -2; d <= 2; ++d) {
+      checkU32(p + d);
+      checkI32((int32_t)(p + d));
+      checkI32(-(int32_t)(p + d));
+    }
+    if (p > 429496729u) break;
+  }
+  checkU32(UINT32_MAX);
+  checkI32(INT32_MIN);
+  checkI32(INT32_MAX);
+  std::mt19937 ints(3);
+  for (int i = 0; i < 20000000; ++i) {
+    uint32_t v = ints();
+    checkU32(v);
+    checkI32((int32_t)v);
+  }
+  printf("%%lu/%%ld: %ld mismatches\n", failures - before);
+
+  before = failures;
+  std::mt19937 rows(1);
+  checkRows("UNO row", unoRowSnprintf, rawLogCsvRow, rows);
+  printf("UNO raw CSV rows: 2000000, %ld mismatches\n", failures - before);
+  before = failures;
+  for (const char *tag : NANO_TAGS) {
+    nanoTag = tag;
+    checkRows("Nano line", nanoRef, nanoFast, rows);
+  }
+  printf("Nano sample lines: 2000000 per tag, %ld mismatches\n", failures - before);
+
+  std::mt19937 rng(2);
+  std::vector<PendulumSample> v(4096);
+  for (PendulumSample &s : v) {
+    s.tick = 16000000 + rng() % 200000;
+    s.tock = s.tick + rng() % 1000;
+    s.tick_block = rng() % 300000;
+    s.tock_block = rng() % 300000;
+    s.corr_inst_ppm = (int32_t)(rng() % 2000000) - 1000000;
+    s.corr_blend_ppm = (int32_t)(rng() % 2000000) - 1000000;
+    s.gps_status = (GpsStatus)2;
+    s.dropped_events = 0;
+    s.temperature_C = 20 + (rng() % 1000) / 100.0f;
+    s.humidity_pct = 40 + (rng() % 2000) / 100.0f;
+    s.pressure_hPa = 1000 + (rng() % 3000) / 100.0f;
+  }
+  const int n = 2000000;
+  size_t sink = 0;
+  double unoRef = nsPerRow(v, n, sink, unoRowSnprintf);
+  double unoFast = nsPerRow(v, n, sink, rawLogCsvRow);
+  nanoTag = NANO_TAGS[0];
+  double nanoRefNs = nsPerRow(v, n, sink, nanoRef);
+  double nanoFastNs = nsPerRow(v, n, sink, nanoFast);
+  printf("UNO row:   snprintf %.0f ns, FastFormat %.0f ns (x%.1f)\n", unoRef, unoFast, unoRef / unoFast);
+  printf("Nano line: snprintf %.0f ns, FastFormat %.0f ns (x%.1f)  [%zu]\n", nanoRefNs, nanoFastNs,
+         nanoRefNs / nanoFastNs, sink);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
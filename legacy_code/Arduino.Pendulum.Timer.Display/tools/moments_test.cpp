@@ -0,0 +1,237 @@
+// -----------------------------------------------------------------------------
+// moments_test.cpp
+// Host test of the rolling stddev (Uno.R4/src/RunningMoments.h) against exact
+// recomputation.
+//
+// Build:  g++ -O2 -std=c++17 -I../Uno.R4/src moments_test.cpp -o moments_test
+// Usage:  moments_test [samples] [seed]      (default 10^8 samples)
+//
+// A synthetic period_us series around 2e6 us (white noise from 0.5 to 2000 us,
+// slow drift, steps of up to 50 ms, runs of identical values) and a beat-error
+// series around zero are fed through sliding windows of 30, 288, 512 and 4096
+// samples, the way StatsEngine adds and evicts them. After every sample each
+// window's stddev is compared with the exact value from integer sums kept
+// alongside (sum and sum of squares, 128-bit). The test fails if any error is
+// above 1e-9 of the exact stddev plus 1e-12 of the mean; the mean must match
+// the exact one to the last bit of a double. Whole groups merged in and
+// taken out must match the same samples added one by one. Two earlier double
+// forms run on the same windows for comparison: sumSq/n - mean^2, and a
+// Welford/West update with removal (which keeps the rounding a step leaves
+// behind).
+// -----------------------------------------------------------------------------
+
+#include "RunningMoments.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef __int128 i128;
+
+// The Welford/West form RunningMoments replaced.
+struct Welford {
+  uint64_t n = 0;
+  double mean = 0.0, m2 = 0.0;
+  void add(double x) {
+    n++;
+    double d = x - mean;
+    mean += d / (double)n;
+    m2 += d * (x - mean);
+  }
+  void remove(double x) {
+    if (n <= 1) {
+      *this = Welford();
+      return;
+    }
+    n--;
+    double d = x - mean;
+    mean -= d / (double)n;
+    m2 -= d * (x - mean);
+    if (m2 < 0.0) m2 = 0.0;
+  }
+};
+
+struct Window {
+  size_t size;
+  RunningMoments moments;
+  Welford welford;
+  int64_t sum = 0;
+  i128 sumSq = 0;
+  double naiveSum = 0.0, naiveSumSq = 0.0;
+  double maxErr = 0.0;        // |got - exact| / (exact + 1e-12 mean)
+  double worstAbs = 0.0;      // absolute error at maxErr
+  double maxNaiveErr = 0.0;
+  double maxWelfordErr = 0.0;
+  uint64_t meanMismatches = 0;
+  uint64_t checks = 0;
+};
+
+double relErr(double got, long double exact, long double scale) {
+  return scale > 0 ? (double)(fabsl((long double)got - exact) / scale) : 0.0;
+}
+
+struct Series {
+  const char *name;
+  std::vector<Window> windows;
+  std::vector<int64_t> history;   // ring of the last max-window samples
+  size_t head = 0;
+  uint64_t n = 0;
+};
+
+void feed(Series &s, int64_t x) {
+  size_t cap = s.history.size();
+  for (Window &w : s.windows) {
+    if (s.n >= w.size) {
+      int64_t old = s.history[(s.head + cap - w.size) % cap];
+      w.moments.remove(old);
+      w.welford.remove((double)old);
+      w.sum -= old;
+      w.sumSq -= (i128)old * old;
+      w.naiveSum -= (double)old;
+      w.naiveSumSq -= (double)old * (double)old;
+    }
+    w.moments.add(x);
+    w.welford.add((double)x);
+    w.sum += x;
+    w.sumSq += (i128)x * x;
+    w.naiveSum += (double)x;
+    w.naiveSumSq += (double)x * (double)x;
+
+    uint64_t count = s.n + 1 < w.size ? s.n + 1 : w.size;
+    // Exact: n^2 var = n sumSq - sum^2, all integers.
+    i128 num = (i128)count * w.sumSq - (i128)w.sum * w.sum;
+    long double exact = sqrtl((long double)num) / (long double)count;
+    long double mean = fabsl((long double)w.sum / (long double)count);
+    long double scale = exact + 1e-12L * mean;
+    double got = sqrt(w.moments.variance());
+    double err = relErr(got, exact, scale);
+    if (err > w.maxErr) {
+      w.maxErr = err;
+      w.worstAbs = (double)fabsl((long double)got - exact);
+    }
+    if (w.moments.n != count || w.moments.mean() != (double)w.sum / (double)count) w.meanMismatches++;
+    double nm = w.naiveSum / (double)count;
+    double nv = w.naiveSumSq / (double)count - nm * nm;
+    double nerr = relErr(nv > 0 ? sqrt(nv) : 0.0, exact, scale);
+    if (nerr > w.maxNaiveErr) w.maxNaiveErr = nerr;
+    double werr = relErr(sqrt(w.welford.m2 / (double)w.welford.n), exact, scale);
+    if (werr > w.maxWelfordErr) w.maxWelfordErr = werr;
+    w.checks++;
+  }
+  s.history[s.head] = x;
+  s.head = (s.head + 1) % cap;
+  s.n++;
+}
+
+Series makeSeries(const char *name) {
+  Series s;
+  s.name = name;
+  for (size_t size : {30, 288, 512, 4096}) {
+    Window w;
+    w.size = size;
+    s.windows.push_back(w);
+  }
+  s.history.assign(4096, 0);
+  return s;
+}
+
+// Largest inputs and longest window the header allows.
+bool edgeCases() {
+  bool ok = true;
+  const int64_t big = 0xFFFFFFFFll;
+  const int64_t values[][2] = {{0, big}, {-big, big}, {big, big - 1}, {-big, -big + 3}};
+  for (const auto &v : values) {
+    RunningMoments m;
+    int64_t sum = 0;
+    i128 sumSq = 0;
+    for (uint32_t i = 0; i < 65535; ++i) {
+      int64_t x = v[i % 2];
+      m.add(x);
+      sum += x;
+      sumSq += (i128)x * x;
+    }
+    i128 num = (i128)65535 * sumSq - (i128)sum * sum;
+    long double exact = (long double)num / (65535.0L * 65535.0L);
+    long double err = fabsl((long double)m.variance() - exact);
+    if (err > 1e-15L * exact + 1e-300L) ok = false;
+    for (uint32_t i = 0; i < 65534; ++i) m.remove(v[i % 2]);
+    if (m.n != 1 || m.variance() != 0.0 || m.mean() != (double)v[0]) ok = false;
+  }
+  // Groups merged and taken out whole match the samples added one by one.
+  RunningMoments direct, merged, group;
+  for (uint32_t i = 0; i < 65535; ++i) {
+    int64_t x = (i & 1) ? -big : big - (int64_t)(i % 7);
+    direct.add(x);
+    group.add(x);
+    if (group.n == 4096 || i == 65534) {
+      merged.add(group);
+      group.reset();
+    }
+  }
+  if (merged.n != direct.n || merged.sum != direct.sum || merged.sqLo != direct.sqLo ||
+      merged.sqHi != direct.sqHi)
+    ok = false;
+  for (uint32_t i = 0; i < 4096; ++i) group.add((i & 1) ? -big : big - (int64_t)(i % 7));
+  merged.remove(group);
+  for (uint32_t i = 0; i < 4096; ++i) direct.remove((i & 1) ? -big : big - (int64_t)(i % 7));
+  if (merged.n != direct.n || merged.variance() != direct.variance()) ok = false;
+  printf("edge cases (|x| up to 2^32-1, 65535 samples, merged groups): %s\n", ok ? "ok" : "FAIL");
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint64_t samples = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000000ull;
+  uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1;
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<double> gauss(0.0, 1.0);
+
+  Series period = makeSeries("period_us");
+  Series beat = makeSeries("delta_beat");
+  double base = 2000000.0;
+  double sigma = 50.0;
+  int64_t hold = 0;
+  uint64_t holdLeft = 0;
+  for (uint64_t i = 0; i < samples; ++i) {
+    if (i % 100000 == 0) {     // new regime
+      static const double sigmas[] = {0.5, 3.0, 50.0, 400.0, 2000.0};
+      sigma = sigmas[rng() % 5];
+    }
+    base += gauss(rng) * 0.05;
+    if (rng() % 200000 == 0) base += (double)((int64_t)(rng() % 100001) - 50000);
+    if (!holdLeft && rng() % 50000 == 0) {
+      holdLeft = 5000;
+      hold = (int64_t)llround(base);
+    }
+    int64_t p;
+    if (holdLeft) {
+      holdLeft--;
+      p = hold;
+    } else {
+      p = (int64_t)llround(base + gauss(rng) * sigma);
+    }
+    feed(period, p);
+    feed(beat, (int64_t)llround(gauss(rng) * sigma * 0.1));
+  }
+
+  bool ok = edgeCases();
+  for (Series *s : {&period, &beat}) {
+    for (const Window &w : s->windows) {
+      bool pass = w.maxErr <= 1e-9 && !w.meanMismatches;
+      ok = ok && pass;
+      printf("%-10s window %4zu: %llu checks, max error %.1e (abs %.1e), %llu mean mismatches; "
+             "sumSq form %.1e, Welford %.1e  %s\n",
+             s->name, w.size, (unsigned long long)w.checks, w.maxErr, w.worstAbs,
+             (unsigned long long)w.meanMismatches, w.maxNaiveErr, w.maxWelfordErr,
+             pass ? "ok" : "FAIL");
+    }
+  }
+  printf("%s: %llu samples, seed %lu\n", ok ? "ok" : "FAILED", (unsigned long long)samples,
+         (unsigned long)seed);
+  return ok ? 0 : 1;
+}
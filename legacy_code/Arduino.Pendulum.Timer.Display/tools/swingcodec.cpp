@@ -0,0 +1,507 @@
+// -----------------------------------------------------------------------------
+// swingcodec.cpp
+// Host encoder/decoder for the compact swing encoding (Uno.R4/src/SwingCodec.h),
+// with its round-trip property tests and a benchmark.
+//
+// Build:  g++ -O2 -std=c++17 -I../Uno.R4/src swingcodec.cpp ../Uno.R4/src/SwingCodec.cpp -o swingcodec
+// Usage:  swingcodec encode [-k interval] input.csv output.swc
+//         swingcodec decode input.swc [output.csv]
+//         swingcodec test [seed]
+//         swingcodec bench [records]
+//
+// encode reads a raw CSV log (as written by the logger or by binlog2csv, with
+// or without its -i swing_id column). Without the column, rows are numbered
+// from 1 and "# resume" / "# gap" lines set the next swing id. decode writes
+// one "swing_id,<raw CSV row>" line per record; rows match the logger's when
+// the env values have at most two decimals, which the logger's always do.
+//
+// test runs the property tests and exits non-zero on a failure:
+//   - random streams (realistic, full-range and NaN fields, keyframe interval
+//     1..200) decoded from randomly sized chunks equal what was encoded;
+//   - a decoder joining at any offset outputs nothing until a keyframe, then
+//     the exact records from there;
+//   - after a flipped bit or a cut-out byte run the decoder drops sync, loses
+//     only records up to the next keyframe and then resumes exactly.
+//   Damage the checks miss (a wrong record is output) is counted and must
+//   stay below 1% of the cases; delta frames carry only a 1-byte check.
+// bench encodes a day of synthetic swings (43200 records: 2 s period) and
+// reports bytes per record against CSV and the binary log, and throughput.
+// -----------------------------------------------------------------------------
+
+#include "BinLog.h"
+#include "SwingCodec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Record {
+  uint32_t id;
+  PendulumSample s;
+};
+
+// What a record reads back as: env values go through hundredths.
+float envRoundTrip(float v) {
+  if (std::isnan(v)) return NAN;
+  return (float)(int32_t)lroundf(v * 100.0f) / 100.0f;
+}
+
+bool sameFloat(float a, float b) {
+  return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+
+bool sameRecord(const Record &want, uint32_t id, const PendulumSample &s) {
+  const PendulumSample &w = want.s;
+  return want.id == id && w.tick == s.tick && w.tock == s.tock && w.tick_block == s.tick_block &&
+         w.tock_block == s.tock_block && w.corr_inst_ppm == s.corr_inst_ppm &&
+         w.corr_blend_ppm == s.corr_blend_ppm && w.gps_status == s.gps_status &&
+         w.dropped_events == s.dropped_events &&
+         sameFloat(envRoundTrip(w.temperature_C), s.temperature_C) &&
+         sameFloat(envRoundTrip(w.humidity_pct), s.humidity_pct) &&
+         sameFloat(envRoundTrip(w.pressure_hPa), s.pressure_hPa);
+}
+
+// ---- synthetic swings ------------------------------------------------------
+
+// A 2 s pendulum timed at 16 MHz: half-periods wander by a few hundred ticks,
+// the PPS correction drifts slowly, env sensors update every few swings.
+struct Pendulum {
+  std::mt19937 rng;
+  Record r{};
+  double temp = 21.0, rh = 45.0, press = 1013.0;
+
+  explicit Pendulum(uint32_t seed) : rng(seed) {
+    r.s.gps_status = LOCKED;
+    r.s.corr_blend_ppm = 1200;
+  }
+
+  int32_t noise(int32_t span) { return (int32_t)(rng() % (2 * span + 1)) - span; }
+
+  Record next() {
+    r.id++;
+    r.s.tick = 16000000u + (uint32_t)(2000 + noise(300));
+    r.s.tock = 16000000u + (uint32_t)(1800 + noise(300));
+    r.s.tick_block = 24000u + (uint32_t)noise(40);
+    r.s.tock_block = 23800u + (uint32_t)noise(40);
+    r.s.corr_inst_ppm = r.s.corr_blend_ppm + noise(150);
+    if (rng() % 16 == 0) r.s.corr_blend_ppm += noise(3);
+    if (rng() % 5000 == 0) r.s.gps_status = r.s.gps_status == LOCKED ? ACQUIRING : LOCKED;
+    if (rng() % 3000 == 0) r.s.dropped_events++;
+    if (rng() % 3 == 0) {
+      temp += noise(1) * 0.01;
+      rh += noise(2) * 0.01;
+      press += noise(3) * 0.01;
+    }
+    r.s.temperature_C = (float)(lround(temp * 100) / 100.0);
+    r.s.humidity_pct = (float)(lround(rh * 100) / 100.0);
+    r.s.pressure_hPa = (float)(lround(press * 100) / 100.0);
+    return r;
+  }
+};
+
+// Anything the fields can hold: ids that jump and wrap, extreme integers,
+// NaN and large env values.
+Record wildRecord(std::mt19937 &rng, uint32_t &id) {
+  static const uint32_t edges[] = {0u, 1u, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu};
+  auto pick = [&](void) {
+    return rng() % 4 == 0 ? edges[rng() % 5] : (uint32_t)rng() >> (rng() % 32);
+  };
+  auto env = [&](void) {
+    if (rng() % 8 == 0) return (float)NAN;
+    return (float)((int32_t)(rng() % 200000001) - 100000000) / 100.0f;
+  };
+  Record r{};
+  id = rng() % 4 == 0 ? pick() : id + 1;
+  r.id = id;
+  r.s.tick = pick();
+  r.s.tock = pick();
+  r.s.tick_block = pick();
+  r.s.tock_block = pick();
+  r.s.corr_inst_ppm = (int32_t)pick();
+  r.s.corr_blend_ppm = (int32_t)pick();
+  r.s.gps_status = (GpsStatus)(rng() % 4);
+  r.s.dropped_events = (uint16_t)rng();
+  r.s.temperature_C = env();
+  r.s.humidity_pct = env();
+  r.s.pressure_hPa = env();
+  return r;
+}
+
+std::vector<uint8_t> encodeAll(const std::vector<Record> &recs, uint16_t interval,
+                               std::vector<size_t> *starts = nullptr) {
+  SwingEncoder enc(interval);
+  std::vector<uint8_t> out;
+  uint8_t buf[SWING_CODEC_MAX_RECORD];
+  for (const Record &r : recs) {
+    if (starts) starts->push_back(out.size());
+    size_t n = enc.encode(r.id, r.s, buf, sizeof(buf));
+    out.insert(out.end(), buf, buf + n);
+  }
+  return out;
+}
+
+struct Decoded {
+  uint32_t id;
+  PendulumSample s;
+};
+
+// Feeds `in` to a decoder `chunkMax` bytes at a time (0: all at once), as a
+// reader of a serial port would.
+std::vector<Decoded> decodeAll(const uint8_t *in, size_t len, std::mt19937 *rng = nullptr,
+                               size_t chunkMax = 0) {
+  SwingDecoder dec;
+  std::vector<Decoded> out;
+  std::vector<uint8_t> pending;
+  size_t fed = 0;
+  while (true) {
+    size_t room = chunkMax && rng ? 1 + (*rng)() % chunkMax : len - fed;
+    size_t take = std::min(room, len - fed);
+    pending.insert(pending.end(), in + fed, in + fed + take);
+    fed += take;
+    size_t pos = 0;
+    while (pos < pending.size()) {
+      size_t used = 0;
+      Decoded d;
+      SwingCodecResult res = dec.decode(pending.data() + pos, pending.size() - pos, used, d.id, d.s);
+      if (res == SwingCodecResult::NeedMore) break;
+      if (res == SwingCodecResult::Ok) out.push_back(d);
+      pos += used;
+    }
+    pending.erase(pending.begin(), pending.begin() + pos);
+    if (fed == len) break;
+  }
+  return out;
+}
+
+// ---- test ------------------------------------------------------------------
+
+int failures = 0;
+
+void fail(const char *what, unsigned long a, unsigned long b) {
+  if (failures++ < 20) fprintf(stderr, "FAIL %s (%lu, %lu)\n", what, a, b);
+}
+
+void testRoundTrip(std::mt19937 &rng) {
+  unsigned long records = 0;
+  for (int stream = 0; stream < 400; ++stream) {
+    std::vector<Record> recs;
+    size_t n = 1 + rng() % 5000;
+    Pendulum p(rng());
+    uint32_t id = rng();
+    bool wild = stream % 2;
+    for (size_t i = 0; i < n; ++i) recs.push_back(wild ? wildRecord(rng, id) : p.next());
+    uint16_t interval = (uint16_t)(1 + rng() % 200);
+    std::vector<uint8_t> bytes = encodeAll(recs, interval);
+    std::vector<Decoded> got = decodeAll(bytes.data(), bytes.size(), &rng, 1 + rng() % 80);
+    if (got.size() != recs.size()) {
+      fail("round trip: record count", got.size(), recs.size());
+      continue;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (!sameRecord(recs[i], got[i].id, got[i].s)) fail("round trip: record", stream, i);
+    }
+    records += n;
+  }
+  printf("round trip: %lu records in 400 streams\n", records);
+}
+
+// Index of the first keyframe that starts at or after `pos`.
+size_t keyframeAtOrAfter(const std::vector<size_t> &starts, uint16_t interval, size_t pos) {
+  for (size_t i = 0; i < starts.size(); i += interval) {
+    if (starts[i] >= pos) return i;
+  }
+  return starts.size();
+}
+
+// Checks what a decoder made of a damaged stream. Records are matched by id
+// (the synthetic ids are unique). Any record that is not an exact copy, or is
+// out of order, is damage the check missed. Otherwise every record before
+// `damaged` and from `resumeAt` (the first keyframe after the damage) on must
+// be there.
+void checkDamaged(const std::vector<Record> &recs, const std::vector<Decoded> &got,
+                  size_t damaged, size_t resumeAt, unsigned long &undetected,
+                  unsigned long &lost) {
+  size_t j = 0;
+  size_t have = 0;
+  for (const Decoded &d : got) {
+    while (j < recs.size() && recs[j].id != d.id) ++j;
+    if (j == recs.size() || !sameRecord(recs[j], d.id, d.s)) {
+      undetected++;
+      return;
+    }
+    if (j < damaged || j >= resumeAt) have++;
+    ++j;
+  }
+  size_t want = damaged + (recs.size() - std::min(resumeAt, recs.size()));
+  if (have != want) fail("damage: records outside the damaged run missing", have, want);
+  lost += recs.size() - got.size();
+}
+
+void testJoinAndDamage(std::mt19937 &rng) {
+  const uint16_t interval = SWING_CODEC_KEYFRAME_INTERVAL;
+  unsigned long joins = 0, flips = 0, cuts = 0, undetected = 0, lost = 0;
+  for (int trial = 0; trial < 3000; ++trial) {
+    Pendulum p(rng());
+    std::vector<Record> recs;
+    for (int i = 0; i < 1000; ++i) recs.push_back(p.next());
+    std::vector<size_t> starts;
+    std::vector<uint8_t> bytes = encodeAll(recs, interval, &starts);
+    auto recordAt = [&](size_t pos) {
+      return (size_t)(std::upper_bound(starts.begin(), starts.end(), pos) - starts.begin()) - 1;
+    };
+
+    // Join mid-stream: nothing before the first whole keyframe.
+    size_t at = rng() % bytes.size();
+    std::vector<Decoded> got = decodeAll(bytes.data() + at, bytes.size() - at);
+    size_t k = keyframeAtOrAfter(starts, interval, at);
+    unsigned long ignored = 0;
+    checkDamaged(recs, got, 0, k, undetected, ignored);
+    joins++;
+
+    // Flip one bit.
+    std::vector<uint8_t> bad = bytes;
+    size_t pos = rng() % bad.size();
+    bad[pos] ^= (uint8_t)(1u << (rng() % 8));
+    got = decodeAll(bad.data(), bad.size());
+    checkDamaged(recs, got, recordAt(pos), keyframeAtOrAfter(starts, interval, pos + 1),
+                 undetected, lost);
+    flips++;
+
+    // Cut out a run of bytes.
+    size_t from = rng() % bytes.size();
+    size_t len = 1 + rng() % 40;
+    if (from + len > bytes.size()) len = bytes.size() - from;
+    bad.assign(bytes.begin(), bytes.begin() + from);
+    bad.insert(bad.end(), bytes.begin() + from + len, bytes.end());
+    got = decodeAll(bad.data(), bad.size());
+    checkDamaged(recs, got, recordAt(from), keyframeAtOrAfter(starts, interval, from + len),
+                 undetected, lost);
+    cuts++;
+  }
+  printf("join: %lu offsets; damage: %lu bit flips, %lu cuts; %lu undetected, "
+         "%.1f records lost per damage\n",
+         joins, flips, cuts, undetected, (double)lost / (double)(flips + cuts));
+  if (undetected * 100 >= joins + flips + cuts) {
+    fail("damage: undetected rate", undetected, joins + flips + cuts);
+  }
+}
+
+int runTests(uint32_t seed) {
+  std::mt19937 rng(seed);
+  testRoundTrip(rng);
+  testJoinAndDamage(rng);
+  printf("%s (seed %lu)\n", failures ? "FAILED" : "ok", (unsigned long)seed);
+  return failures ? 1 : 0;
+}
+
+// ---- bench -----------------------------------------------------------------
+
+int runBench(size_t count) {
+  Pendulum p(1);
+  std::vector<Record> recs;
+  for (size_t i = 0; i < count; ++i) recs.push_back(p.next());
+
+  size_t csvBytes = 0;
+  char line[192];
+  for (const Record &r : recs) csvBytes += (size_t)rawLogCsvRow(line, sizeof(line), r.s);
+  size_t binBytes = count * sizeof(BinSwingRecordV1) + (count / BINLOG_SYNC_INTERVAL) * sizeof(BinLogSync);
+
+  const int passes = 20;
+  std::vector<uint8_t> bytes;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < passes; ++i) bytes = encodeAll(recs, SWING_CODEC_KEYFRAME_INTERVAL);
+  auto t1 = std::chrono::steady_clock::now();
+  std::vector<Decoded> got;
+  for (int i = 0; i < passes; ++i) got = decodeAll(bytes.data(), bytes.size());
+  auto t2 = std::chrono::steady_clock::now();
+
+  bool exact = got.size() == recs.size();
+  for (size_t i = 0; exact && i < got.size(); ++i) exact = sameRecord(recs[i], got[i].id, got[i].s);
+  double encNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)(count * passes);
+  double decNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / (double)(count * passes);
+  printf("%zu records: %zu bytes, %.2f B/record (CSV %.1f B/record, x%.1f; binary log %.1f, x%.1f)\n",
+         count, bytes.size(), (double)bytes.size() / count, (double)csvBytes / count,
+         (double)csvBytes / bytes.size(), (double)binBytes / count, (double)binBytes / bytes.size());
+  printf("encode %.0f ns/record (%.0f MB/s out), decode %.0f ns/record, round trip %s\n",
+         encNs, (double)bytes.size() / count / encNs * 1e3, decNs, exact ? "exact" : "MISMATCH");
+  return exact ? 0 : 1;
+}
+
+// ---- files -----------------------------------------------------------------
+
+bool readFile(const char *path, std::vector<uint8_t> &buf) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  uint8_t chunk[1 << 16];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buf.insert(buf.end(), chunk, chunk + n);
+  fclose(f);
+  return true;
+}
+
+// "key=<n>" anywhere in a marker line.
+bool lineValue(const char *line, const char *key, uint32_t &v) {
+  const char *p = strstr(line, key);
+  if (!p) return false;
+  v = (uint32_t)strtoul(p + strlen(key), nullptr, 10);
+  return true;
+}
+
+bool parseRow(const char *line, bool idColumn, uint32_t &id, PendulumSample &s) {
+  char *p = const_cast<char *>(line);
+  char *end;
+  auto u32 = [&](uint32_t &v) {
+    v = (uint32_t)strtoul(p, &end, 10);
+    bool ok = end != p && (*end == ',' || *end == '\r' || *end == '\n' || !*end);
+    p = *end == ',' ? end + 1 : end;
+    return ok;
+  };
+  auto f32 = [&](float &v) {
+    v = strtof(p, &end);
+    bool ok = end != p;
+    p = *end == ',' ? end + 1 : end;
+    return ok;
+  };
+  uint32_t ci, cb, gps, dropped;
+  if (idColumn && !u32(id)) return false;
+  if (!u32(s.tick) || !u32(s.tock) || !u32(s.tick_block) || !u32(s.tock_block) || !u32(ci) ||
+      !u32(cb) || !u32(gps) || !u32(dropped) || !f32(s.temperature_C) || !f32(s.humidity_pct) ||
+      !f32(s.pressure_hPa)) {
+    return false;
+  }
+  s.corr_inst_ppm = (int32_t)ci;
+  s.corr_blend_ppm = (int32_t)cb;
+  s.gps_status = (GpsStatus)gps;
+  s.dropped_events = (uint16_t)dropped;
+  return true;
+}
+
+int encodeFile(const char *inPath, const char *outPath, uint16_t interval) {
+  FILE *in = fopen(inPath, "rb");
+  if (!in) {
+    perror(inPath);
+    return 1;
+  }
+  FILE *out = fopen(outPath, "wb");
+  if (!out) {
+    perror(outPath);
+    fclose(in);
+    return 1;
+  }
+  SwingEncoder enc(interval);
+  uint8_t buf[SWING_CODEC_MAX_RECORD];
+  char line[512];
+  uint32_t nextId = 1;
+  bool idColumn = false;
+  unsigned long rows = 0, skipped = 0, bytes = 0;
+  while (fgets(line, sizeof(line), in)) {
+    uint32_t v;
+    if (line[0] == '#') {
+      if (strncmp(line, "# resume", 8) == 0 && lineValue(line, "swing_id=", v)) nextId = v;
+      if (strncmp(line, "# gap", 5) == 0 && lineValue(line, "last_swing_id=", v)) nextId = v + 1;
+      continue;
+    }
+    if (strncmp(line, "swing_id,", 9) == 0) {
+      idColumn = true;
+      continue;
+    }
+    PendulumSample s{};
+    uint32_t id = nextId;
+    if (!parseRow(line, idColumn, id, s)) {
+      skipped++;    // the column header, blank padding, a torn row
+      continue;
+    }
+    nextId = id + 1;
+    size_t n = enc.encode(id, s, buf, sizeof(buf));
+    fwrite(buf, 1, n, out);
+    rows++;
+    bytes += n;
+  }
+  fclose(in);
+  fclose(out);
+  fprintf(stderr, "%s: %lu records, %lu bytes (%.2f B/record), %lu lines skipped\n", inPath, rows,
+          bytes, rows ? (double)bytes / rows : 0.0, skipped);
+  return 0;
+}
+
+int decodeFile(const char *inPath, const char *outPath) {
+  std::vector<uint8_t> buf;
+  if (!readFile(inPath, buf)) return 1;
+  FILE *out = outPath ? fopen(outPath, "wb") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 1;
+  }
+  SwingDecoder dec;
+  size_t pos = 0;
+  unsigned long rows = 0, corrupt = 0, skippedBytes = 0;
+  char line[192];
+  while (pos < buf.size()) {
+    size_t used = 0;
+    uint32_t id;
+    PendulumSample s;
+    SwingCodecResult res = dec.decode(buf.data() + pos, buf.size() - pos, used, id, s);
+    if (res == SwingCodecResult::NeedMore) break;    // a torn last record
+    if (res == SwingCodecResult::Ok) {
+      FastFormat::Appender a(line, sizeof(line));
+      a.appendU32(id);
+      a.append(',');
+      int n = a.finish();
+      fwrite(line, 1, (size_t)n, out);
+      n = rawLogCsvRow(line, sizeof(line), s);
+      fwrite(line, 1, (size_t)n, out);
+      rows++;
+    } else {
+      if (res == SwingCodecResult::Corrupt) corrupt++;
+      skippedBytes += used;
+    }
+    pos += used;
+  }
+  if (outPath) fclose(out);
+  fprintf(stderr, "%s: %lu records, %lu corrupt, %lu bytes skipped, %zu trailing\n", inPath, rows,
+          corrupt, skippedBytes, buf.size() - pos);
+  return corrupt ? 3 : 0;
+}
+
+int usage() {
+  fprintf(stderr,
+          "usage: swingcodec encode [-k interval] input.csv output.swc\n"
+          "       swingcodec decode input.swc [output.csv]\n"
+          "       swingcodec test [seed]\n"
+          "       swingcodec bench [records]\n");
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) return usage();
+  const char *cmd = argv[1];
+  if (strcmp(cmd, "test") == 0) return runTests(argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1);
+  if (strcmp(cmd, "bench") == 0) return runBench(argc > 2 ? (size_t)strtoul(argv[2], nullptr, 10) : 43200);
+  if (strcmp(cmd, "decode") == 0 && (argc == 3 || argc == 4)) {
+    return decodeFile(argv[2], argc == 4 ? argv[3] : nullptr);
+  }
+  if (strcmp(cmd, "encode") == 0) {
+    uint16_t interval = SWING_CODEC_KEYFRAME_INTERVAL;
+    int i = 2;
+    if (i + 1 < argc && strcmp(argv[i], "-k") == 0) {
+      interval = (uint16_t)atoi(argv[i + 1]);
+      i += 2;
+    }
+    if (argc - i != 2) return usage();
+    return encodeFile(argv[i], argv[i + 1], interval);
+  }
+  return usage();
+}
@@ -13,6 +13,7 @@
 #include "PendulumCore.h"
 #include "SerialParser.h"
 #include "AtomicUtils.h"
+#include "FastFormat.h"
 
 // === HELP REGISTRY & HANDLERS ==============================================
 namespace {
@@ -419,18 +420,29 @@ void sendSample(const PendulumSample &s) {
     printCsvHeader();
   }
 
-  int len = snprintf(lineBuf, CSV_LINE_MAX,
-    "%s,%lu,%lu,%lu,%lu,%ld,%ld,%u,%u\n",
-    dataUnitsTag(Tunables::dataUnits),
-    (unsigned long)s.tick,
-    (unsigned long)s.tock,
-    (unsigned long)s.tick_block,
-    (unsigned long)s.tock_block,
-    (long)s.corr_inst_ppm,
-    (long)s.corr_blend_ppm,
-    (unsigned int)s.gps_status,
-    (unsigned int)s.dropped_events);
-  queueCSVLine(lineBuf, len);
+  // Once per swing: the same text as
+  // "%s,%lu,%lu,%lu,%lu,%ld,%ld,%u,%u\n" without vfprintf's digit loop.
+  const char* tag = dataUnitsTag(Tunables::dataUnits);
+  FastFormat::Appender a(lineBuf, CSV_LINE_MAX);
+  a.append(tag, strlen(tag));
+  a.append(',');
+  a.appendU32(s.tick);
+  a.append(',');
+  a.appendU32(s.tock);
+  a.append(',');
+  a.appendU32(s.tick_block);
+  a.append(',');
+  a.appendU32(s.tock_block);
+  a.append(',');
+  a.appendI32(s.corr_inst_ppm);
+  a.append(',');
+  a.appendI32(s.corr_blend_ppm);
+  a.append(',');
+  a.appendU32((uint32_t)s.gps_status);
+  a.append(',');
+  a.appendU32(s.dropped_events);
+  a.append('\n');
+  queueCSVLine(lineBuf, a.finish());
 }
 
 void reportMetrics() {